@@ -1,9 +1,11 @@
 
 #include "audio/AudioEnumerator.hpp"
+#include "config/data/keys.hpp"
 
 #include <QCoreApplication>
 #include <QtDebug>
 
+#include <algorithm>
 #include <array>
 #include <cstring>
 
@@ -38,6 +40,21 @@ void logCallback(void *pUserData, ma_uint32 logLevel, const char* message) {
     }() << "[Miniaudio]" << msgFixed.c_str();
 }
 
+ma_bool32 enumerateCallback(
+    ma_context* pContext,
+    ma_device_type deviceType,
+    const ma_device_info* pInfo,
+    void* pUserData
+) {
+    Q_UNUSED(pContext)
+    if (deviceType == ma_device_type_playback) {
+        static_cast<AudioEnumerator::DeviceList*>(pUserData)->push_back(*pInfo);
+    }
+
+    return MA_TRUE;
+
+}
+
 }
 
 
@@ -45,7 +62,9 @@ AudioEnumerator::Context::Context(ma_backend backend) :
     mContext(),
     mInitialized(false),
     mBackend(backend),
-    mDevices()
+    mDevices(),
+    mPopulated(false),
+    mCached(false)
 {
 }
 
@@ -65,7 +84,6 @@ ma_backend AudioEnumerator::Context::backend() const {
 ma_context* AudioEnumerator::Context::get() {
     if (mContext == nullptr) {
         // lazy loading
-        mContext = std::make_shared<ma_context>();
         probe();
     }
 
@@ -124,11 +142,20 @@ int AudioEnumerator::Context::devices() const {
 // Probe all devices in the miniaudio context, updating ids and names
 //
 void AudioEnumerator::Context::probe() {
-    if (mContext == nullptr) {
-        get(); // get calls probe when allocating context
+    init();
+    if (!mInitialized) {
+        // no context, nothing to probe
         return;
     }
 
+    setDevices(AudioEnumerator::probe(mContext.get()), false);
+}
+
+void AudioEnumerator::Context::init() {
+    if (mContext == nullptr) {
+        mContext = std::make_shared<ma_context>();
+    }
+
     if (!mInitialized) {
         // context not initialized, attempt to do so and log error on failure
 
@@ -147,38 +174,27 @@ void AudioEnumerator::Context::probe() {
             qCritical().nospace() << "Failed to initialize audio backend '"
                                   << ma_get_backend_name(mBackend) << "': "
                                   << ma_result_description(result);
-            // no context, nothing to probe
-            return;
         }
 
     }
-
-    mDevices.clear();
-    auto result = ma_context_enumerate_devices(mContext.get(), enumerateCallback, this);
-
-    if (result != MA_SUCCESS) {
-        mDevices.clear();
-    }
 }
 
+bool AudioEnumerator::Context::isPopulated() const {
+    return mPopulated;
+}
 
-ma_bool32 AudioEnumerator::Context::enumerateCallback(
-    ma_context* pContext,
-    ma_device_type deviceType,
-    const ma_device_info* pInfo,
-    void* pUserData
-) {
-    Q_UNUSED(pContext)
-    if (deviceType == ma_device_type_playback) {
-        static_cast<Context*>(pUserData)->enumerate(pInfo);
-    }
-
-    return MA_TRUE;
+bool AudioEnumerator::Context::isCached() const {
+    return mCached;
+}
 
+AudioEnumerator::DeviceList const& AudioEnumerator::Context::deviceList() const {
+    return mDevices;
 }
 
-void AudioEnumerator::Context::enumerate(ma_device_info const* info) {
-    mDevices.push_back(*info);
+void AudioEnumerator::Context::setDevices(DeviceList &&devices, bool cached) {
+    mDevices = std::move(devices);
+    mPopulated = true;
+    mCached = cached;
 }
 
 
@@ -247,6 +263,100 @@ void AudioEnumerator::populate(int backend) {
     mContexts[backend].probe();
 }
 
+void AudioEnumerator::prepare(int backend) {
+    if (indexIsInvalid(backend)) {
+        return;
+    }
+
+    auto &ctx = mContexts[backend];
+    if (ctx.isPopulated()) {
+        ctx.init();
+    } else {
+        ctx.probe();
+    }
+}
+
+bool AudioEnumerator::isCached(int backend) const {
+    if (indexIsInvalid(backend)) {
+        return false;
+    }
+
+    return mContexts[backend].isCached();
+}
+
+AudioEnumerator::DeviceList AudioEnumerator::probe(ma_context *context) {
+    DeviceList devices;
+    auto result = ma_context_enumerate_devices(context, TU::enumerateCallback, &devices);
+    if (result != MA_SUCCESS) {
+        devices.clear();
+    }
+    return devices;
+}
+
+void AudioEnumerator::setDevices(int backend, DeviceList &&devices) {
+    if (indexIsInvalid(backend)) {
+        return;
+    }
+
+    mContexts[backend].setDevices(std::move(devices), false);
+}
+
+void AudioEnumerator::loadCache(QSettings &settings) {
+    settings.beginGroup(Keys::DeviceCache);
+    settings.beginGroup(Keys::Audio);
+
+    for (size_t i = 0; i < mContexts.size(); ++i) {
+        DeviceList devices;
+        auto const count = settings.beginReadArray(mBackendNames[(int)i]);
+        for (int j = 0; j < count; ++j) {
+            settings.setArrayIndex(j);
+            auto const id = settings.value(Keys::deviceId).toByteArray();
+            if (id.size() != sizeof(ma_device_id)) {
+                continue;
+            }
+            auto const name = settings.value(Keys::deviceName).toString().toUtf8();
+
+            ma_device_info info{};
+            std::memcpy(&info.id, id.constData(), sizeof(ma_device_id));
+            std::memcpy(info.name, name.constData(), std::min((size_t)name.size(), sizeof(info.name) - 1));
+            devices.push_back(info);
+        }
+        settings.endArray();
+
+        if (!devices.empty()) {
+            mContexts[i].setDevices(std::move(devices), true);
+        }
+    }
+
+    settings.endGroup();
+    settings.endGroup();
+}
+
+void AudioEnumerator::saveCache(QSettings &settings) const {
+    settings.beginGroup(Keys::DeviceCache);
+    settings.beginGroup(Keys::Audio);
+    settings.remove(QString());
+
+    for (size_t i = 0; i < mContexts.size(); ++i) {
+        auto const& ctx = mContexts[i];
+        if (!ctx.isPopulated()) {
+            continue;
+        }
+
+        auto const& devices = ctx.deviceList();
+        settings.beginWriteArray(mBackendNames[(int)i], (int)devices.size());
+        for (size_t j = 0; j < devices.size(); ++j) {
+            settings.setArrayIndex((int)j);
+            settings.setValue(Keys::deviceId, QByteArray(reinterpret_cast<const char*>(&devices[j].id), sizeof(ma_device_id)));
+            settings.setValue(Keys::deviceName, QString::fromUtf8(devices[j].name));
+        }
+        settings.endArray();
+    }
+
+    settings.endGroup();
+    settings.endGroup();
+}
+
 QVariant AudioEnumerator::serializeDevice(int backend, int device) const {
     if (indexIsInvalid(backend)) {
         return {};
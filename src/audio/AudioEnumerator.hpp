@@ -1,6 +1,7 @@
 
 #pragma once
 
+#include <QSettings>
 #include <QStringList>
 #include <QVariant>
 
@@ -17,6 +18,9 @@
 // Index 0 is known as the "default device". The actual device used is determined by the backend,
 // and for some backends, allows automatic stream routing.
 //
+// Probing devices can be slow, so device lists can be cached between sessions
+// and probed on a worker thread via probe() and setDevices().
+//
 class AudioEnumerator {
 
 public:
@@ -26,6 +30,8 @@ public:
         ma_device_id const* id;
     };
 
+    using DeviceList = std::vector<ma_device_info>;
+
     explicit AudioEnumerator();
 
 
@@ -63,6 +69,42 @@ public:
     //
     void populate(int backend);
 
+    //
+    // Initializes the given backend and populates its device list, using the
+    // cached list if one was loaded. Unlike populate, devices are only probed
+    // if the backend has no device list yet.
+    //
+    void prepare(int backend);
+
+    //
+    // Determines if the device list for the given backend came from the cache
+    // and has not been probed since.
+    //
+    bool isCached(int backend) const;
+
+    //
+    // Probes the playback devices of an initialized context. Thread-safe, so
+    // that devices can be probed on a worker thread. Give the result to
+    // setDevices from the enumerator's thread.
+    //
+    static DeviceList probe(ma_context *context);
+
+    //
+    // Sets the device list for the given backend, from the result of probe()
+    //
+    void setDevices(int backend, DeviceList &&devices);
+
+    //
+    // Loads the device lists cached by saveCache. Backends are not
+    // initialized until prepare is called.
+    //
+    void loadCache(QSettings &settings);
+
+    //
+    // Saves the device lists of all probed backends.
+    //
+    void saveCache(QSettings &settings) const;
+
     //
     // Serialize the device so that it can be uniquely identified. The
     // result of this function can be written to file using a QSettings.
@@ -116,10 +158,20 @@ private:
         //
         void probe();
 
-    private:
+        //
+        // Initializes the miniaudio context, if not already initialized
+        //
+        void init();
+
+        bool isPopulated() const;
+
+        bool isCached() const;
 
-        static ma_bool32 enumerateCallback(ma_context* pContext, ma_device_type deviceType, const ma_device_info* pInfo, void* pUserData);
-        void enumerate(ma_device_info const* info);
+        DeviceList const& deviceList() const;
+
+        void setDevices(DeviceList &&devices, bool cached);
+
+    private:
 
         // a pointer is used for lazy loading
         // this way we only initialize the backends when they are used
@@ -130,7 +182,11 @@ private:
         bool mInitialized;
         ma_backend const mBackend;
 
-        std::vector<ma_device_info> mDevices;
+        DeviceList mDevices;
+        // true if mDevices has been set, by probing or from the cache
+        bool mPopulated;
+        // true if mDevices was loaded from the cache
+        bool mCached;
 
     };
 
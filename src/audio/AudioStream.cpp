@@ -1,5 +1,7 @@
 
 #include "audio/AudioStream.hpp"
+#include "utils/Realtime.hpp"
+#include "utils/Trace.hpp"
 
 #include <QtDebug>
 
@@ -48,9 +50,12 @@ AudioStream::AudioStream(QObject *parent) :
     mBuffer(),
     mContext(),
     mDevice(),
+    mVirtualDevice(),
+    mVirtual(false),
     mPlaybackDelay(0),
     mUnderruns(0),
-    mDraining(false)
+    mDraining(false),
+    mDiscarding(false)
 {
 
 }
@@ -67,6 +72,10 @@ unsigned AudioStream::underruns() const {
     return mUnderruns.load();
 }
 
+size_t AudioStream::playbackDelay() const {
+    return mPlaybackDelay.load(std::memory_order_relaxed);
+}
+
 void AudioStream::resetUnderruns() {
     mUnderruns = 0;
 }
@@ -79,6 +88,14 @@ void AudioStream::setDraining(bool draining) {
     mDraining = draining;
 }
 
+void AudioStream::discardQueued() {
+    mDiscarding.store(true, std::memory_order_release);
+}
+
+bool AudioStream::isDiscarding() const {
+    return mDiscarding.load(std::memory_order_acquire);
+}
+
 AudioRingbuffer::Writer AudioStream::writer() {
     return mBuffer.writer();
 }
@@ -112,21 +129,46 @@ void AudioStream::open(AudioEnumerator::Device const& device, int samplerate, in
         return;
     }
 
+    mVirtual = false;
+    mEnabled = true;
+    if (running) {
+        start();
+    }
+}
+
+void AudioStream::openVirtual(VirtualAudioDevice::Config const& config, int samplerate, int latency) {
+    bool running = isRunning();
+
+    disable();
+
+    mBuffer.init((size_t)(latency * samplerate / 1000));
+    mVirtualDevice.init(config, samplerate, virtualDataCallback, this);
+
+    mVirtual = true;
     mEnabled = true;
     if (running) {
         start();
     }
 }
 
+VirtualAudioDevice const& AudioStream::virtualDevice() const {
+    return mVirtualDevice;
+}
+
 bool AudioStream::start() {
     if (isEnabled() && !isRunning()) {
         mBuffer.reset();
-        mPlaybackDelay = mBuffer.size();
+        mPlaybackDelay.store(mBuffer.size(), std::memory_order_relaxed);
         mDraining = false;
-        auto result = ma_device_start(mDevice.get());
-        if (result != MA_SUCCESS) {
-            handleError("failed to start device:", result);
-            return false;
+        mDiscarding = false;
+        if (mVirtual) {
+            mVirtualDevice.start();
+        } else {
+            auto result = ma_device_start(mDevice.get());
+            if (result != MA_SUCCESS) {
+                handleError("failed to start device:", result);
+                return false;
+            }
         }
         mRunning = true;
     }
@@ -138,6 +180,11 @@ bool AudioStream::stop() {
     if (isRunning()) {
         mRunning = false;
 
+        if (mVirtual) {
+            mVirtualDevice.stop();
+            return true;
+        }
+
         auto result = ma_device_stop(mDevice.get());
         if (result != MA_SUCCESS) {
             handleError("failed to stop device:", result);
@@ -152,7 +199,11 @@ void AudioStream::disable() {
     mRunning = false;
     if (mEnabled) {
         mEnabled = false;
-        mDevice.uninit();
+        if (mVirtual) {
+            mVirtualDevice.stop();
+        } else {
+            mDevice.uninit();
+        }
     }
 }
 
@@ -168,24 +219,43 @@ void AudioStream::deviceDataCallback(ma_device *device, void *out, const void *i
 }
 
 void AudioStream::handleData(float *out, size_t frames) {
+    TRACE_THREAD("Audio callback");
+    TRACE_ZONE("AudioStream::handleData");
+    Realtime::Scope realtime;
+
+    // the writer is waiting to write newer samples (a preview), drop what is
+    // queued along with any startup delay so they can be played sooner
+    bool const discarded = mDiscarding.load(std::memory_order_acquire);
+    if (discarded) {
+        mBuffer.reader().flush();
+        mPlaybackDelay.store(0, std::memory_order_relaxed);
+        mDiscarding.store(false, std::memory_order_release);
+    }
 
     // an entire buffer's worth of silence is played when the stream is started
     // this gives the us ample time to fill the buffer before playing from it.
     // Without this the output might be choppy at the start.
 
-    if (mPlaybackDelay) {
-        auto samples = std::min(mPlaybackDelay, frames);
+    if (auto const delay = mPlaybackDelay.load(std::memory_order_relaxed)) {
+        auto samples = std::min(delay, frames);
         frames -= samples;
         // miniaudio clears the output buffer before calling the callback
         // so just seek the output pointer
         out += samples * 2;
-        mPlaybackDelay -= samples;
+        mPlaybackDelay.store(delay - samples, std::memory_order_relaxed);
     }
 
     auto nread = mBuffer.reader().fullRead(out, frames);
-    if (nread < frames && !mDraining) {
+    // an empty buffer is expected right after discarding
+    if (nread < frames && !mDraining && !discarded) {
         ++mUnderruns;
+        TRACE_INSTANT("Underrun");
     }
+    TRACE_COUNTER("Queued frames", mBuffer.reader().availableRead());
+}
+
+void AudioStream::virtualDataCallback(void *userData, float *out, size_t frames) {
+    static_cast<AudioStream*>(userData)->handleData(out, frames);
 }
 
 void AudioStream::deviceStopCallback(ma_device *device) {
@@ -2,6 +2,7 @@
 
 #include "audio/AudioEnumerator.hpp"
 #include "audio/Ringbuffer.hpp"
+#include "audio/VirtualAudioDevice.hpp"
 
 #include "miniaudio.h"
 
@@ -11,8 +12,8 @@
 #include <cstddef>
 
 //
-// AudioStream class. Manages a miniaudio device and a playback buffer for
-// asynchronous sound output.
+// AudioStream class. Manages a miniaudio device, or a virtual device, and a
+// playback buffer for asynchronous sound output.
 //
 class AudioStream : public QObject {
 
@@ -51,6 +52,25 @@ public:
 
     void setDraining(bool draining);
 
+    //
+    // Requests the device callback to discard all samples queued in the
+    // buffer on its next invocation. The writer must not write to the buffer
+    // until isDiscarding() returns false, so that only the samples queued
+    // before the request are discarded. Called from the writer's thread.
+    //
+    void discardQueued();
+
+    //
+    // Determines if a discard requested by discardQueued() is pending.
+    //
+    bool isDiscarding() const;
+
+    //
+    // Gets the number of frames of silence still to be played before the
+    // buffer, since the stream was started. Can be called from any thread.
+    //
+    size_t playbackDelay() const;
+
     //
     // Resets the underrun counter to 0.
     //
@@ -66,6 +86,18 @@ public:
     //
     void open(AudioEnumerator::Device const& device, int samplerate, int latency);
 
+    //
+    // Same as open(), but opens a virtual device instead of a miniaudio one,
+    // see VirtualAudioDevice.
+    //
+    void openVirtual(VirtualAudioDevice::Config const& config, int samplerate, int latency);
+
+    //
+    // Gets the virtual device, for its capture and consumed frame count. Only
+    // used when opened with openVirtual().
+    //
+    VirtualAudioDevice const& virtualDevice() const;
+
     AudioRingbuffer::Writer writer();
 
     bool start();
@@ -83,6 +115,8 @@ private:
     static void deviceDataCallback(ma_device *device, void *out, const void *in, ma_uint32 frames);
     void handleData(float *out, size_t frames);
 
+    static void virtualDataCallback(void *userData, float *out, size_t frames);
+
     static void deviceStopCallback(ma_device *device);
     void handleStop();
 
@@ -115,10 +149,15 @@ private:
 
     std::shared_ptr<ma_context> mContext;
     MaDeviceWrapper mDevice;
-    size_t mPlaybackDelay;
+    VirtualAudioDevice mVirtualDevice;
+    // true if opened with openVirtual(), mVirtualDevice is used instead of mDevice
+    bool mVirtual;
+    // written by the device callback, read by playbackDelay()
+    std::atomic<size_t> mPlaybackDelay;
 
     std::atomic_uint mUnderruns;
     std::atomic_bool mDraining;
+    std::atomic_bool mDiscarding;
 
 };
 
@@ -0,0 +1,81 @@
+
+#include "audio/PlaybackTimeline.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+PlaybackTimeline::PlaybackTimeline() :
+    mWriter(),
+    mPublished()
+{
+}
+
+void PlaybackTimeline::rowStarted(int pattern, int row, uint64_t sample) {
+    mWriter.rows[mWriter.rowCount % HISTORY] = { sample, pattern, row };
+    ++mWriter.rowCount;
+}
+
+void PlaybackTimeline::reset() {
+    mWriter.rowCount = 0;
+    mPublished.store(mWriter);
+}
+
+void PlaybackTimeline::publish(uint64_t written, uint32_t buffered, Clock::time_point time, int samplerate, bool playing) {
+    mWriter.written = written;
+    mWriter.buffered = buffered;
+    mWriter.time = time.time_since_epoch().count();
+    mWriter.samplerate = samplerate;
+    mWriter.playing = playing;
+    mPublished.store(mWriter);
+}
+
+std::optional<PlaybackTimeline::Position> PlaybackTimeline::position(Clock::time_point time) const {
+    auto const snapshot = mPublished.load();
+    if (!snapshot.playing || snapshot.rowCount == 0 || snapshot.samplerate <= 0) {
+        return std::nullopt;
+    }
+
+    // the sample being heard at the given time, extrapolated from the last
+    // snapshot. It can't be ahead of what has been written.
+    auto const snapshotTime = Clock::time_point(Clock::duration(snapshot.time));
+    auto const elapsed = std::chrono::duration<double>(time - snapshotTime).count();
+    auto const heard = std::min(
+        (double)snapshot.written - snapshot.buffered + elapsed * snapshot.samplerate,
+        (double)snapshot.written
+    );
+
+    // newest to oldest, find the row that started at or before the sample
+    auto const count = std::min((size_t)snapshot.rowCount, HISTORY);
+    auto const at = [&snapshot](size_t age) -> RowStart const& {
+        return snapshot.rows[(snapshot.rowCount - 1 - age) % HISTORY];
+    };
+    for (size_t age = 0; age < count; ++age) {
+        auto const& start = at(age);
+        if ((double)start.sample > heard) {
+            continue;
+        }
+
+        // length of the row, estimated from the previous row for the newest
+        double length = 0.0;
+        if (age > 0) {
+            length = (double)(at(age - 1).sample - start.sample);
+        } else if (age + 1 < count) {
+            length = (double)(start.sample - at(age + 1).sample);
+        }
+
+        float fraction = 0.0f;
+        if (length > 0.0) {
+            fraction = (float)std::clamp((heard - start.sample) / length, 0.0, 1.0);
+        }
+        return Position{ start.pattern, start.row, fraction };
+    }
+
+    // older than the history
+    return std::nullopt;
+}
+
+PlaybackTimeline::Position PlaybackTimeline::quantize(Position pos, int grid) {
+    grid = std::max(1, grid);
+    auto const row = (int)std::lround((pos.row + pos.fraction) / grid) * grid;
+    return { pos.pattern, row, 0.0f };
+}
@@ -0,0 +1,103 @@
+
+#pragma once
+
+#include "utils/Seqlock.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+//
+// Maps points in time to the song position that was being heard at that
+// time, for recording notes where they were played.
+//
+// The render thread records the sample at which each row started, and
+// publishes how many samples it has written and how many are still waiting
+// in the playback buffer. The sample being heard at any time can then be
+// extrapolated and mapped back to a row, which compensates for the buffer's
+// latency and for any delay in the GUI thread.
+//
+class PlaybackTimeline {
+
+public:
+
+    using Clock = std::chrono::steady_clock;
+
+    // number of row starts kept
+    static constexpr size_t HISTORY = 32;
+
+    struct Position {
+        int pattern;
+        int row;
+        // progress through the row, 0.0 to 1.0
+        float fraction;
+    };
+
+    PlaybackTimeline();
+
+    // Render thread ==========================================================
+
+    //
+    // Records the start of a row, at the given sample (total samples written
+    // before the row).
+    //
+    void rowStarted(int pattern, int row, uint64_t sample);
+
+    //
+    // Forgets the recorded row starts, when playback starts again. Rows from
+    // the previous play are never mapped to, even if their samples are still
+    // being heard.
+    //
+    void reset();
+
+    //
+    // Publishes the row starts recorded so far along with the state of the
+    // playback buffer at the given time. Buffered includes any silence played
+    // before the buffer.
+    //
+    void publish(uint64_t written, uint32_t buffered, Clock::time_point time, int samplerate, bool playing);
+
+    // Any thread =============================================================
+
+    //
+    // Gets the position heard at the given time, or nullopt if music was not
+    // playing or the time is older than the history.
+    //
+    std::optional<Position> position(Clock::time_point time) const;
+
+    //
+    // Rounds the position to the nearest multiple of grid rows. The resulting
+    // row may be past the end of the pattern, in which case the note belongs
+    // to the start of the next pattern.
+    //
+    static Position quantize(Position pos, int grid);
+
+private:
+
+    struct RowStart {
+        uint64_t sample;
+        int pattern;
+        int row;
+    };
+
+    struct Snapshot {
+        std::array<RowStart, HISTORY> rows;
+        // total number of rows recorded, the newest is at (rowCount - 1) % HISTORY
+        uint32_t rowCount;
+        // total samples written to the playback buffer
+        uint64_t written;
+        // samples in the buffer that have not been played yet, including
+        // silence played before them
+        uint32_t buffered;
+        // time of the snapshot, as ticks since the clock's epoch
+        Clock::rep time;
+        int samplerate;
+        bool playing;
+    };
+
+    // writer's copy, only accessed with the render context locked
+    Snapshot mWriter;
+    Seqlock<Snapshot> mPublished;
+
+};
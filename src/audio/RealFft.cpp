@@ -0,0 +1,116 @@
+
+#include "audio/RealFft.hpp"
+
+#include <QtGlobal>
+
+#include <cmath>
+
+#define TU RealFftTU
+namespace TU {
+
+constexpr double PI = 3.14159265358979323846;
+
+}
+
+RealFft::RealFft(size_t size) :
+    mSize(size),
+    mBitReverse(size / 2),
+    mStageCos(size / 2 - 1),
+    mStageSin(size / 2 - 1),
+    mSplitCos(size / 2 + 1),
+    mSplitSin(size / 2 + 1),
+    mReal(size / 2),
+    mImag(size / 2)
+{
+    Q_ASSERT(size >= 4 && (size & (size - 1)) == 0);
+
+    auto const half = size / 2;
+
+    int bits = 0;
+    while (((size_t)1 << bits) < half) {
+        ++bits;
+    }
+    for (size_t i = 0; i < half; ++i) {
+        uint32_t reversed = 0;
+        for (int bit = 0; bit < bits; ++bit) {
+            if (i & ((size_t)1 << bit)) {
+                reversed |= 1u << (bits - 1 - bit);
+            }
+        }
+        mBitReverse[i] = reversed;
+    }
+
+    // stage with span h combines pairs h apart, using exp(-i*pi*k/h)
+    for (size_t h = 1; h < half; h *= 2) {
+        for (size_t k = 0; k < h; ++k) {
+            auto const angle = -TU::PI * k / h;
+            mStageCos[h - 1 + k] = (float)std::cos(angle);
+            mStageSin[h - 1 + k] = (float)std::sin(angle);
+        }
+    }
+
+    for (size_t k = 0; k <= half; ++k) {
+        auto const angle = -2.0 * TU::PI * k / size;
+        mSplitCos[k] = (float)std::cos(angle);
+        mSplitSin[k] = (float)std::sin(angle);
+    }
+}
+
+size_t RealFft::size() const {
+    return mSize;
+}
+
+size_t RealFft::bins() const {
+    return mSize / 2 + 1;
+}
+
+void RealFft::power(float const input[], float out[]) {
+    auto const half = mSize / 2;
+    auto const re = mReal.data();
+    auto const im = mImag.data();
+
+    // pack even/odd samples into complex values, in bit reversed order
+    for (size_t i = 0; i < half; ++i) {
+        auto const j = mBitReverse[i];
+        re[j] = input[i * 2];
+        im[j] = input[i * 2 + 1];
+    }
+
+    // butterflies
+    for (size_t h = 1; h < half; h *= 2) {
+        auto const wr = mStageCos.data() + (h - 1);
+        auto const wi = mStageSin.data() + (h - 1);
+        for (size_t block = 0; block < half; block += h * 2) {
+            auto const ar = re + block;
+            auto const ai = im + block;
+            auto const br = ar + h;
+            auto const bi = ai + h;
+            for (size_t k = 0; k < h; ++k) {
+                auto const tr = br[k] * wr[k] - bi[k] * wi[k];
+                auto const ti = br[k] * wi[k] + bi[k] * wr[k];
+                br[k] = ar[k] - tr;
+                bi[k] = ai[k] - ti;
+                ar[k] += tr;
+                ai[k] += ti;
+            }
+        }
+    }
+
+    // split Z into X: X[k] = E[k] + W^k * O[k], where
+    //   E[k] = (Z[k] + conj(Z[M-k])) / 2 is the transform of the even samples
+    //   O[k] = (Z[k] - conj(Z[M-k])) / 2i is the transform of the odd samples
+    // Z[M] = Z[0]
+    for (size_t k = 0; k <= half; ++k) {
+        auto const a = k == half ? 0 : k;
+        auto const b = k == 0 ? 0 : half - k;
+        auto const er = (re[a] + re[b]) * 0.5f;
+        auto const ei = (im[a] - im[b]) * 0.5f;
+        auto const or_ = (im[a] + im[b]) * 0.5f;
+        auto const oi = (re[b] - re[a]) * 0.5f;
+        auto const xr = er + or_ * mSplitCos[k] - oi * mSplitSin[k];
+        auto const xi = ei + or_ * mSplitSin[k] + oi * mSplitCos[k];
+        out[k] = xr * xr + xi * xi;
+    }
+}
+
+#undef TU
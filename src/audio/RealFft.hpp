@@ -0,0 +1,61 @@
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//
+// Radix-2 FFT of real input, for spectrum analysis.
+//
+// A real transform of size N is computed as a complex transform of size N/2
+// (even samples as the real part, odd samples as the imaginary part), which
+// is then split into the spectrum of the real input. Complex values are
+// stored as separate real and imaginary arrays, and the twiddle factors for
+// each butterfly stage are contiguous, so that the inner loops are plain
+// array arithmetic the compiler can vectorise.
+//
+// Not thread-safe, each thread needs its own instance.
+//
+class RealFft {
+
+public:
+
+    //
+    // Prepares a transform for the given size, which must be a power of two
+    // and at least 4.
+    //
+    explicit RealFft(size_t size);
+
+    size_t size() const;
+
+    //
+    // Number of bins in the spectrum, size() / 2 + 1 (DC to Nyquist)
+    //
+    size_t bins() const;
+
+    //
+    // Transforms size() samples and writes the power (squared magnitude) of
+    // each bin to out, which must have room for bins() values.
+    //
+    void power(float const input[], float out[]);
+
+private:
+
+    // size of the real transform
+    size_t mSize;
+
+    // bit reversed index for each element of the complex transform
+    std::vector<uint32_t> mBitReverse;
+    // twiddles for the butterfly stages, stage with span h starts at h - 1
+    std::vector<float> mStageCos;
+    std::vector<float> mStageSin;
+    // twiddles for splitting the complex transform, one for each bin
+    std::vector<float> mSplitCos;
+    std::vector<float> mSplitSin;
+
+    // the complex transform, in place
+    std::vector<float> mReal;
+    std::vector<float> mImag;
+
+};
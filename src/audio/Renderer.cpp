@@ -1,17 +1,37 @@
 
 #include "audio/Renderer.hpp"
 #include "core/StandardRates.hpp"
+#include "utils/Realtime.hpp"
+#include "utils/Trace.hpp"
 #include "utils/utils.hpp"
 
 #include "trackerboy/engine/ChannelControl.hpp"
 
+#include <QGuiApplication>
 #include <QMutexLocker>
+#include <QScreen>
 #include <QtDebug>
 
+#include <algorithm>
+#include <cmath>
+
 #include <ratio>
 
 //static auto LOG_PREFIX = "[Renderer]";
 
+#define TU RendererTU
+namespace TU {
+
+// time constant, in seconds, for a held peak to be released
+constexpr float PEAK_RELEASE = 0.3f;
+// time constant, in seconds, of the RMS average
+constexpr float RMS_WINDOW = 0.3f;
+
+// size, in frames, of the scratch buffer for dropping synthesized samples
+constexpr size_t DISCARD_FRAMES = 256;
+
+}
+
 
 // Renderer Notes
 //
@@ -38,11 +58,18 @@ Renderer::RenderContext::RenderContext(Module &mod) :
     previewChannel(trackerboy::ChType::ch1),
     state(State::stopped),
     stopCounter(0),
+    midiTarget{ PreviewTarget::none, 0, -1 },
     bufferSize(0),
+    lowLatencyPreview(true),
+    discardPending(false),
     watchdog(),
     lastPeriod(),
     periodTime(0),
-    writesSinceLastPeriod(0)
+    writesSinceLastPeriod(0),
+    samplesWritten(0),
+    levels{ 0.0f, 0.0f, 0.0f, 0.0f },
+    meanSquareLeft(0.0f),
+    meanSquareRight(0.0f)
 {
 }
 
@@ -56,14 +83,37 @@ Renderer::Renderer(Module &mod, QObject *parent) :
     mVisBuffer(),
     mOutputFlags(ChannelOutput::AllOn),
     mRenderStartTime(),
+    mFrame(),
+    mBufferStats(BufferStats{ 0, 0, 0, 0.0 }),
+    mLevels(Levels{ 0.0f, 0.0f, 0.0f, 0.0f }),
+    mTimeline(),
+    mStepping(false),
+    mSamplerate(0),
+    mVisualizersChanged(false),
+    mMidiNotes(),
+    mMidiEnabled(false),
+    mStreamEnabled(false),
+    mUiTimer(),
+    mUiFrameSequence(mFrame.sequence()),
+    mUiPlaying(false),
     mContext(mod)
 {
     mTimer->setCallback(timerCallback, this);
     mTimer->moveToThread(&mTimerThread);
+    // register the trace buffer before rendering, so that the first traced
+    // render does not allocate
+    connect(&mTimerThread, &QThread::started, mTimer, []() { Trace::setThreadName("Renderer"); },
+        Qt::DirectConnection);
     connect(&mTimerThread, &QThread::finished, mTimer, &FastTimer::deleteLater);
     mTimerThread.setObjectName(QStringLiteral("renderer timer thread"));
     mTimerThread.start();
 
+    // kept in sync with the synth by setConfig
+    mSamplerate.store(mContext.access()->synth.samplerate(), std::memory_order_relaxed);
+
+    mUiTimer.setTimerType(Qt::PreciseTimer);
+    connect(&mUiTimer, &QTimer::timeout, this, &Renderer::uiTick);
+
     connect(&mStream, &AudioStream::aborted, this,
         [this]() {
             auto handle = mContext.access();
@@ -107,16 +157,7 @@ unsigned Renderer::statUnderruns() const {
 }
 
 Renderer::BufferStats Renderer::statBuffer() {
-    auto handle = mContext.access();
-    // it is safe to access the writer since we have acquired access to mContext
-
-    auto const size = handle->bufferSize;
-    return {
-        (int)(size - mStream.writer().availableWrite()),
-        (int)size,
-        (int)handle->writesSinceLastPeriod,
-        std::chrono::duration<double, std::milli>{handle->periodTime}.count()
-    };
+    return mBufferStats.load();
 }
 
 long Renderer::statElapsed() const {
@@ -126,7 +167,15 @@ long Renderer::statElapsed() const {
 }
 
 int Renderer::samplerate() {
-    return mContext.access()->synth.samplerate();
+    return mSamplerate.load(std::memory_order_relaxed);
+}
+
+Renderer::Levels Renderer::levels() {
+    return mLevels.load();
+}
+
+PlaybackTimeline const& Renderer::timeline() const {
+    return mTimeline;
 }
 
 Guarded<VisualizerBuffer>& Renderer::visualizerBuffer() {
@@ -138,16 +187,15 @@ bool Renderer::isRunning() {
 }
 
 bool Renderer::isStepping() {
-    return mContext.access()->stepping;
+    return mStepping.load(std::memory_order_relaxed);
 }
 
 bool Renderer::isPlaying() {
-    return !mContext.access()->currentEngineFrame.halted;
+    return !mFrame.load().halted;
 }
 
 trackerboy::Frame Renderer::currentFrame() {
-    auto handle = mContext.access();
-    return handle->currentEngineFrame;
+    return mFrame.load();
 }
 
 bool Renderer::setConfig(SoundConfig const &soundConfig, AudioEnumerator const& enumerator) {
@@ -168,6 +216,35 @@ bool Renderer::setConfig(SoundConfig const &soundConfig, AudioEnumerator const&
         soundConfig.latency()
     );
 
+    return applyConfig(soundConfig, wasRunning);
+}
+
+bool Renderer::setConfig(SoundConfig const& soundConfig, VirtualAudioDevice::Config const& device) {
+    bool wasRunning = mStream.isRunning();
+    if (wasRunning) {
+        mTimer->stop();
+    }
+
+    mStream.openVirtual(device, soundConfig.samplerate(), soundConfig.latency());
+
+    return applyConfig(soundConfig, wasRunning);
+}
+
+VirtualAudioDevice const& Renderer::virtualDevice() const {
+    return mStream.virtualDevice();
+}
+
+bool Renderer::applyConfig(SoundConfig const& soundConfig, bool wasRunning) {
+    mStreamEnabled.store(mStream.isEnabled(), std::memory_order_release);
+    {
+        // notes queued before the stream was reopened are stale, they would
+        // all be previewed at once on the next render
+        auto handle = mContext.access();
+        int note;
+        while (mMidiNotes.pop(note)) {
+        }
+    }
+
     if (mStream.isEnabled()) {
 
         mTimer->setInterval(soundConfig.period(), Qt::PreciseTimer);
@@ -181,6 +258,7 @@ bool Renderer::setConfig(SoundConfig const &soundConfig, AudioEnumerator const&
             auto const samplerate = soundConfig.samplerate();
             if (samplerate != handle->synth.samplerate()) {
                 handle->synth.setSamplerate(samplerate);
+                mSamplerate.store(samplerate, std::memory_order_relaxed);
                 reloadRegisters = wasRunning;
             }
             //handle->synth.apu().setQuality(static_cast<gbapu::Apu::Quality>(soundConfig.quality()));
@@ -193,6 +271,7 @@ bool Renderer::setConfig(SoundConfig const &soundConfig, AudioEnumerator const&
             }
 
             handle->bufferSize = mStream.bufferSize();
+            handle->lowLatencyPreview = soundConfig.lowLatencyPreview();
 
 
             mVisBuffer.access()->resize(handle->synth.framesize());
@@ -223,13 +302,18 @@ void Renderer::beginRender(Handle &handle) {
             auto const now = Clock::now();
             handle->lastPeriod = now;
             handle->watchdog = now;
+            handle->levels = { 0.0f, 0.0f, 0.0f, 0.0f };
+            handle->meanSquareLeft = 0.0f;
+            handle->meanSquareRight = 0.0f;
             mRenderStartTime = now;
             mTimer->start();
+            startUiTick();
             handle.unlock();
             emit audioStarted();
             handle.relock();
         } else {
             // unable to start, an error occurred
+            mStreamEnabled.store(mStream.isEnabled(), std::memory_order_release);
             handle.unlock();
             emit audioError();
             return;
@@ -244,22 +328,35 @@ void Renderer::beginRender(Handle &handle) {
 
 void Renderer::stopRender(Handle &handle, bool aborted) {
 
+    // when called from the render thread, the buffer has drained (or the
+    // device stopped taking samples) so there is nothing left to underrun
+    Realtime::Allow allow;
 
     // this lambda must only be called from the same thread as the Renderer
     auto stopRender_ = [this](bool aborted) {
 
         auto success = mStream.stop();
 
+        // deliver anything published since the last tick
+        mUiTimer.stop();
+        uiTick();
+
         mVisBuffer.access()->clear();
+        // the render thread no longer publishes once stopped, so this is
+        // the only writer
+        mLevels.store({ 0.0f, 0.0f, 0.0f, 0.0f });
         emit updateVisualizers();
 
         if (aborted) {
             mStream.disable();
+            mStreamEnabled.store(false, std::memory_order_release);
             emit audioError();
         } else {
             if (success) {
                 emit audioStopped();
             } else {
+                // a failed stop disables the stream
+                mStreamEnabled.store(mStream.isEnabled(), std::memory_order_release);
                 emit audioError();
             }
         }
@@ -319,7 +416,8 @@ void Renderer::stepNextFrame() {
 
 void Renderer::stepOut() {
     if (mStream.isEnabled()) {
-        mContext.access()->stepping = false;
+        auto handle = mContext.access();
+        setStepping(handle, false);
     }
 }
 
@@ -340,85 +438,167 @@ void Renderer::setPatternRepeat(bool repeat) {
 void Renderer::setPreviewNote(int note) {
     if (mStream.isEnabled()) {
         auto ctx = mContext.access();
-        switch (ctx->previewState) {
-            case PreviewState::waveform: {
-                auto freq = trackerboy::lookupToneNote(note);
-                ctx->apu.writeRegister(trackerboy::Apu::REG_NR33, (uint8_t)(freq & 0xFF));
-                ctx->apu.writeRegister(trackerboy::Apu::REG_NR34, (uint8_t)(freq >> 8));
-                break;
-            }
-            case PreviewState::instrument:
-                // update the current note
-                ctx->ip.play((uint8_t)note);
-                break;
-            default:
-                break;
-        
+        _setPreviewNote(ctx, note);
+        previewNow(ctx);
+    }
+}
+
+void Renderer::_setPreviewNote(Handle &handle, int note) {
+    switch (handle->previewState) {
+        case PreviewState::waveform: {
+            auto freq = trackerboy::lookupToneNote(note);
+            handle->apu.writeRegister(trackerboy::Apu::REG_NR33, (uint8_t)(freq & 0xFF));
+            handle->apu.writeRegister(trackerboy::Apu::REG_NR34, (uint8_t)(freq >> 8));
+            break;
         }
+        case PreviewState::instrument:
+            // update the current note
+            handle->ip.play((uint8_t)note);
+            break;
+        default:
+            break;
+
     }
 }
 
 void Renderer::instrumentPreview(int note, int track, int instrumentId) {
     if (mStream.isEnabled()) {
         auto ctx = mContext.access();
-        switch (ctx->previewState) {
-            case PreviewState::instrument:
-            case PreviewState::waveform:
-                resetPreview(ctx);
-                [[fallthrough]];
-            case PreviewState::none: {
-                auto const& itable = ctx->mod.data().instrumentTable();
-                std::shared_ptr<const trackerboy::Instrument> inst = nullptr;
-                if (instrumentId != -1) {
-                    inst = itable.getShared((uint8_t)instrumentId);
-                }
-
-                if (track == -1) {
-                    // instrument preview
-                    Q_ASSERT(inst != nullptr); // must have an instrument
-                    ctx->previewChannel = inst->channel();
-                } else {
-                    // note preview
-                    ctx->previewChannel = static_cast<trackerboy::ChType>(track);
-                }
+        _instrumentPreview(ctx, note, track, instrumentId);
+        beginRender(ctx);
+        previewNow(ctx);
+    }
+}
 
-                ctx->ip.setInstrument(std::move(inst), ctx->previewChannel);
+void Renderer::_instrumentPreview(Handle &handle, int note, int track, int instrumentId) {
+    switch (handle->previewState) {
+        case PreviewState::instrument:
+        case PreviewState::waveform:
+            resetPreview(handle);
+            [[fallthrough]];
+        case PreviewState::none: {
+            auto const& itable = handle->mod.data().instrumentTable();
+            std::shared_ptr<const trackerboy::Instrument> inst = nullptr;
+            if (instrumentId != -1) {
+                inst = itable.getShared((uint8_t)instrumentId);
+            }
 
-                ctx->previewState = PreviewState::instrument;
-                // unlock the channel for preview
-                ctx->engine.unlock(ctx->previewChannel);
-                ctx->ip.play((uint8_t)note);
-                break;
+            if (track == -1) {
+                // instrument preview
+                Q_ASSERT(inst != nullptr); // must have an instrument
+                handle->previewChannel = inst->channel();
+            } else {
+                // note preview
+                handle->previewChannel = static_cast<trackerboy::ChType>(track);
             }
+
+            handle->ip.setInstrument(std::move(inst), handle->previewChannel);
+
+            handle->previewState = PreviewState::instrument;
+            // unlock the channel for preview
+            handle->engine.unlock(handle->previewChannel);
+            handle->ip.play((uint8_t)note);
+            break;
         }
-        beginRender(ctx);
     }
 }
 
 void Renderer::waveformPreview(int note, int waveId) {
     if (mStream.isEnabled()) {
         auto ctx = mContext.access();
-        switch (ctx->previewState) {
-            case PreviewState::instrument:
-            case PreviewState::waveform:
-                resetPreview(ctx);
-                [[fallthrough]];
-            case PreviewState::none:
-                ctx->previewState = PreviewState::waveform;
-                ctx->previewChannel = trackerboy::ChType::ch3;
-                // unlock the channel, no longer effected by music
-                ctx->engine.unlock(trackerboy::ChType::ch3);
-
-                trackerboy::ChannelState state(trackerboy::ChType::ch3);
-                state.playing = true;
-                state.frequency = trackerboy::lookupToneNote(note);
-                state.envelope = (uint8_t)waveId;
-                trackerboy::ChannelControl<trackerboy::ChType::ch3>::init(
-                    ctx->apu, ctx->mod.data().waveformTable(), state
-                );
+        _waveformPreview(ctx, note, waveId);
+        beginRender(ctx);
+        previewNow(ctx);
+    }
+}
+
+void Renderer::_waveformPreview(Handle &handle, int note, int waveId) {
+    switch (handle->previewState) {
+        case PreviewState::instrument:
+        case PreviewState::waveform:
+            resetPreview(handle);
+            [[fallthrough]];
+        case PreviewState::none:
+            handle->previewState = PreviewState::waveform;
+            handle->previewChannel = trackerboy::ChType::ch3;
+            // unlock the channel, no longer effected by music
+            handle->engine.unlock(trackerboy::ChType::ch3);
+
+            trackerboy::ChannelState state(trackerboy::ChType::ch3);
+            state.playing = true;
+            state.frequency = trackerboy::lookupToneNote(note);
+            state.envelope = (uint8_t)waveId;
+            trackerboy::ChannelControl<trackerboy::ChType::ch3>::init(
+                handle->apu, handle->mod.data().waveformTable(), state
+            );
+            break;
+    }
+}
+
+void Renderer::setMidiTarget(PreviewTarget const& target) {
+    mContext.access()->midiTarget = target;
+    mMidiEnabled.store(target.kind != PreviewTarget::none, std::memory_order_release);
+}
+
+bool Renderer::sendMidiNote(int note) {
+    if (!mMidiEnabled.load(std::memory_order_acquire)) {
+        return false;
+    }
+    if (!mStreamEnabled.load(std::memory_order_acquire)) {
+        // nothing would be heard, and the note would be previewed late
+        // when the stream is enabled again
+        return false;
+    }
+    return mMidiNotes.push(note);
+}
+
+void Renderer::wakeForMidi() {
+    if (mStream.isEnabled()) {
+        auto handle = mContext.access();
+        if (handle->state != State::running) {
+            beginRender(handle);
+        }
+    }
+}
+
+void Renderer::previewMidiNotes(Handle &handle) {
+    int note;
+    while (mMidiNotes.pop(note)) {
+        auto const& target = handle->midiTarget;
+        if (note == MIDI_NOTE_OFF) {
+            if (handle->previewState != PreviewState::none) {
+                resetPreview(handle);
+            }
+            continue;
+        }
+
+        // the previewer reads instruments and waveforms from the module
+        auto locker = handle->mod.lock();
+        switch (target.kind) {
+            case PreviewTarget::note:
+                _instrumentPreview(handle, note, target.track, target.id);
+                break;
+            case PreviewTarget::instrument:
+            case PreviewTarget::waveform:
+                if (handle->previewState != PreviewState::none) {
+                    // note changed while a key is held, same as PianoWidget::keyChange
+                    _setPreviewNote(handle, note);
+                } else if (target.kind == PreviewTarget::instrument) {
+                    if (handle->mod.data().instrumentTable().getShared((uint8_t)target.id) == nullptr) {
+                        // removed after the target was set
+                        continue;
+                    }
+                    _instrumentPreview(handle, note, -1, target.id);
+                } else {
+                    _waveformPreview(handle, note, target.id);
+                }
                 break;
+            default:
+                // target was cleared after the note was queued
+                continue;
         }
-        beginRender(ctx);
+        // same as beginRender, a preview cancels the stop countdown
+        handle->stopCounter = 0;
     }
 }
 
@@ -450,7 +630,12 @@ void Renderer::stopMusic() {
 
 void Renderer::_stopMusic(Handle &handle) {
     handle->engine.halt();
-    handle->stepping = false;
+    setStepping(handle, false);
+}
+
+void Renderer::setStepping(Handle &handle, bool stepping) {
+    handle->stepping = stepping;
+    mStepping.store(stepping, std::memory_order_relaxed);
 }
 
 void Renderer::forceStop() {
@@ -460,7 +645,7 @@ void Renderer::forceStop() {
         if (handle->state != State::stopped) {
             resetPreview(handle);
             handle->engine.halt();
-            handle->stepping = false;
+            setStepping(handle, false);
             stopRender(handle);
         }
     }
@@ -469,8 +654,10 @@ void Renderer::forceStop() {
 void Renderer::_play(Handle &handle, int orderNo, int rowNo, bool stepping) {
 
     handle->engine.play(orderNo, rowNo);
+    // the stream may still be playing the last play (ie a stop countdown)
+    mTimeline.reset();
     _setChannelOutput(handle, mOutputFlags);
-    handle->stepping = stepping;
+    setStepping(handle, stepping);
     handle->step = stepping;
     beginRender(handle);
 
@@ -513,6 +700,34 @@ void Renderer::timerCallback(void *userData) {
     static_cast<Renderer*>(userData)->render();
 }
 
+void Renderer::startUiTick() {
+    qreal refreshRate = 60.0;
+    if (auto screen = QGuiApplication::primaryScreen(); screen && screen->refreshRate() > 0) {
+        refreshRate = screen->refreshRate();
+    }
+    mUiTimer.start(std::max(1, (int)std::lround(1000.0 / refreshRate)));
+}
+
+void Renderer::uiTick() {
+    auto const sequence = mFrame.sequence();
+    if (sequence != mUiFrameSequence) {
+        mUiFrameSequence = sequence;
+        emit frameSync();
+
+        // emitted here instead of the render thread, since a queued signal
+        // allocates
+        auto const playing = isPlaying();
+        if (playing != mUiPlaying) {
+            mUiPlaying = playing;
+            emit isPlayingChanged(playing);
+        }
+    }
+
+    if (mVisualizersChanged.exchange(false, std::memory_order_acquire)) {
+        emit updateVisualizers();
+    }
+}
+
 // this is the number of frames to output before stopping playback
 // (prevents a hard pop noise that may occur when stopping abruptly, as
 // the high pass filter will decay the signal to 0)
@@ -521,7 +736,10 @@ constexpr int STOP_FRAMES = 5;
 void Renderer::render() {
     // This function is called from a separate thread!
     // FastTimer lives in its own thread and calls this function via the timer callback
-    
+    TRACE_ZONE("Renderer::render");
+    // anything that waits here can underrun the stream
+    Realtime::Scope realtime;
+
     auto now = Clock::now();
 
     auto handle = mContext.access();
@@ -537,8 +755,15 @@ void Renderer::render() {
     handle->writesSinceLastPeriod = 0;
 
 
+    if (handle->discardPending) {
+        handle->discardPending = false;
+        discardQueued(handle);
+    }
+
     auto writer = mStream.writer();
-    auto framesToRender = writer.availableWrite();
+    // nothing can be written until the callback has discarded the queue
+    auto framesToRender = mStream.isDiscarding() ? 0 : writer.availableWrite();
+    TRACE_COUNTER("Frames to render", framesToRender);
 
     if (framesToRender) {
         // reset the watchdog
@@ -546,6 +771,7 @@ void Renderer::render() {
     } else {
         constexpr auto WATCHDOG_INTERVAL = std::chrono::seconds(1);
         auto timeSinceLastWatchdogReset = now - handle->watchdog;
+        publishStats(handle);
         if (timeSinceLastWatchdogReset >= WATCHDOG_INTERVAL) {
             // we have gone 1 second without renderering anything
             // abort the render
@@ -558,7 +784,6 @@ void Renderer::render() {
 
     
     auto frame = handle->currentEngineFrame;
-    auto const haltedBefore = frame.halted;
 
     // cache a ref to the apu, we'll be using it often
     auto &apu = handle->apu;
@@ -568,9 +793,16 @@ void Renderer::render() {
     auto visHandle = mVisBuffer.access();
     visHandle->beginWrite(framesToRender);
 
+    auto levelLeft = SampleKernels::Level::empty();
+    auto levelRight = SampleKernels::Level::empty();
+
     while (framesToRender) {
 
         if (handle->state == State::stopping) {
+            publishStats(handle);
+            // nothing is written while draining, let the meters fall
+            publishLevels(handle, levelLeft, levelRight, handle->writesSinceLastPeriod);
+            mVisualizersChanged.store(true, std::memory_order_release);
             if (writer.availableWrite() == handle->bufferSize) {
                 // the buffer has been drained, stop the callback
                 visHandle.unlock();
@@ -587,6 +819,9 @@ void Renderer::render() {
                     break; // stop, don't render any more
                 }
 
+                // MIDI notes take effect on frame boundaries, like the engine
+                previewMidiNotes(handle);
+
                 if (handle->stopCounter) {
                     if (--handle->stopCounter == 0) {
                         handle->state = State::stopping;
@@ -602,12 +837,16 @@ void Renderer::render() {
                     if (!handle->stepping || handle->step) {
                         
                         {
-                            QMutexLocker locker(&handle->mod.mutex());
+                            auto locker = handle->mod.lock();
                             handle->engine.step(frame);
                         }
                         
                         if (frame.startedNewRow) {
                             handle->step = false;
+                            if (!frame.halted) {
+                                // the row's first sample is the next one written
+                                mTimeline.rowStarted(frame.order, frame.row, handle->samplesWritten);
+                            }
                         }
                     }
 
@@ -616,7 +855,7 @@ void Renderer::render() {
                         trackerboy::RuntimeContext rc(apu, mod.instrumentTable(), mod.waveformTable());
                         
                         {
-                            QMutexLocker locker(&handle->mod.mutex());
+                            auto locker = handle->mod.lock();
                             handle->ip.step(rc);
                         }
                     }
@@ -640,27 +879,104 @@ void Renderer::render() {
             apu.readSamples(writePtr, toWrite);
             // send a copy to the visualizer buffer as well
             visHandle->write(writePtr, toWrite);
+            // and measure it for the level meters
+            SampleKernels::measure(writePtr, toWrite, levelLeft, levelRight);
             
             writer.commitWrite(toWrite);
             
             handle->writesSinceLastPeriod += toWrite;
+            handle->samplesWritten += toWrite;
             framesToRender -= toWrite;
 
         }
 
     }
 
+    visHandle.unlock();
+    publishStats(handle);
     if (handle->writesSinceLastPeriod) {
-        emit updateVisualizers();
+        publishLevels(handle, levelLeft, levelRight, handle->writesSinceLastPeriod);
+        mVisualizersChanged.store(true, std::memory_order_release);
     }
 
     if (newFrame) {
         handle->currentEngineFrame = frame;
-        handle.unlock(); // always unlock before emitting signals
-        if (haltedBefore != frame.halted) {
-            emit isPlayingChanged(!frame.halted);
-        }
-        emit frameSync();
+        // the GUI picks this up on its next tick, along with isPlayingChanged
+        mFrame.store(frame);
     }
 
 }
+
+void Renderer::previewNow(Handle &handle) {
+    if (!handle->lowLatencyPreview ||
+        handle->state != State::running ||
+        !handle->currentEngineFrame.halted ||
+        handle->previewState == PreviewState::none) {
+        return;
+    }
+
+    handle->discardPending = true;
+    // render now instead of at the next period
+    mTimer->fire();
+}
+
+void Renderer::discardQueued(Handle &handle) {
+    // the rest of the frame was synthesized before the preview started
+    auto &apu = handle->apu;
+    float scratch[TU::DISCARD_FRAMES * 2];
+    while (auto const available = apu.samplesAvailable()) {
+        apu.readSamples(scratch, std::min(available, TU::DISCARD_FRAMES));
+    }
+
+    mStream.discardQueued();
+}
+
+void Renderer::publishStats(Handle &handle) {
+    // it is safe to access the writer since we have acquired access to mContext
+    auto const size = handle->bufferSize;
+    auto const usage = size - mStream.writer().availableWrite();
+    mBufferStats.store({
+        (int)usage,
+        (int)size,
+        (int)handle->writesSinceLastPeriod,
+        std::chrono::duration<double, std::milli>{handle->periodTime}.count()
+    });
+    mTimeline.publish(
+        handle->samplesWritten,
+        (uint32_t)(usage + mStream.playbackDelay()),
+        handle->lastPeriod,
+        handle->synth.samplerate(),
+        !handle->currentEngineFrame.halted && handle->state == State::running
+    );
+}
+
+void Renderer::publishLevels(
+    Handle &handle,
+    SampleKernels::Level const& left,
+    SampleKernels::Level const& right,
+    size_t frames
+) {
+    // Peaks are held and then released exponentially, and RMS is an
+    // exponential moving average of the mean square. Both are based on the
+    // period time, so that the GUI can sample the levels at any rate without
+    // missing a peak.
+    auto const elapsed = std::chrono::duration<float>{handle->periodTime}.count();
+    auto const peakDecay = std::exp(-elapsed / TU::PEAK_RELEASE);
+    auto const rmsDecay = std::exp(-elapsed / TU::RMS_WINDOW);
+
+    auto &levels = handle->levels;
+    levels.peakLeft = std::max(left.peak, levels.peakLeft * peakDecay);
+    levels.peakRight = std::max(right.peak, levels.peakRight * peakDecay);
+
+    auto const meanSquare = [frames](SampleKernels::Level const& level) {
+        return frames ? level.sumSquares / frames : 0.0f;
+    };
+    handle->meanSquareLeft = meanSquare(left) + (handle->meanSquareLeft - meanSquare(left)) * rmsDecay;
+    handle->meanSquareRight = meanSquare(right) + (handle->meanSquareRight - meanSquare(right)) * rmsDecay;
+    levels.rmsLeft = std::sqrt(handle->meanSquareLeft);
+    levels.rmsRight = std::sqrt(handle->meanSquareRight);
+
+    mLevels.store(levels);
+}
+
+#undef TU
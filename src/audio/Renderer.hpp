@@ -3,12 +3,16 @@
 
 #include "audio/AudioStream.hpp"
 #include "audio/AudioEnumerator.hpp"
+#include "audio/PlaybackTimeline.hpp"
+#include "audio/SampleKernels.hpp"
 #include "audio/VisualizerBuffer.hpp"
 #include "config/data/SoundConfig.hpp"
 #include "core/ChannelOutput.hpp"
 #include "utils/FastTimer.hpp"
 #include "core/Module.hpp"
 #include "utils/Guarded.hpp"
+#include "utils/Seqlock.hpp"
+#include "utils/SpscQueue.hpp"
 
 #include "trackerboy/apu/DefaultApu.hpp"
 #include "trackerboy/data/Song.hpp"
@@ -21,7 +25,9 @@
 
 #include <QObject>
 #include <QThread>
+#include <QTimer>
 
+#include <atomic>
 #include <chrono>
 
 //
@@ -47,6 +53,39 @@ public:
         double lastPeriodMs;
     };
 
+    struct Levels {
+        // peak magnitude of each channel, held and released over time (linear, 0.0 to 1.0)
+        float peakLeft;
+        float peakRight;
+        // RMS level of each channel, averaged over time (linear, 0.0 to 1.0)
+        float rmsLeft;
+        float rmsRight;
+    };
+
+    //
+    // Describes what a MIDI note previews when sent directly to the renderer
+    // via sendMidiNote. Same as the arguments to instrumentPreview and
+    // waveformPreview.
+    //
+    struct PreviewTarget {
+        enum Kind {
+            none,       // MIDI notes are not previewed by the renderer
+            note,       // note preview on a track, with an optional instrument
+            instrument, // instrument preview
+            waveform    // waveform preview
+        };
+
+        Kind kind;
+        // track for note previews, 0-3
+        int track;
+        // instrument id for note (-1 for none) and instrument previews, or
+        // the waveform id for waveform previews
+        int id;
+    };
+
+    // note value for sendMidiNote, to stop the preview
+    static constexpr int MIDI_NOTE_OFF = -1;
+
     explicit Renderer(Module &mod, QObject *parent = nullptr);
     ~Renderer();
 
@@ -59,7 +98,7 @@ public:
     unsigned statUnderruns() const;
 
     //
-    // Gets the current buffer statistics.
+    // Gets the buffer statistics as of the last period. Does not block.
     //
     BufferStats statBuffer();
 
@@ -70,10 +109,22 @@ public:
     long statElapsed() const;
 
     //
-    // Get the current samplerate
+    // Get the current samplerate. Does not block.
     //
     int samplerate();
 
+    //
+    // Gets the output levels as of the last period, for level meters. Does
+    // not block. The updateVisualizers() signal is emitted when these change.
+    //
+    Levels levels();
+
+    //
+    // Accessor for the playback timeline, for mapping times to the song
+    // position heard at that time. Thread-safe.
+    //
+    PlaybackTimeline const& timeline() const;
+
     //
     // Accessor for the visualizer buffer. The updateVisualizers() signal is
     // emitted when this buffer is modified.
@@ -86,17 +137,19 @@ public:
     bool isRunning();
 
     //
-    // Determines if the renderer is in step-mode
+    // Determines if the renderer is in step-mode. Does not block.
     //
     bool isStepping();
 
     //
-    // Determines if the renderer is playing music
+    // Determines if the renderer is playing music, as of the last rendered
+    // frame. Does not block.
     //
     bool isPlaying();
 
     //
-    // Gets a copy of the current engine frame.
+    // Gets a copy of the current engine frame. Does not block, the frame is
+    // published by the render thread after each period.
     //
     trackerboy::Frame currentFrame();
 
@@ -107,6 +160,19 @@ public:
     //
     bool setConfig(SoundConfig const& config, AudioEnumerator const& enumerator);
 
+    //
+    // Same as setConfig, but outputs to a virtual device instead of the
+    // configured one (the backend and device in config are ignored). Used
+    // by tests, to render without sound hardware.
+    //
+    bool setConfig(SoundConfig const& config, VirtualAudioDevice::Config const& device);
+
+    //
+    // Gets the virtual device used when configured with one, for its
+    // capture. The render must be stopped.
+    //
+    VirtualAudioDevice const& virtualDevice() const;
+
     //
     // Changes the note being previewed for an instrument/waveform preview.
     // If there is no current preview this function does nothing.
@@ -126,6 +192,31 @@ public:
     //
     void waveformPreview(int note, int waveId);
 
+    //
+    // Sets the target for notes sent via sendMidiNote. Call when the MIDI
+    // receiver changes or its instrument/waveform/track does.
+    //
+    void setMidiTarget(PreviewTarget const& target);
+
+    //
+    // Queues a MIDI note on, or MIDI_NOTE_OFF, for the render thread, which
+    // previews it at the start of the next frame using the MIDI target. This
+    // bypasses the GUI thread entirely when the renderer is running.
+    //
+    // Lock-free, and is meant to be called from the MIDI callback thread (only
+    // one thread may call it). Returns false if the note was not queued (no
+    // target, no audio stream or the queue is full), the caller should
+    // preview the note via instrumentPreview or waveformPreview instead.
+    //
+    bool sendMidiNote(int note);
+
+    //
+    // Starts the render if it is stopped or stopping, so that notes queued by
+    // sendMidiNote get previewed. Must be called from the GUI thread after a
+    // note on was queued.
+    //
+    void wakeForMidi();
+
     //
     // Update the framerate used by the synth. Call this when the module's framerate
     // changes.
@@ -202,7 +293,8 @@ signals:
     void audioStopped();
 
     //
-    // Emitted when music has started/stopped playing
+    // Emitted when music has started/stopped playing, on the next UI tick
+    // after the render thread started or halted the engine.
     //
     void isPlayingChanged(bool playing);
 
@@ -212,12 +304,15 @@ signals:
     void audioError();
 
     //
-    // emitted when a new frame is renderered
+    // emitted when a new frame is renderered. This signal is emitted from the
+    // GUI thread at most once per display refresh, frames renderered between
+    // refreshes are skipped.
     //
     void frameSync();
 
     //
-    // Emitted when the visualizer buffer has been modified
+    // Emitted when the visualizer buffer has been modified, at most once per
+    // display refresh (along with frameSync).
     //
     void updateVisualizers();
 
@@ -275,13 +370,28 @@ private:
         State state;
         int stopCounter;
 
+        // target for notes queued by sendMidiNote
+        PreviewTarget midiTarget;
+
         size_t bufferSize; // cache this here so we don't have to call mStream.bufferSize() in the render thread
 
+        // SoundConfig::lowLatencyPreview
+        bool lowLatencyPreview;
+        // set when a preview was started, the render thread discards the
+        // queued samples so that the preview is heard sooner
+        bool discardPending;
+
         // diagnostics
         Clock::time_point watchdog; // occurance of last watchdog reset
         Clock::time_point lastPeriod; // occurance of the last period
         Clock::duration periodTime; // time difference between the last period and the current one
         size_t writesSinceLastPeriod; // number of samples written for the last period
+        uint64_t samplesWritten; // total samples written since the render began
+
+        // level metering, in the linear (squared for mean squares) domain
+        Levels levels;
+        float meanSquareLeft;
+        float meanSquareRight;
 
         RenderContext(Module &mod);
     };
@@ -294,15 +404,49 @@ private:
 
     void _stopMusic(Handle &handle);
 
+    // sets the stepping flag in the context, and its lock-free copy
+    void setStepping(Handle &handle, bool stepping);
+
     // utility function for preview slots
     void resetPreview(Handle &handle);
 
     void previewNoteOrInstrument(int note, int track = -1, int instrument = -1);
 
+    void _setPreviewNote(Handle &handle, int note);
+
+    void _instrumentPreview(Handle &handle, int note, int track, int instrumentId);
+
+    void _waveformPreview(Handle &handle, int note, int waveId);
+
+    //
+    // Previews the notes queued by sendMidiNote. Called by the render thread
+    // at the start of a frame.
+    //
+    void previewMidiNotes(Handle &handle);
+
     void _setChannelOutput(Handle &handle, ChannelOutput::Flags flags);
 
+    //
+    // Renders a preview that was just started without waiting for the
+    // samples already queued to play out. Only when low latency previews are
+    // enabled and music is not playing, as discarding would skip music.
+    //
+    void previewNow(Handle &handle);
+
+    //
+    // Drops the remaining samples of the current frame and requests the
+    // stream to discard everything queued. Called by the render thread.
+    //
+    void discardQueued(Handle &handle);
+
     // stream management -----------------------------------------------------
 
+    //
+    // Applies the rest of the config once the stream was opened by
+    // setConfig. The render is resumed if wasRunning and the stream opened.
+    //
+    bool applyConfig(SoundConfig const& soundConfig, bool wasRunning);
+
     //
     // Start the audio callback thread for the configured device. If the audio
     // callback thread is already running, the stop countdown is cancelled
@@ -311,6 +455,18 @@ private:
 
     static void timerCallback(void *userData);
 
+    //
+    // Starts the UI tick, paced to the refresh rate of the primary screen.
+    //
+    void startUiTick();
+
+    //
+    // Called by the UI tick from the GUI thread. Emits frameSync and
+    // updateVisualizers if the render thread has published anything new
+    // since the last tick.
+    //
+    void uiTick();
+
     //
     // Fills the playback buffer with newly renderered samples. Stops rendering
     // if there is no work to do and the buffer has drained completely.
@@ -319,6 +475,18 @@ private:
     //
     void render();
 
+    //
+    // Publishes the buffer statistics for the current period. Must only be
+    // called from render(), as the Seqlock only supports a single writer.
+    //
+    void publishStats(Handle &handle);
+
+    //
+    // Updates the meter levels with the levels measured this period and
+    // publishes them. Same restrictions as publishStats.
+    //
+    void publishLevels(Handle &handle, SampleKernels::Level const& left, SampleKernels::Level const& right, size_t frames);
+
     //
     // Immediately stops the render without letting the buffer drain.
     //
@@ -336,6 +504,35 @@ private:
 
     Clock::time_point mRenderStartTime;
 
+    // the last engine frame renderered, published by the render thread
+    Seqlock<trackerboy::Frame> mFrame;
+    // buffer statistics as of the last period, published by the render thread
+    Seqlock<BufferStats> mBufferStats;
+    // output levels as of the last period, published by the render thread
+    Seqlock<Levels> mLevels;
+    // row starts and buffer position, published by the render thread
+    PlaybackTimeline mTimeline;
+    // copy of RenderContext::stepping, for isStepping()
+    std::atomic_bool mStepping;
+    // copy of the synth's samplerate, for samplerate()
+    std::atomic_int mSamplerate;
+    // set by the render thread when the visualizer buffer was written to
+    std::atomic_bool mVisualizersChanged;
+
+    // MIDI notes from sendMidiNote, consumed by the render thread
+    SpscQueue<int, 64> mMidiNotes;
+    // true if the MIDI target is not none, for sendMidiNote
+    std::atomic_bool mMidiEnabled;
+    // copy of mStream.isEnabled(), for sendMidiNote
+    std::atomic_bool mStreamEnabled;
+
+    // paces updates from the render thread to the display's refresh rate.
+    // Since this is a timer, a busy GUI thread never has a backlog of updates
+    // to process, the latest frame is always used.
+    QTimer mUiTimer;
+    unsigned mUiFrameSequence; // sequence of mFrame as of the last tick
+    bool mUiPlaying;           // isPlaying() as of the last tick
+
     //
     // All variables accessible from multiple threads are stored in the RenderContext
     // struct, access to them is guarded by a mutex.
@@ -0,0 +1,109 @@
+
+#include "audio/SampleKernels.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define SAMPLE_KERNELS_SSE
+#include <xmmintrin.h>
+#endif
+
+#define TU SampleKernelsTU
+namespace TU {
+
+static void accumulateScalar(float const* samples, size_t frames, SampleKernels::Range &left, SampleKernels::Range &right) {
+    for (size_t i = 0; i < frames; ++i) {
+        auto const l = samples[0];
+        auto const r = samples[1];
+        left.min = std::min(left.min, l);
+        left.max = std::max(left.max, l);
+        left.sum += l;
+        right.min = std::min(right.min, r);
+        right.max = std::max(right.max, r);
+        right.sum += r;
+        samples += 2;
+    }
+}
+
+static void measureScalar(float const* samples, size_t frames, SampleKernels::Level &left, SampleKernels::Level &right) {
+    for (size_t i = 0; i < frames; ++i) {
+        auto const l = samples[0];
+        auto const r = samples[1];
+        left.peak = std::max(left.peak, std::fabs(l));
+        left.sumSquares += l * l;
+        right.peak = std::max(right.peak, std::fabs(r));
+        right.sumSquares += r * r;
+        samples += 2;
+    }
+}
+
+}
+
+namespace SampleKernels {
+
+void accumulate(float const* samples, size_t frames, Range &left, Range &right) {
+#ifdef SAMPLE_KERNELS_SSE
+    if (frames >= 4) {
+        // each vector holds two frames: L R L R
+        auto vmin = _mm_setr_ps(left.min, right.min, left.min, right.min);
+        auto vmax = _mm_setr_ps(left.max, right.max, left.max, right.max);
+        auto vsum = _mm_setzero_ps();
+        for (; frames >= 2; frames -= 2) {
+            auto const v = _mm_loadu_ps(samples);
+            vmin = _mm_min_ps(vmin, v);
+            vmax = _mm_max_ps(vmax, v);
+            vsum = _mm_add_ps(vsum, v);
+            samples += 4;
+        }
+
+        alignas(16) float mins[4];
+        alignas(16) float maxs[4];
+        alignas(16) float sums[4];
+        _mm_store_ps(mins, vmin);
+        _mm_store_ps(maxs, vmax);
+        _mm_store_ps(sums, vsum);
+        left.min = std::min(mins[0], mins[2]);
+        left.max = std::max(maxs[0], maxs[2]);
+        left.sum += sums[0] + sums[2];
+        right.min = std::min(mins[1], mins[3]);
+        right.max = std::max(maxs[1], maxs[3]);
+        right.sum += sums[1] + sums[3];
+    }
+#endif
+
+    // remaining frames, or all of them when not vectorised
+    TU::accumulateScalar(samples, frames, left, right);
+}
+
+void measure(float const* samples, size_t frames, Level &left, Level &right) {
+#ifdef SAMPLE_KERNELS_SSE
+    if (frames >= 4) {
+        // clearing the sign bit gives the magnitude
+        auto const signMask = _mm_set1_ps(-0.0f);
+        auto vpeak = _mm_setr_ps(left.peak, right.peak, left.peak, right.peak);
+        auto vsquares = _mm_setzero_ps();
+        for (; frames >= 2; frames -= 2) {
+            auto const v = _mm_loadu_ps(samples);
+            vpeak = _mm_max_ps(vpeak, _mm_andnot_ps(signMask, v));
+            vsquares = _mm_add_ps(vsquares, _mm_mul_ps(v, v));
+            samples += 4;
+        }
+
+        alignas(16) float peaks[4];
+        alignas(16) float squares[4];
+        _mm_store_ps(peaks, vpeak);
+        _mm_store_ps(squares, vsquares);
+        left.peak = std::max(peaks[0], peaks[2]);
+        left.sumSquares += squares[0] + squares[2];
+        right.peak = std::max(peaks[1], peaks[3]);
+        right.sumSquares += squares[1] + squares[3];
+    }
+#endif
+
+    TU::measureScalar(samples, frames, left, right);
+}
+
+}
+
+#undef TU
@@ -0,0 +1,66 @@
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+
+//
+// Vectorised kernels over interleaved stereo float samples, for visualizers.
+// SSE is used when available, otherwise the kernels are plain loops written
+// so that the compiler can vectorise them.
+//
+namespace SampleKernels {
+
+//
+// Minimum, maximum and sum of a channel's samples
+//
+struct Range {
+    float min;
+    float max;
+    float sum;
+
+    //
+    // An empty range, accumulate into this
+    //
+    static constexpr Range empty() {
+        return { 1.0e30f, -1.0e30f, 0.0f };
+    }
+
+    //
+    // Accumulates another range into this one
+    //
+    void merge(Range const& other) {
+        min = std::min(min, other.min);
+        max = std::max(max, other.max);
+        sum += other.sum;
+    }
+};
+
+//
+// Accumulates the given interleaved stereo samples (frames count of left and
+// right pairs) into the ranges for the left and right channel.
+//
+void accumulate(float const* samples, size_t frames, Range &left, Range &right);
+
+//
+// Peak magnitude and sum of squares of a channel's samples, for level meters
+//
+struct Level {
+    float peak;
+    float sumSquares;
+
+    //
+    // An empty level (silence), accumulate into this
+    //
+    static constexpr Level empty() {
+        return { 0.0f, 0.0f };
+    }
+};
+
+//
+// Accumulates the peak and sum of squares of the given interleaved stereo
+// samples into the levels for the left and right channel.
+//
+void measure(float const* samples, size_t frames, Level &left, Level &right);
+
+}
@@ -0,0 +1,90 @@
+
+#include "audio/SpectrumAnalyser.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#define TU SpectrumAnalyserTU
+namespace TU {
+
+constexpr double PI = 3.14159265358979323846;
+
+}
+
+SpectrumAnalyser::SpectrumAnalyser(QObject *parent) :
+    QObject(parent),
+    mFft(FFT_SIZE),
+    mWindow(FFT_SIZE),
+    mWindowed(FFT_SIZE),
+    mBinPower(mFft.bins()),
+    mPower(mFft.bins()),
+    mBandEdges()
+{
+    for (size_t i = 0; i < FFT_SIZE; ++i) {
+        mWindow[i] = (float)(0.5 - 0.5 * std::cos(2.0 * TU::PI * i / FFT_SIZE));
+    }
+}
+
+void SpectrumAnalyser::analyse(std::vector<float> const& left, std::vector<float> const& right, int bands) {
+    Q_ASSERT(left.size() >= SAMPLES && right.size() >= SAMPLES);
+    if (bands <= 0) {
+        return;
+    }
+
+    std::fill(mPower.begin(), mPower.end(), 0.0f);
+    accumulate(left);
+    accumulate(right);
+
+    if (mBandEdges.size() != (size_t)bands + 1) {
+        setBands(bands);
+    }
+
+    // a full scale sine has a magnitude of FFT_SIZE / 4 with a Hann window,
+    // scale so that it is 0 dB
+    constexpr float SCALE = 4.0f / FFT_SIZE;
+    constexpr float TRANSFORMS = WINDOWS * 2;
+    auto const dbOffset = 20.0f * std::log10(SCALE) - 10.0f * std::log10(TRANSFORMS);
+
+    QVector<float> levels(bands);
+    for (int band = 0; band < bands; ++band) {
+        // the loudest bin in a band, so that tones are not averaged away
+        // bands narrower than a bin repeat it
+        auto const first = mPower.begin() + mBandEdges[band];
+        auto const last = mPower.begin() + std::max(mBandEdges[band] + 1, mBandEdges[band + 1]);
+        auto const power = *std::max_element(first, last);
+        auto level = 0.0f;
+        if (power > 0.0f) {
+            auto const db = 10.0f * std::log10(power) + dbOffset;
+            level = std::clamp((db - MIN_DB) / -MIN_DB, 0.0f, 1.0f);
+        }
+        levels[band] = level;
+    }
+
+    emit analysed(levels);
+}
+
+void SpectrumAnalyser::accumulate(std::vector<float> const& samples) {
+    for (size_t window = 0; window < WINDOWS; ++window) {
+        auto const src = samples.data() + window * HOP;
+        for (size_t i = 0; i < FFT_SIZE; ++i) {
+            mWindowed[i] = src[i] * mWindow[i];
+        }
+        mFft.power(mWindowed.data(), mBinPower.data());
+        for (size_t i = 0; i < mPower.size(); ++i) {
+            mPower[i] += mBinPower[i];
+        }
+    }
+}
+
+void SpectrumAnalyser::setBands(int bands) {
+    // bands are log-spaced from the first bin above DC to Nyquist
+    auto const lastBin = mFft.bins() - 1;
+    mBandEdges.resize(bands + 1);
+    for (int band = 0; band < bands; ++band) {
+        auto const edge = std::pow((double)lastBin, (double)band / bands);
+        mBandEdges[band] = std::min(lastBin, (size_t)edge);
+    }
+    mBandEdges[bands] = lastBin + 1;
+}
+
+#undef TU
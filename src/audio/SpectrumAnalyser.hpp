@@ -0,0 +1,81 @@
+
+#pragma once
+
+#include "audio/RealFft.hpp"
+#include "audio/VisualizerBuffer.hpp"
+
+#include <QObject>
+#include <QVector>
+
+#include <vector>
+
+//
+// Computes the spectrum of samples from the visualizer buffer's history, for
+// the spectrum visualizer. The analysis is meant to be run on a worker thread,
+// results are delivered via the analysed signal.
+//
+// Each analysis averages the power of WINDOWS overlapping Hann windowed
+// transforms of both channels (Welch's method), and reduces the bins to a
+// number of log-spaced bands, one for each column of the visualizer.
+//
+class SpectrumAnalyser : public QObject {
+
+    Q_OBJECT
+
+public:
+
+    static constexpr size_t FFT_SIZE = 2048;
+    // number of overlapping windows averaged for each analysis
+    static constexpr size_t WINDOWS = 4;
+    // distance between windows, for 50% overlap
+    static constexpr size_t HOP = FFT_SIZE / 2;
+    // number of samples used for each analysis
+    static constexpr size_t SAMPLES = FFT_SIZE + HOP * (WINDOWS - 1);
+
+    // level of an empty band, in dB full scale
+    static constexpr float MIN_DB = -84.0f;
+
+    static_assert(SAMPLES <= VisualizerBuffer::HISTORY_SIZE, "not enough history for analysis");
+
+    explicit SpectrumAnalyser(QObject *parent = nullptr);
+
+    //
+    // Analyses SAMPLES samples of each channel into the given number of bands
+    // and emits analysed.
+    //
+    void analyse(std::vector<float> const& left, std::vector<float> const& right, int bands);
+
+signals:
+
+    //
+    // Emitted with the level of each band, lowest frequency first, from 0.0
+    // (MIN_DB or below) to 1.0 (0 dB full scale).
+    //
+    void analysed(QVector<float> const& bands);
+
+private:
+    Q_DISABLE_COPY(SpectrumAnalyser)
+
+    //
+    // Adds the windowed power spectrum of each window in samples to mPower.
+    //
+    void accumulate(std::vector<float> const& samples);
+
+    //
+    // Recalculates the band edges for the given number of bands
+    //
+    void setBands(int bands);
+
+    RealFft mFft;
+    std::vector<float> mWindow;
+
+    // scratch buffers
+    std::vector<float> mWindowed;
+    std::vector<float> mBinPower;
+    // power of each bin summed over all transforms
+    std::vector<float> mPower;
+
+    // first bin of each band, with an extra entry for the end of the last band
+    std::vector<size_t> mBandEdges;
+
+};
@@ -0,0 +1,112 @@
+
+#include "audio/VirtualAudioDevice.hpp"
+
+#include <algorithm>
+#include <random>
+
+VirtualAudioDevice::VirtualAudioDevice() :
+    mConfig{ 0, 1.0, 0, 0, 0 },
+    mSamplerate(0),
+    mCallback(nullptr),
+    mUserData(nullptr),
+    mMutex(),
+    mCond(),
+    mQuit(false),
+    mThread(),
+    mPeriod(),
+    mCaptured(),
+    mCaptureLimit(0),
+    mFramesConsumed(0)
+{
+}
+
+VirtualAudioDevice::~VirtualAudioDevice() {
+    stop();
+}
+
+void VirtualAudioDevice::init(Config const& config, int samplerate, DataCallback callback, void *userData) {
+    Q_ASSERT(!isRunning());
+    Q_ASSERT(config.periodFrames > 0 && config.speed > 0.0 && samplerate > 0);
+
+    mConfig = config;
+    mSamplerate = samplerate;
+    mCallback = callback;
+    mUserData = userData;
+    mPeriod.resize(config.periodFrames * 2);
+}
+
+void VirtualAudioDevice::start() {
+    if (isRunning()) {
+        return;
+    }
+
+    mCaptured.clear();
+    mCaptureLimit = mConfig.captureFrames * 2;
+    // reserved now so that capturing does not allocate while running
+    mCaptured.reserve(mCaptureLimit);
+    mFramesConsumed = 0;
+    mQuit = false;
+
+    mThread.reset(QThread::create([this]() {
+        run();
+    }));
+    mThread->setObjectName(QStringLiteral("virtual audio device thread"));
+    mThread->start(QThread::TimeCriticalPriority);
+}
+
+void VirtualAudioDevice::stop() {
+    if (!isRunning()) {
+        return;
+    }
+
+    {
+        std::scoped_lock lock(mMutex);
+        mQuit = true;
+    }
+    mCond.notify_one();
+    mThread->wait();
+    mThread.reset();
+}
+
+bool VirtualAudioDevice::isRunning() const {
+    return mThread != nullptr;
+}
+
+uint64_t VirtualAudioDevice::framesConsumed() const {
+    return mFramesConsumed.load(std::memory_order_relaxed);
+}
+
+std::vector<float> const& VirtualAudioDevice::captured() const {
+    Q_ASSERT(!isRunning());
+    return mCaptured;
+}
+
+void VirtualAudioDevice::run() {
+    std::mt19937 rng(mConfig.seed);
+    std::uniform_int_distribution<int> jitter(0, mConfig.jitter);
+    auto const period = std::chrono::duration<double>(
+        mConfig.periodFrames / (mSamplerate * mConfig.speed)
+    );
+
+    auto const start = Clock::now();
+    std::unique_lock lock(mMutex);
+    for (uint64_t periods = 1; ; ++periods) {
+        // deadlines are from the start, so that the jitter and any late
+        // wake-ups do not change the rate
+        auto const deadline = start
+            + std::chrono::duration_cast<Clock::duration>(period * periods)
+            + std::chrono::microseconds(jitter(rng));
+        if (mCond.wait_until(lock, deadline, [this]() { return mQuit; })) {
+            break;
+        }
+
+        lock.unlock();
+        std::fill(mPeriod.begin(), mPeriod.end(), 0.0f);
+        mCallback(mUserData, mPeriod.data(), mConfig.periodFrames);
+
+        auto const capture = std::min(mCaptureLimit - mCaptured.size(), mPeriod.size());
+        mCaptured.insert(mCaptured.end(), mPeriod.begin(), mPeriod.begin() + capture);
+        mFramesConsumed.fetch_add(mConfig.periodFrames, std::memory_order_relaxed);
+        lock.lock();
+    }
+}
@@ -0,0 +1,106 @@
+
+#pragma once
+
+#include <QThread>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+//
+// An audio device that is not backed by sound hardware, so that the renderer
+// can be run without a sound card (ie tests in CI containers).
+//
+// Once started, a thread of its own requests a period of frames from the data
+// callback at the device's rate, like the callback thread of a real device.
+// Each period can be delayed by a random amount of jitter, while the rate is
+// kept on average. The frames given by the callback can be captured to
+// memory.
+//
+class VirtualAudioDevice {
+
+public:
+
+    //
+    // Called from the device's thread with a buffer of frames (interleaved
+    // stereo) to fill. The buffer is cleared beforehand.
+    //
+    using DataCallback = void(*)(void *userData, float *out, size_t frames);
+
+    struct Config {
+        // frames requested from the callback per period
+        size_t periodFrames;
+        // rate that frames are consumed at, relative to the samplerate. 1.0
+        // is real time, 2.0 is twice as fast.
+        double speed;
+        // maximum delay added to each period, in microseconds
+        int jitter;
+        // seed for the jitter, so that runs can be repeated
+        unsigned seed;
+        // maximum number of frames to capture, 0 disables capturing
+        size_t captureFrames;
+    };
+
+    VirtualAudioDevice();
+    ~VirtualAudioDevice();
+
+    //
+    // Sets up the device with the given config. The device must be stopped.
+    //
+    void init(Config const& config, int samplerate, DataCallback callback, void *userData);
+
+    //
+    // Starts requesting frames from the callback. Clears the capture and
+    // the consumed frame count.
+    //
+    void start();
+
+    //
+    // Stops the device, and waits for the callback to return if it is
+    // being called.
+    //
+    void stop();
+
+    bool isRunning() const;
+
+    //
+    // Gets the total number of frames consumed since the last start(). Can
+    // be called while running.
+    //
+    uint64_t framesConsumed() const;
+
+    //
+    // Gets the frames captured since the last start(), as interleaved stereo
+    // samples. The device must be stopped.
+    //
+    std::vector<float> const& captured() const;
+
+private:
+    Q_DISABLE_COPY(VirtualAudioDevice)
+
+    using Clock = std::chrono::steady_clock;
+
+    void run();
+
+    Config mConfig;
+    int mSamplerate;
+    DataCallback mCallback;
+    void *mUserData;
+
+    std::mutex mMutex;
+    std::condition_variable mCond;
+    bool mQuit;
+    std::unique_ptr<QThread> mThread;
+
+    std::vector<float> mPeriod;
+    std::vector<float> mCaptured;
+    // maximum size of mCaptured, in samples (capacity may be larger)
+    size_t mCaptureLimit;
+    std::atomic<uint64_t> mFramesConsumed;
+
+};
@@ -9,14 +9,33 @@ VisualizerBuffer::VisualizerBuffer() :
     mBufferData(),
     mBufferSize(0),
     mIndex(0),
-    mIgnoreCounter(0)
+    mIgnoreCounter(0),
+    mLevels(),
+    mHistory(std::make_unique<float[]>(HISTORY_SIZE * 2)),
+    mHistoryIndex(0)
 {
+    for (auto &level : mLevels) {
+        level.entries.resize(LEVEL_CAPACITY);
+    }
+    clear();
 }
 
 void VisualizerBuffer::clear() {
     std::fill_n(mBufferData.get(), mBufferSize * 2, 0.0f);
     mIndex = 0;
     mIgnoreCounter = 0;
+
+    // silence, an empty Range would be drawn off the scale
+    Entry const silent = { { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f } };
+    for (auto &level : mLevels) {
+        std::fill(level.entries.begin(), level.entries.end(), silent);
+        level.index = 0;
+        level.pending = { SampleKernels::Range::empty(), SampleKernels::Range::empty() };
+        level.pendingCount = 0;
+    }
+
+    std::fill_n(mHistory.get(), HISTORY_SIZE * 2, 0.0f);
+    mHistoryIndex = 0;
 }
 
 void VisualizerBuffer::resize(size_t size) {
@@ -48,28 +67,95 @@ void VisualizerBuffer::read(size_t index, float &outLeft, float &outRight) {
 
 }
 
-void VisualizerBuffer::averageSample(float index, float bin, float &outLeft, float &outRight) {
-    
-    // determine the number of samples to average, with a minimum of 1 sample
-    int samples = std::max(1, (int)((index + bin) - (int)index));
-
-    size_t bufIndex = (mIndex + (size_t)index) % mBufferSize;
-    auto buf = mBufferData.get() + (bufIndex * 2);
-
-    float sumLeft = 0.0f;
-    float sumRight = 0.0f;
-    for (int i = 0; i < samples; ++i) {
-        sumLeft += *buf++;
-        sumRight += *buf++;
-        if (++bufIndex == mBufferSize) {
-            bufIndex = 0;
-            buf = mBufferData.get();
+void VisualizerBuffer::decimate(int columns, Column outLeft[], Column outRight[]) const {
+    decimate(mBufferSize, columns, outLeft, outRight);
+}
+
+void VisualizerBuffer::decimate(size_t window, int columns, Column outLeft[], Column outRight[]) const {
+    Q_ASSERT(mBufferSize > 0);
+
+    window = std::clamp(window, (size_t)1, maxWindow());
+
+    if (window > mBufferSize) {
+        // find the coarsest level with at least one entry per column, going
+        // coarser regardless when the level's entries do not cover the window
+        int levelNo = 0;
+        size_t factor = LEVEL_FACTOR;
+        while (levelNo + 1 < LEVELS && (
+                window / factor > LEVEL_CAPACITY ||
+                window / (factor * LEVEL_FACTOR) >= (size_t)columns)) {
+            ++levelNo;
+            factor *= LEVEL_FACTOR;
         }
+
+        auto const& level = mLevels[levelNo];
+        auto const entries = std::min(LEVEL_CAPACITY, std::max((size_t)1, window / factor));
+        // oldest entry in the window
+        auto const first = (level.index + LEVEL_CAPACITY - entries) % LEVEL_CAPACITY;
+        for (int col = 0; col < columns; ++col) {
+            auto const start = std::min((size_t)col * entries / columns, entries - 1);
+            auto const end = std::max(start + 1, (size_t)(col + 1) * entries / columns);
+
+            auto left = SampleKernels::Range::empty();
+            auto right = SampleKernels::Range::empty();
+            for (auto i = start; i < end; ++i) {
+                auto const& entry = level.entries[(first + i) % LEVEL_CAPACITY];
+                left.merge(entry.left);
+                right.merge(entry.right);
+            }
+
+            auto const samples = (float)((end - start) * factor);
+            outLeft[col] = { left.min, left.max, left.sum / samples };
+            outRight[col] = { right.min, right.max, right.sum / samples };
+        }
+        return;
+    }
+
+    auto const data = mBufferData.get();
+    // oldest sample in the window, relative to the oldest sample in the buffer
+    auto const offset = mBufferSize - window;
+    for (int col = 0; col < columns; ++col) {
+        // range of samples for this column, relative to the oldest sample
+        auto const start = offset + std::min((size_t)col * window / columns, window - 1);
+        auto const end = std::max(start + 1, offset + (size_t)(col + 1) * window / columns);
+        auto const count = end - start;
+
+        auto left = SampleKernels::Range::empty();
+        auto right = SampleKernels::Range::empty();
+
+        // the range wraps at most once
+        auto const pos = (mIndex + start) % mBufferSize;
+        auto const first = std::min(count, mBufferSize - pos);
+        SampleKernels::accumulate(data + (pos * 2), first, left, right);
+        if (first < count) {
+            SampleKernels::accumulate(data, count - first, left, right);
+        }
+
+        outLeft[col] = { left.min, left.max, left.sum / count };
+        outRight[col] = { right.min, right.max, right.sum / count };
+    }
+}
+
+size_t VisualizerBuffer::maxWindow() const {
+    size_t factor = 1;
+    for (int i = 0; i < LEVELS; ++i) {
+        factor *= LEVEL_FACTOR;
     }
-    
-    outLeft = (float)sumLeft / samples;
-    outRight = (float)sumRight / samples;
+    return std::max(mBufferSize, factor * LEVEL_CAPACITY);
+}
+
+void VisualizerBuffer::history(size_t samples, float outLeft[], float outRight[]) const {
+    Q_ASSERT(samples <= HISTORY_SIZE);
 
+    auto const data = mHistory.get();
+    auto pos = (mHistoryIndex + HISTORY_SIZE - samples) % HISTORY_SIZE;
+    for (size_t i = 0; i < samples; ++i) {
+        outLeft[i] = data[pos * 2];
+        outRight[i] = data[pos * 2 + 1];
+        if (++pos == HISTORY_SIZE) {
+            pos = 0;
+        }
+    }
 }
 
 void VisualizerBuffer::beginWrite(size_t amount) {
@@ -83,6 +169,11 @@ void VisualizerBuffer::beginWrite(size_t amount) {
 
 void VisualizerBuffer::write(float buf[], size_t amount) {
 
+    // the levels and history get everything, including samples too old for
+    // the raw buffer
+    writeLevels(buf, amount);
+    writeHistory(buf, amount);
+
     auto ignoring = std::min(mIgnoreCounter, amount);
     amount -= ignoring;
     mIgnoreCounter -= ignoring;
@@ -121,3 +212,56 @@ void VisualizerBuffer::write(float buf[], size_t amount) {
     }
 
 }
+
+void VisualizerBuffer::writeLevels(float const buf[], size_t amount) {
+    auto &level = mLevels[0];
+    while (amount) {
+        // accumulate up to the end of the pending entry in one go
+        auto const count = std::min(amount, LEVEL_FACTOR - level.pendingCount);
+        SampleKernels::accumulate(buf, count, level.pending.left, level.pending.right);
+        level.pendingCount += count;
+        buf += count * 2;
+        amount -= count;
+
+        if (level.pendingCount == LEVEL_FACTOR) {
+            pushEntry(0, level.pending);
+            level.pending = { SampleKernels::Range::empty(), SampleKernels::Range::empty() };
+            level.pendingCount = 0;
+        }
+    }
+}
+
+void VisualizerBuffer::pushEntry(int levelNo, Entry const& entry) {
+    auto &level = mLevels[levelNo];
+    level.entries[level.index] = entry;
+    if (++level.index == LEVEL_CAPACITY) {
+        level.index = 0;
+    }
+
+    if (levelNo + 1 < LEVELS) {
+        // merge into the next level's pending entry
+        auto &next = mLevels[levelNo + 1];
+        auto &pending = next.pending;
+        pending.left.merge(entry.left);
+        pending.right.merge(entry.right);
+        if (++next.pendingCount == LEVEL_FACTOR) {
+            pushEntry(levelNo + 1, pending);
+            pending = { SampleKernels::Range::empty(), SampleKernels::Range::empty() };
+            next.pendingCount = 0;
+        }
+    }
+}
+
+void VisualizerBuffer::writeHistory(float const buf[], size_t amount) {
+    if (amount > HISTORY_SIZE) {
+        // only the most recent samples fit
+        buf += (amount - HISTORY_SIZE) * 2;
+        amount = HISTORY_SIZE;
+    }
+
+    // wraps at most once
+    auto const first = std::min(amount, HISTORY_SIZE - mHistoryIndex);
+    std::copy_n(buf, first * 2, mHistory.get() + (mHistoryIndex * 2));
+    std::copy_n(buf + (first * 2), (amount - first) * 2, mHistory.get());
+    mHistoryIndex = (mHistoryIndex + amount) % HISTORY_SIZE;
+}
@@ -1,7 +1,11 @@
 #pragma once
 
+#include "audio/SampleKernels.hpp"
+
+#include <array>
 #include <cstddef>
 #include <memory>
+#include <vector>
 
 
 //
@@ -27,9 +31,37 @@
 // When the index gets to the end of the buffer, it wraps (rotates) to the start
 // The index points to the oldest sample in the buffer, the sample before it is the newest.
 //
+// In addition to the raw samples, a pyramid of min/max/sum levels is kept for
+// longer windows of history. Level 1 has an entry for every LEVEL_FACTOR
+// samples, level 2 for every LEVEL_FACTOR entries of level 1, and so on. The
+// levels are updated as samples are written, so decimating any window costs
+// about the same.
+//
+// A separate history of the last HISTORY_SIZE raw samples is also kept for
+// analysis that needs more samples than a frame, such as a spectrum.
+//
 class VisualizerBuffer {
 
 public:
+
+    //
+    // A column of decimated samples for a single channel
+    //
+    struct Column {
+        float min;
+        float max;
+        float average;
+    };
+
+    // number of pyramid levels, not including the raw samples
+    static constexpr int LEVELS = 3;
+    // decimation factor between consecutive levels
+    static constexpr size_t LEVEL_FACTOR = 8;
+    // number of entries in each level
+    static constexpr size_t LEVEL_CAPACITY = 1024;
+    // number of samples kept for history(), per channel
+    static constexpr size_t HISTORY_SIZE = 8192;
+
     VisualizerBuffer();
     ~VisualizerBuffer() = default;
 
@@ -42,11 +74,34 @@ public:
     void read(size_t index, float &outLeft, float &outRight);
 
     //
-    // Computes the average left and right samples for the given index and bin
-    // size. Bin size refers to the ratio of samples per pixel. ie, a bin size
-    // of 2.5 means that 2.5 samples are represented by a single pixel.
+    // Decimates the buffer, from oldest to newest sample, into the given
+    // number of columns for each channel. Each column has the minimum,
+    // maximum and average of size() / columns samples (at least 1), ie a
+    // column per pixel for a scope. Columns are computed in a single pass
+    // using SampleKernels.
+    //
+    void decimate(int columns, Column outLeft[], Column outRight[]) const;
+
+    //
+    // Same as above, but for the most recent window samples. Windows longer
+    // than size() are decimated from the coarsest pyramid level that still
+    // has at least one entry per column, or from a coarser level when that
+    // one cannot cover the window, up to maxWindow() samples. History
+    // that has not been written yet (ie just after a clear) is silent.
+    //
+    void decimate(size_t window, int columns, Column outLeft[], Column outRight[]) const;
+
+    //
+    // Maximum window that can be decimated, in samples.
+    //
+    size_t maxWindow() const;
+
+    //
+    // Copies the most recent samples, oldest first, to the given buffers,
+    // one per channel. At most HISTORY_SIZE samples can be copied, history
+    // that has not been written yet is silent.
     //
-    void averageSample(float index, float bin, float &outLeft, float &outRight);
+    void history(size_t samples, float outLeft[], float outRight[]) const;
 
     //
     // Begin a write operation. If amount is greater than this buffer's
@@ -62,6 +117,36 @@ public:
 
 private:
 
+    // entry in a pyramid level
+    struct Entry {
+        SampleKernels::Range left;
+        SampleKernels::Range right;
+    };
+
+    struct Level {
+        std::vector<Entry> entries;
+        // index of the next entry to write
+        size_t index;
+        // entry being accumulated, and the number of samples/entries in it
+        Entry pending;
+        size_t pendingCount;
+    };
+
+    //
+    // Adds samples to the first pyramid level
+    //
+    void writeLevels(float const buf[], size_t amount);
+
+    //
+    // Adds a completed entry to the given level, cascading to the next
+    //
+    void pushEntry(int level, Entry const& entry);
+
+    //
+    // Adds samples to the history
+    //
+    void writeHistory(float const buf[], size_t amount);
+
     std::unique_ptr<float[]> mBufferData;
     size_t mBufferSize;
 
@@ -69,4 +154,11 @@ private:
 
     size_t mIgnoreCounter;
 
+    std::array<Level, LEVELS> mLevels;
+
+    // interleaved, same layout as mBufferData
+    std::unique_ptr<float[]> mHistory;
+    // index of the oldest sample in the history
+    size_t mHistoryIndex;
+
 };
@@ -5,6 +5,8 @@
 
 #include <algorithm>
 #include <cstddef>
+#include <string_view>
+#include <unordered_map>
 
 //
 // Implementation details
@@ -42,7 +44,20 @@
 // The clip can be restored to its original location, or moved (pasted) to a
 // new location. Pasting to a new location may result in a partial copy if the
 // clip goes out of bounds of the destination pattern.
-// 
+//
+// Clips stored in the undo history can be compacted. Since empty cells are
+// all zero bytes, the data buffer is run-length encoded such that a run of
+// zeros is stored as a 0 byte followed by the length of the run (1-255). All
+// other bytes are stored as-is. Using the example above, the compacted buffer
+// is
+// {
+//        13, 1, 6, 0, 1,   // row 0
+//        0, 4,             // row 1
+//        85, 0, 255 ...
+// }
+// ie 20 bytes down to 9. Compacted buffers are also interned, so that
+// clips with identical data (ie the before and after clip of an edit that
+// changed nothing, or repeated pastes) share a single buffer.
 //
 //
 
@@ -94,10 +109,128 @@ size_t getRowLength(PatternSelection::Iterator const& iter) {
     return length - columnToOffset(iter.columnStart());
 }
 
+constexpr size_t MAX_RUN = 255;
+
+//
+// Run-length encodes zero bytes from src to dest. dest must be able to hold
+// 2 * size bytes (the worst case). Returns the size of the encoded data.
+//
+size_t compress(char const* src, size_t size, char *dest) {
+    auto const destStart = dest;
+    auto const srcEnd = src + size;
+    while (src != srcEnd) {
+        auto const byte = *src++;
+        *dest++ = byte;
+        if (byte == 0) {
+            size_t run = 1;
+            while (src != srcEnd && *src == 0 && run < MAX_RUN) {
+                ++src;
+                ++run;
+            }
+            *dest++ = (char)(unsigned char)run;
+        }
+    }
+    return (size_t)(dest - destStart);
+}
+
+//
+// Expands data encoded by compress
+//
+void expand(char const* src, size_t size, char *dest, size_t destSize) {
+    auto const srcEnd = src + size;
+    auto const destEnd = dest + destSize;
+    while (src != srcEnd) {
+        auto const byte = *src++;
+        if (byte == 0) {
+            auto const run = std::min((size_t)(unsigned char)*src++, (size_t)(destEnd - dest));
+            dest = std::fill_n(dest, run, '\0');
+        } else {
+            *dest++ = byte;
+        }
+    }
+    Q_ASSERT(dest == destEnd);
+}
+
+//
+// Pool of compacted clip buffers, used to share identical data between clips.
+// Clips are only compacted on the GUI thread, so no locking is necessary.
+//
+struct PoolEntry {
+    std::weak_ptr<char const[]> data;
+    size_t size;
+};
+
+// minimum size of the pool before expired entries are swept
+constexpr size_t POOL_MIN_SWEEP = 64;
+
+struct Pool {
+    std::unordered_multimap<size_t, PoolEntry> entries;
+    // expired entries are swept once the pool reaches this size, which is
+    // twice its size after the last sweep
+    size_t sweepAt = POOL_MIN_SWEEP;
+};
+
+Pool& pool() {
+    static Pool instance;
+    return instance;
+}
+
+//
+// Removes the entries of buffers no longer in use. Entries are otherwise
+// only removed when a lookup finds them, so without sweeping the pool would
+// keep growing for the whole session.
+//
+void sweep(Pool &_pool) {
+    auto &entries = _pool.entries;
+    for (auto iter = entries.begin(); iter != entries.end(); ) {
+        if (iter->second.data.expired()) {
+            iter = entries.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+    _pool.sweepAt = std::max(POOL_MIN_SWEEP, entries.size() * 2);
+}
+
+//
+// Gets a shared buffer for the given data, reusing a buffer from the pool if
+// one with identical contents exists.
+//
+std::shared_ptr<char const[]> intern(char const* data, size_t size) {
+    auto &_pool = pool();
+    auto &entries = _pool.entries;
+    auto const hash = std::hash<std::string_view>{}(std::string_view(data, size));
+
+    auto range = entries.equal_range(hash);
+    for (auto iter = range.first; iter != range.second; ) {
+        auto shared = iter->second.data.lock();
+        if (!shared) {
+            // buffer no longer in use, remove it
+            iter = entries.erase(iter);
+            continue;
+        }
+        if (iter->second.size == size && std::equal(data, data + size, shared.get())) {
+            return shared;
+        }
+        ++iter;
+    }
+
+    if (entries.size() >= _pool.sweepAt) {
+        sweep(_pool);
+    }
+
+    std::shared_ptr<char[]> buf(new char[size]);
+    std::copy_n(data, size, buf.get());
+    entries.emplace(hash, PoolEntry{ buf, size });
+    return buf;
+}
+
 }
 
 PatternClip::PatternClip() :
     mData(),
+    mDataSize(0),
+    mCompacted(false),
     mLocation()
 {
 }
@@ -115,23 +248,19 @@ PatternClip::PatternClip(PatternClip &&clip) noexcept :
 }
 
 PatternClip& PatternClip::operator=(PatternClip const& clip) {
-    if (clip.mData) {
-        auto iter = clip.mLocation.iterator();
-        auto size = TU::getRowLength(iter) * iter.rows();
-        mData = std::make_unique<char[]>(size);
-        std::copy_n(clip.mData.get(), size, mData.get());
-        mLocation = clip.mLocation;
-    } else {
-        mData.reset();
-        mLocation = PatternSelection();
-    }
-
+    // clip data is never modified, only replaced, so we can just share it
+    mData = clip.mData;
+    mDataSize = clip.mDataSize;
+    mCompacted = clip.mCompacted;
+    mLocation = clip.mLocation;
     return *this;
 }
 
 PatternClip& PatternClip::operator=(PatternClip &&clip) noexcept {
     // move the clips data to ours, resetting the clip's data
     mData = std::exchange(clip.mData, nullptr);
+    mDataSize = std::exchange(clip.mDataSize, 0);
+    mCompacted = std::exchange(clip.mCompacted, false);
     mLocation = clip.mLocation;
     clip.mLocation = {};
     return *this;
@@ -163,10 +292,59 @@ void PatternClip::paste(trackerboy::Pattern &dest, PatternCursor pos, bool mix)
 
 }
 
+void PatternClip::compact() {
+    if (!mData || mCompacted) {
+        return;
+    }
+
+    auto buf = std::make_unique<char[]>(mDataSize * 2);
+    auto const size = TU::compress(mData.get(), mDataSize, buf.get());
+    if (size < mDataSize) {
+        mData = TU::intern(buf.get(), size);
+        mDataSize = size;
+        mCompacted = true;
+    } else {
+        // incompressible, but we can still share it
+        mData = TU::intern(mData.get(), mDataSize);
+    }
+}
+
+void PatternClip::clear() {
+    *this = PatternClip();
+}
+
+size_t PatternClip::memoryUsage() const {
+    if (mData) {
+        return mDataSize / (size_t)std::max(1l, mData.use_count());
+    } else {
+        return 0;
+    }
+}
+
+size_t PatternClip::rawSize() const {
+    auto const iter = mLocation.iterator();
+    return TU::getRowLength(iter) * iter.rows();
+}
+
+char const* PatternClip::rawData(std::unique_ptr<char[]> &scratch) const {
+    if (mCompacted) {
+        auto const size = rawSize();
+        scratch = std::make_unique<char[]>(size);
+        TU::expand(mData.get(), mDataSize, scratch.get(), size);
+        return scratch.get();
+    } else {
+        return mData.get();
+    }
+}
+
 void PatternClip::pasteImpl(trackerboy::Pattern &dest, std::optional<PatternCursor> pos, bool mixPaste) const {
     
+    if (!mData) {
+        return;
+    }
 
-    char const* bufAtRowStart = mData.get();
+    std::unique_ptr<char[]> scratch;
+    char const* bufAtRowStart = rawData(scratch);
     auto iter = mLocation.iterator();
     auto const rowLength = TU::getRowLength(iter);
     
@@ -274,9 +452,9 @@ void PatternClip::save(trackerboy::Pattern const& src, PatternSelection region)
 
     auto const bufsize = rowLength * iter.rows();
     Q_ASSERT(bufsize != 0);
-    mData = std::make_unique<char[]>(bufsize);
+    std::shared_ptr<char[]> data(new char[bufsize]);
 
-    auto bufAtRowStart = mData.get();
+    auto bufAtRowStart = data.get();
     for (auto track = iter.trackStart(); track <= iter.trackEnd(); ++track) {
         auto const tmeta = iter.getTrackMeta(track);
         auto const offset = TU::columnToOffset(tmeta.columnStart());
@@ -297,18 +475,26 @@ void PatternClip::save(trackerboy::Pattern const& src, PatternSelection region)
         // advance to next track
         bufAtRowStart += length;
     }
+
+    mData = std::move(data);
+    mDataSize = bufsize;
+    mCompacted = false;
 }
 
 void PatternClip::toMime(QMimeData *mime) const {
 
-    auto iter = mLocation.iterator();
-    size_t datasize = TU::getRowLength(iter) * iter.rows();
+    if (!mData) {
+        return;
+    }
+
+    size_t datasize = rawSize();
     QByteArray arr((int)(sizeof(mLocation) + datasize), '\0');
 
     auto dataptr = arr.data();
     std::copy_n(reinterpret_cast<const char*>(&mLocation), sizeof(mLocation), dataptr);
     dataptr += sizeof(mLocation);
-    std::copy_n(mData.get(), datasize, dataptr);
+    std::unique_ptr<char[]> scratch;
+    std::copy_n(rawData(scratch), datasize, dataptr);
 
     mime->setData(MIME_TYPE, arr);
 }
@@ -335,8 +521,11 @@ bool PatternClip::fromMime(QMimeData const* mime) {
     auto iter = mLocation.iterator();
     size_t datasize = TU::getRowLength(iter) * iter.rows();
     if (datasize == size) {
-        mData = std::make_unique<char[]>(datasize);
-        std::copy_n(dataptr, datasize, mData.get());
+        std::shared_ptr<char[]> data(new char[datasize]);
+        std::copy_n(dataptr, datasize, data.get());
+        mData = std::move(data);
+        mDataSize = datasize;
+        mCompacted = false;
         return true;
     } else {
         // the clipped data buffer size does not match the size of the clip!
@@ -352,13 +541,18 @@ bool operator==(PatternClip const& lhs, PatternClip const& rhs) noexcept {
 
         // check if the selection is the same
         if (leftIter.start() == rightIter.start() && leftIter.end() == rightIter.end()) {
-            auto leftsize = TU::getRowLength(leftIter) * leftIter.rows();
-            auto rightsize = TU::getRowLength(rightIter) * rightIter.rows();
+            auto leftsize = lhs.rawSize();
+            auto rightsize = rhs.rawSize();
             if (leftsize != rightsize) {
                 return false;
+            } else if (lhs.mData == rhs.mData) {
+                // shared data
+                return true;
             } else {
                 // determine if the clipped data is the same
-                return std::equal(lhs.mData.get(), lhs.mData.get() + leftsize, rhs.mData.get());
+                std::unique_ptr<char[]> leftScratch, rightScratch;
+                auto leftData = lhs.rawData(leftScratch);
+                return std::equal(leftData, leftData + leftsize, rhs.rawData(rightScratch));
             }
         } else {
             return false;
@@ -81,6 +81,25 @@ public:
     //
     bool fromMime(QMimeData const* data);
 
+    //
+    // Compacts the clip data for long-term storage, such as in the undo
+    // history. Runs of empty cells are run-length encoded and the resulting
+    // buffer is shared with any other compacted clip having identical data.
+    // The clip remains fully usable, compacted data is expanded on demand.
+    //
+    void compact();
+
+    //
+    // Releases the clip data, the clip will no longer have data afterwards.
+    //
+    void clear();
+
+    //
+    // Gets the amount of heap memory, in bytes, used by this clip's data.
+    // Data shared between multiple clips is divided evenly among them.
+    //
+    size_t memoryUsage() const;
+
     friend bool operator==(PatternClip const& lhs, PatternClip const& rhs) noexcept;
     friend bool operator!=(PatternClip const& lhs, PatternClip const& rhs) noexcept;
 
@@ -88,7 +107,22 @@ private:
 
     void pasteImpl(trackerboy::Pattern &dest, std::optional<PatternCursor> pos, bool mixPaste) const;
 
-    std::unique_ptr<char[]> mData;
+    //
+    // Gets the uncompressed clip data. If the clip is compacted, the data
+    // is expanded into the given scratch buffer.
+    //
+    char const* rawData(std::unique_ptr<char[]> &scratch) const;
+
+    //
+    // Size, in bytes, of the uncompressed clip data
+    //
+    size_t rawSize() const;
+
+    // clip data is immutable once saved, so copies of the clip share it
+    std::shared_ptr<char const[]> mData;
+    // size of mData, which is less than rawSize() when compacted
+    size_t mDataSize;
+    bool mCompacted;
     PatternSelection mLocation;
 
 
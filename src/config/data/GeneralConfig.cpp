@@ -7,6 +7,7 @@ GeneralConfig::GeneralConfig() :
     mPageStep(1),
     mAutosave(false),
     mAutosaveInterval(1),
+    mUndoMemoryLimit(1),
     mOptions()
 {
 }
@@ -35,6 +36,14 @@ void GeneralConfig::setAutosaveInterval(int interval) {
     mAutosaveInterval = interval;
 }
 
+int GeneralConfig::undoMemoryLimit() const {
+    return mUndoMemoryLimit;
+}
+
+void GeneralConfig::setUndoMemoryLimit(int limit) {
+    mUndoMemoryLimit = limit;
+}
+
 bool GeneralConfig::hasOption(Options option) const {
     return mOptions.test(option);
 }
@@ -61,6 +70,8 @@ void GeneralConfig::readSettings(QSettings &settings) {
     // default autosave interval is 30 seconds
     mAutosaveInterval = settings.value(Keys::autosaveInterval, 30).toInt();
     mPageStep = settings.value(Keys::pageStep, 4).toInt();
+    // default undo memory limit is 64 MiB
+    mUndoMemoryLimit = settings.value(Keys::undoMemoryLimit, 64).toInt();
 
     settings.endGroup();
 }
@@ -72,6 +83,7 @@ void GeneralConfig::writeSettings(QSettings &settings) const {
     settings.setValue(Keys::autosave, mAutosave);
     settings.setValue(Keys::autosaveInterval, mAutosaveInterval);
     settings.setValue(Keys::pageStep, mPageStep);
+    settings.setValue(Keys::undoMemoryLimit, mUndoMemoryLimit);
     auto writeOption = [this, &settings](Options option, QString const& key) {
         settings.setValue(key, mOptions.test(option));
     };
@@ -31,6 +31,12 @@ public:
     int autosaveInterval() const;
     void setAutosaveInterval(int interval);
 
+    //
+    // Memory limit for the undo history of a module, in MiB
+    //
+    int undoMemoryLimit() const;
+    void setUndoMemoryLimit(int limit);
+
     bool hasOption(Options option) const;
     void setOption(Options option, bool enabled);
 
@@ -45,6 +51,8 @@ private:
     bool mAutosave;
     int mAutosaveInterval;
 
+    int mUndoMemoryLimit;
+
     std::bitset<OptionCount> mOptions;
 
 };
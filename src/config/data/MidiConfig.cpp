@@ -4,6 +4,8 @@
 
 #include <QtDebug>
 
+#include <algorithm>
+
 #define TU MidiConfigTU
 namespace TU {
 
@@ -16,7 +18,8 @@ static const auto LOG_PREFIX = "[MidiConfig]";
 MidiConfig::MidiConfig() :
     mEnabled(false),
     mBackendIndex(-1),
-    mPortIndex(-1)
+    mPortIndex(-1),
+    mRecordQuantize(MIN_RECORD_QUANTIZE)
 {
 }
 
@@ -33,6 +36,10 @@ int MidiConfig::portIndex() const {
     return mPortIndex;
 }
 
+int MidiConfig::recordQuantize() const {
+    return mRecordQuantize;
+}
+
 void MidiConfig::setEnabled(bool enabled) {
     mEnabled = enabled;
 }
@@ -49,9 +56,14 @@ void MidiConfig::setPortIndex(int index) {
     }
 }
 
+void MidiConfig::setRecordQuantize(int rows) {
+    mRecordQuantize = std::clamp(rows, MIN_RECORD_QUANTIZE, MAX_RECORD_QUANTIZE);
+}
+
 void MidiConfig::readSettings(QSettings &settings, MidiEnumerator &enumerator) {
     settings.beginGroup(Keys::Midi);
     mEnabled = settings.value(Keys::enabled, false).toBool();
+    setRecordQuantize(settings.value(Keys::recordQuantize, MIN_RECORD_QUANTIZE).toInt());
 
 
     auto apiName = settings.value(Keys::api).toString();
@@ -66,8 +78,13 @@ void MidiConfig::readSettings(QSettings &settings, MidiEnumerator &enumerator) {
             mPortIndex = -1;
         } else {
             auto device = settings.value(Keys::deviceName);
-            enumerator.populate(mBackendIndex);
+            enumerator.prepare(mBackendIndex);
             mPortIndex = enumerator.deserializeDevice(mBackendIndex, device);
+            if (mPortIndex == -1 && enumerator.isCached(mBackendIndex) && !device.toString().isEmpty()) {
+                // the device may have been added since the cache was saved
+                enumerator.populate(mBackendIndex);
+                mPortIndex = enumerator.deserializeDevice(mBackendIndex, device);
+            }
             if (mPortIndex == -1 && !device.toString().isEmpty()) {
                 qWarning() << TU::LOG_PREFIX << "Could not find MIDI port, please select a new device";
             }
@@ -90,6 +107,7 @@ void MidiConfig::writeSettings(QSettings &settings, MidiEnumerator const& enumer
         settings.setValue(Keys::api, enumerator.backendNames().at(mBackendIndex));
     }
     settings.setValue(Keys::deviceName, enumerator.serializeDevice(mBackendIndex, mPortIndex));
+    settings.setValue(Keys::recordQuantize, mRecordQuantize);
     
     settings.endGroup();
 }
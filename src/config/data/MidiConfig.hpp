@@ -9,6 +9,9 @@ class MidiConfig {
 
 public:
 
+    static constexpr int MIN_RECORD_QUANTIZE = 1;
+    static constexpr int MAX_RECORD_QUANTIZE = 16;
+
     MidiConfig();
 
     bool isEnabled() const;
@@ -17,12 +20,19 @@ public:
 
     int portIndex() const;
 
+    //
+    // Grid, in rows, that notes recorded during playback are quantized to
+    //
+    int recordQuantize() const;
+
     void setEnabled(bool enabled);
 
     void setBackendIndex(int index);
 
     void setPortIndex(int index);
 
+    void setRecordQuantize(int rows);
+
     void readSettings(QSettings &settings, MidiEnumerator &enumerator);
 
     void writeSettings(QSettings &settings, MidiEnumerator const& enumerator) const;
@@ -32,6 +42,7 @@ private:
     bool mEnabled;
     int mBackendIndex;
     int mPortIndex;
+    int mRecordQuantize;
 
 
 };
@@ -17,7 +17,8 @@ SoundConfig::SoundConfig() :
     mDeviceIndex(0),
     mSamplerateIndex(4),
     mLatency(40),
-    mPeriod(5)
+    mPeriod(5),
+    mLowLatencyPreview(true)
 {
 }
 
@@ -45,6 +46,10 @@ int SoundConfig::period() const {
     return mPeriod;
 }
 
+bool SoundConfig::lowLatencyPreview() const {
+    return mLowLatencyPreview;
+}
+
 void SoundConfig::setBackendIndex(int index) {
     if (index >= -1) {
         mBackendIndex = index;
@@ -92,6 +97,10 @@ void SoundConfig::setPeriod(int period) {
     mPeriod = period;
 }
 
+void SoundConfig::setLowLatencyPreview(bool enabled) {
+    mLowLatencyPreview = enabled;
+}
+
 void SoundConfig::readSettings(QSettings &settings, AudioEnumerator &enumerator) {
     settings.beginGroup(Keys::Sound);
 
@@ -114,10 +123,15 @@ void SoundConfig::readSettings(QSettings &settings, AudioEnumerator &enumerator)
     }
 
     setBackendIndex(backend);
-    enumerator.populate(backend);
+    enumerator.prepare(backend);
 
     auto deviceId = settings.value(Keys::deviceId);
     int device = enumerator.deserializeDevice(backend, deviceId);
+    if (device == -1 && enumerator.isCached(backend)) {
+        // the device may have been added since the cache was saved
+        enumerator.populate(backend);
+        device = enumerator.deserializeDevice(backend, deviceId);
+    }
     if (device == -1) {
         qWarning() << TU::LOG_PREFIX << "last configured device not available, using default";
         device = 0;
@@ -127,6 +141,7 @@ void SoundConfig::readSettings(QSettings &settings, AudioEnumerator &enumerator)
     setSamplerate(settings.value(Keys::samplerate, samplerate()).toInt());
     setLatency(settings.value(Keys::latency, mLatency).toInt());
     setPeriod(settings.value(Keys::period, mPeriod).toInt());
+    setLowLatencyPreview(settings.value(Keys::lowLatencyPreview, mLowLatencyPreview).toBool());
 
     settings.endGroup();
 }
@@ -147,6 +162,7 @@ void SoundConfig::writeSettings(QSettings &settings, AudioEnumerator const& enum
     settings.setValue(Keys::samplerate, samplerate());
     settings.setValue(Keys::latency, mLatency);
     settings.setValue(Keys::period, mPeriod);
+    settings.setValue(Keys::lowLatencyPreview, mLowLatencyPreview);
 
     settings.endGroup();
 }
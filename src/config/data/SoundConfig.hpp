@@ -23,6 +23,7 @@ public:
     int samplerateIndex() const;
     int latency() const;
     int period() const;
+    bool lowLatencyPreview() const;
 
     void setBackendIndex(int index);
 
@@ -35,6 +36,8 @@ public:
     void setLatency(int latency);
 
     void setPeriod(int period);
+
+    void setLowLatencyPreview(bool enabled);
     
     void readSettings(QSettings &settings, AudioEnumerator &enumerator);
 
@@ -47,4 +50,5 @@ private:
     int mSamplerateIndex;        // index of the current samplerate
     int mLatency;                // latency, or internal buffer size, in milliseconds
     int mPeriod;                 // period, in milliseconds
+    bool mLowLatencyPreview;     // previews discard queued samples when music is not playing
 };
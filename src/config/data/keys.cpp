@@ -7,6 +7,8 @@ namespace Keys {
 // can't use a macro since QStringLiteral is a macro
 // so unfortunately we have to write everything out manually
 
+QString const Audio { QStringLiteral("Audio") };
+QString const DeviceCache { QStringLiteral("DeviceCache") };
 QString const Fonts { QStringLiteral("Fonts") };
 QString const General { QStringLiteral("General") };
 QString const Midi { QStringLiteral("Midi") };
@@ -33,9 +35,12 @@ QString const key { QStringLiteral("key") };
 QString const rownoHex ( QStringLiteral("rownoHex") );
 QString const samplerate { QStringLiteral("samplerate") };
 QString const period { QStringLiteral("period") };
+QString const recordQuantize { QStringLiteral("recordQuantize") };
 QString const latency { QStringLiteral("latency") };
+QString const lowLatencyPreview { QStringLiteral("lowLatencyPreview") };
 QString const deviceId { QStringLiteral("deviceId") };
 QString const noteCut { QStringLiteral("noteCut") };
+QString const undoMemoryLimit { QStringLiteral("undoMemoryLimit") };
 
 
 }
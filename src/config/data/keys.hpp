@@ -18,6 +18,8 @@
 namespace Keys {
 
 // groups
+extern QString const Audio;
+extern QString const DeviceCache;
 extern QString const Fonts;
 extern QString const General;
 extern QString const Midi;
@@ -44,9 +46,12 @@ extern QString const key;
 extern QString const rownoHex;
 extern QString const samplerate;
 extern QString const period;
+extern QString const recordQuantize;
 extern QString const latency;
+extern QString const lowLatencyPreview;
 extern QString const deviceId;
 extern QString const noteCut;
+extern QString const undoMemoryLimit;
 
 }
 
@@ -68,8 +68,20 @@ GeneralConfigTab::GeneralConfigTab(GeneralConfig const& config, QWidget *parent)
     pageStepLayout->addWidget(mPageStepSpin);
     pageStepGroup->setLayout(pageStepLayout);
 
+    // undo history
+    auto undoGroup = new QGroupBox(tr("Undo history"));
+    auto undoLayout = new QHBoxLayout;
+    undoLayout->addWidget(new QLabel(tr("Memory limit")));
+    mUndoMemoryLimitSpin = new QSpinBox;
+    mUndoMemoryLimitSpin->setRange(1, 1024);
+    mUndoMemoryLimitSpin->setValue(config.undoMemoryLimit());
+    mUndoMemoryLimitSpin->setSuffix(tr(" MiB"));
+    undoLayout->addWidget(mUndoMemoryLimitSpin);
+    undoGroup->setLayout(undoLayout);
+
     sideLayout->addWidget(mAutosaveGroup);
     sideLayout->addWidget(pageStepGroup);
+    sideLayout->addWidget(undoGroup);
     sideLayout->addStretch(1);
 
     layout->addWidget(optionGroup, 1);
@@ -89,6 +101,7 @@ GeneralConfigTab::GeneralConfigTab(GeneralConfig const& config, QWidget *parent)
     lazyconnect(mAutosaveGroup, toggled, this, setDirty<Config::CategoryGeneral>);
     connect(mAutosaveIntervalSpin, qOverload<int>(&QSpinBox::valueChanged), this, &GeneralConfigTab::setDirty<Config::CategoryGeneral>);
     connect(mPageStepSpin, qOverload<int>(&QSpinBox::valueChanged), this, &GeneralConfigTab::setDirty<Config::CategoryGeneral>);
+    connect(mUndoMemoryLimitSpin, qOverload<int>(&QSpinBox::valueChanged), this, &GeneralConfigTab::setDirty<Config::CategoryGeneral>);
     
 }
 
@@ -96,6 +109,7 @@ void GeneralConfigTab::apply(GeneralConfig &config) {
     config.setAutosave(mAutosaveGroup->isChecked());
     config.setAutosaveInterval(mAutosaveIntervalSpin->value());
     config.setPageStep(mPageStepSpin->value());
+    config.setUndoMemoryLimit(mUndoMemoryLimitSpin->value());
 
     for (int i = 0; i < GeneralConfig::OptionCount; ++i) {
         auto item = mOptionList->item(i);
@@ -29,4 +29,6 @@ private:
 
     QSpinBox *mPageStepSpin;
 
+    QSpinBox *mUndoMemoryLimitSpin;
+
 };
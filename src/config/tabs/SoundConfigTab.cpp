@@ -5,6 +5,7 @@
 #include "midi/MidiEnumerator.hpp"
 #include "utils/connectutils.hpp"
 
+#include <QCheckBox>
 #include <QComboBox>
 #include <QGridLayout>
 #include <QGroupBox>
@@ -118,12 +119,27 @@ SoundConfigTab::SoundConfigTab(
     mSamplerateCombo = new QComboBox;
     audioLayout->addWidget(mSamplerateCombo, 2, 1);
 
+    // row 3, low latency previews
+    mLowLatencyPreviewCheck = new QCheckBox(tr("Low latency previews"));
+    mLowLatencyPreviewCheck->setToolTip(tr("Previews skip audio already in the buffer when music is not playing"));
+    audioLayout->addWidget(mLowLatencyPreviewCheck, 3, 0, 1, 2);
+
     audioGroup->setLayout(audioLayout);
 
     mMidiGroup = new DeviceGroup(tr("MIDI Input"));
     mMidiGroup->setCheckable(true);
     mMidiGroup->setChecked(midiConfig.isEnabled());
 
+    // row 3 of the MIDI group, record quantize
+    auto midiLayout = static_cast<QGridLayout*>(mMidiGroup->layout());
+    midiLayout->addWidget(new QLabel(tr("Record quantize")), 3, 0);
+    mRecordQuantizeSpin = new QSpinBox;
+    mRecordQuantizeSpin->setRange(MidiConfig::MIN_RECORD_QUANTIZE, MidiConfig::MAX_RECORD_QUANTIZE);
+    mRecordQuantizeSpin->setSuffix(tr(" rows"));
+    mRecordQuantizeSpin->setToolTip(tr("Notes recorded during playback are rounded to the nearest multiple of this many rows"));
+    mRecordQuantizeSpin->setValue(midiConfig.recordQuantize());
+    midiLayout->addWidget(mRecordQuantizeSpin, 3, 1);
+
     auto layout = new QVBoxLayout;
     layout->addWidget(mAudioGroup);
     layout->addWidget(audioGroup);
@@ -143,6 +159,7 @@ SoundConfigTab::SoundConfigTab(
     mSamplerateCombo->setCurrentIndex(soundConfig.samplerateIndex());
     mLatencySpin->setValue(soundConfig.latency());
     mPeriodSpin->setValue(soundConfig.period());
+    mLowLatencyPreviewCheck->setChecked(soundConfig.lowLatencyPreview());
 
     auto setupTimeSpinbox = [](QSpinBox &spin, int min, int max) {
         spin.setSuffix(tr(" ms"));
@@ -158,6 +175,7 @@ SoundConfigTab::SoundConfigTab(
     connect(mSamplerateCombo, qOverload<int>(&QComboBox::currentIndexChanged), this, &SoundConfigTab::setDirty<Config::CategorySound>);
     connect(mLatencySpin, qOverload<int>(&QSpinBox::valueChanged), this, &SoundConfigTab::setDirty<Config::CategorySound>);
     connect(mPeriodSpin, qOverload<int>(&QSpinBox::valueChanged), this, &SoundConfigTab::setDirty<Config::CategorySound>);
+    lazyconnect(mLowLatencyPreviewCheck, toggled, this, setDirty<Config::CategorySound>);
 
     connect(mAudioGroup->mApiCombo, qOverload<int>(&QComboBox::currentIndexChanged), this, &SoundConfigTab::audioApiChanged);
     connect(mAudioGroup->mDeviceCombo, qOverload<int>(&QComboBox::currentIndexChanged), this, &SoundConfigTab::setDirty<Config::CategorySound>);
@@ -166,6 +184,7 @@ SoundConfigTab::SoundConfigTab(
     lazyconnect(mMidiGroup, toggled, this, setDirty<Config::CategoryMidi>);
     connect(mMidiGroup->mApiCombo, qOverload<int>(&QComboBox::currentIndexChanged), this, &SoundConfigTab::midiApiChanged);
     connect(mMidiGroup->mDeviceCombo, qOverload<int>(&QComboBox::currentIndexChanged), this, &SoundConfigTab::setDirty<Config::CategoryMidi>);
+    connect(mRecordQuantizeSpin, qOverload<int>(&QSpinBox::valueChanged), this, &SoundConfigTab::setDirty<Config::CategoryMidi>);
     lazyconnect(mMidiGroup->mRescanButton, clicked, this, midiRescan);
 }
 
@@ -176,6 +195,7 @@ void SoundConfigTab::apply(SoundConfig &soundConfig) {
 
     soundConfig.setLatency(mLatencySpin->value());
     soundConfig.setPeriod(mPeriodSpin->value());
+    soundConfig.setLowLatencyPreview(mLowLatencyPreviewCheck->isChecked());
 
     clean();
 }
@@ -183,6 +203,7 @@ void SoundConfigTab::apply(SoundConfig &soundConfig) {
 void SoundConfigTab::apply(MidiConfig &midiConfig) {
     auto const enabled = mMidiGroup->isChecked();
     midiConfig.setEnabled(enabled);
+    midiConfig.setRecordQuantize(mRecordQuantizeSpin->value());
     if (enabled) {
         midiConfig.setBackendIndex(mMidiGroup->mApiCombo->currentIndex());
         midiConfig.setPortIndex(mMidiGroup->mDeviceCombo->currentIndex());
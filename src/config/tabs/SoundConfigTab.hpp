@@ -5,6 +5,7 @@
 class AudioEnumerator;
 class MidiEnumerator;
 
+class QCheckBox;
 class QComboBox;
 class QGroupBox;
 class QSpinBox;
@@ -60,6 +61,8 @@ private:
     QSpinBox *mLatencySpin;
     QSpinBox *mPeriodSpin;
     QComboBox *mSamplerateCombo;
+    QCheckBox *mLowLatencyPreviewCheck;
+    QSpinBox *mRecordQuantizeSpin;
 
 
 };
@@ -0,0 +1,156 @@
+
+#include "core/BulkOperation.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bitset>
+#include <cmath>
+#include <thread>
+
+#define TU BulkOperationTU
+namespace TU {
+
+//
+// Songs with fewer tracks than this are processed on the calling thread, as
+// spawning workers would cost more than the operation itself.
+//
+constexpr size_t PARALLEL_THRESHOLD = 32;
+
+struct TrackRef {
+    trackerboy::ChType channel;
+    uint8_t trackId;
+    trackerboy::Track const *track;
+};
+
+}
+
+BulkOperation::BulkOperation() :
+    type(Type::transpose),
+    amount(0),
+    instrumentFrom(-1),
+    instrumentTo(0),
+    orderStart(0),
+    orderEnd(-1),
+    channels{ true, true, true, true }
+{
+}
+
+bool BulkOperation::apply(trackerboy::ChType ch, trackerboy::TrackRow &rowdata) const {
+    switch (type) {
+        case Type::transpose: {
+            auto const note = rowdata.note;
+            rowdata.transpose(amount);
+            return note != rowdata.note;
+        }
+        case Type::replaceInstrument: {
+            auto const instrument = rowdata.queryInstrument();
+            if (instrument && (instrumentFrom == -1 || *instrument == instrumentFrom) && *instrument != instrumentTo) {
+                rowdata.setInstrument((uint8_t)instrumentTo);
+                return true;
+            }
+            return false;
+        }
+        case Type::scaleVolume: {
+            // Exx on CH3 selects a waveform, not a volume envelope
+            if (ch == trackerboy::ChType::ch3) {
+                return false;
+            }
+            bool changed = false;
+            for (auto &effect : rowdata.effects) {
+                if (effect.type == trackerboy::EffectType::setEnvelope) {
+                    auto const volume = effect.param >> 4;
+                    auto const scaled = std::clamp((int)std::lround(volume * amount / 100.0), 0, 15);
+                    auto const param = (uint8_t)((scaled << 4) | (effect.param & 0xF));
+                    if (param != effect.param) {
+                        effect.param = param;
+                        changed = true;
+                    }
+                }
+            }
+            return changed;
+        }
+    }
+    return false;
+}
+
+std::vector<BulkOperation::Change> BulkOperation::changes(trackerboy::Song const& song) const {
+
+    // missing tracks are created in the snapshot instead of the song
+    trackerboy::Song snapshot(song);
+    auto &order = snapshot.order();
+    int const last = (int)order.size() - 1;
+    int const start = std::clamp(orderStart, 0, last);
+    int const end = orderEnd == -1 ? last : std::clamp(orderEnd, start, last);
+
+    // gather the unique tracks in the range. Getting a track may create it
+    // (in the snapshot), so this must be done before any workers are started
+    std::vector<TU::TrackRef> tracks;
+    std::array<std::bitset<256>, 4> visited;
+    for (int i = start; i <= end; ++i) {
+        auto const& row = order[i];
+        for (size_t ch = 0; ch < row.size(); ++ch) {
+            if (!channels[ch] || visited[ch].test(row[ch])) {
+                continue;
+            }
+            visited[ch].set(row[ch]);
+            auto const channel = static_cast<trackerboy::ChType>(ch);
+            tracks.push_back({ channel, row[ch], &snapshot.patterns().getTrack(channel, row[ch]) });
+        }
+    }
+
+    auto process = [this](TU::TrackRef const& ref, std::vector<Change> &out) {
+        auto const& track = *ref.track;
+        auto const rows = track.size();
+        for (size_t row = 0; row < rows; ++row) {
+            auto rowdata = track[(uint16_t)row];
+            if (apply(ref.channel, rowdata)) {
+                out.push_back({ ref.channel, ref.trackId, (uint8_t)row, track[(uint16_t)row], rowdata });
+            }
+        }
+    };
+
+    std::vector<Change> result;
+    auto const workerCount = std::min((size_t)std::max(1u, std::thread::hardware_concurrency()), tracks.size());
+    if (tracks.size() < TU::PARALLEL_THRESHOLD || workerCount < 2) {
+        for (auto const& ref : tracks) {
+            process(ref, result);
+        }
+        return result;
+    }
+
+    // each worker claims the next unprocessed track, with results stored
+    // per track so that the output order does not depend on scheduling
+    std::vector<std::vector<Change>> trackChanges(tracks.size());
+    std::atomic_size_t next = 0;
+    auto worker = [&]() {
+        for (;;) {
+            auto const index = next.fetch_add(1, std::memory_order_relaxed);
+            if (index >= tracks.size()) {
+                break;
+            }
+            process(tracks[index], trackChanges[index]);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(workerCount - 1);
+    for (size_t i = 1; i < workerCount; ++i) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : workers) {
+        thread.join();
+    }
+
+    size_t total = 0;
+    for (auto const& changes : trackChanges) {
+        total += changes.size();
+    }
+    result.reserve(total);
+    for (auto const& changes : trackChanges) {
+        result.insert(result.end(), changes.begin(), changes.end());
+    }
+    return result;
+}
+
+#undef TU
@@ -0,0 +1,66 @@
+
+#pragma once
+
+#include "trackerboy/data/Song.hpp"
+#include "trackerboy/data/TrackRow.hpp"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+//
+// Describes an edit applied to every track row in a range of a song's order,
+// ie transposing all notes in the song. Tracks shared by multiple order rows
+// are only edited once.
+//
+struct BulkOperation {
+
+    enum class Type {
+        transpose,          // transpose notes by amount semitones
+        replaceInstrument,  // replace instrumentFrom with instrumentTo
+        scaleVolume         // scale the initial volume of Exx effects by amount percent
+    };
+
+    //
+    // A single track row changed by the operation
+    //
+    struct Change {
+        trackerboy::ChType channel;
+        uint8_t trackId;
+        uint8_t row;
+        trackerboy::TrackRow before;
+        trackerboy::TrackRow after;
+    };
+
+    Type type;
+    // semitones for transpose, percentage for scaleVolume
+    int amount;
+    // instrument to replace, -1 for any instrument
+    int instrumentFrom;
+    int instrumentTo;
+    // range of order rows to apply the operation to, inclusive. An orderEnd
+    // of -1 selects the last order row.
+    int orderStart;
+    int orderEnd;
+    // channels to apply the operation to
+    std::array<bool, 4> channels;
+
+    BulkOperation();
+
+    //
+    // Applies the operation to the given row data. Returns true if the row
+    // was modified.
+    //
+    bool apply(trackerboy::ChType ch, trackerboy::TrackRow &rowdata) const;
+
+    //
+    // Determines the changes the operation makes to the given song, without
+    // modifying it. Tracks are processed in parallel on large songs.
+    //
+    // The changes are computed from a copy of the song, as getting a track
+    // that does not exist creates it. The song is only read, so the module
+    // does not need to be locked when called from the thread that edits it.
+    //
+    std::vector<Change> changes(trackerboy::Song const& song) const;
+
+};
@@ -0,0 +1,85 @@
+
+#include "core/DeviceScanner.hpp"
+
+DeviceScanner::DeviceScanner(AudioEnumerator &audio, MidiEnumerator &midi, QObject *parent) :
+    QObject(parent),
+    mAudio(audio),
+    mMidi(midi),
+    mThread(nullptr),
+    mResult(),
+    mAudioBackend(-1),
+    mMidiBackend(-1)
+{
+}
+
+DeviceScanner::~DeviceScanner() {
+    if (mThread) {
+        // the results are discarded, the enumerators may already be gone
+        mThread->wait();
+        delete mThread;
+    }
+}
+
+bool DeviceScanner::isScanning() const {
+    return mThread != nullptr;
+}
+
+void DeviceScanner::scan(int audioBackend, int midiBackend) {
+    if (mThread) {
+        return;
+    }
+
+    std::shared_ptr<ma_context> context;
+    if (mAudio.backendIsAvailable(audioBackend)) {
+        mAudioBackend = audioBackend;
+        context = mAudio.device(audioBackend, 0).context;
+    } else {
+        mAudioBackend = -1;
+    }
+
+    mMidiBackend = (midiBackend >= 0 && midiBackend < mMidi.backends()) ? midiBackend : -1;
+    auto const probeMidi = mMidiBackend != -1;
+    auto const midiApi = mMidi.api(midiBackend);
+
+    if (!context && !probeMidi) {
+        return;
+    }
+
+    auto result = std::make_shared<Result>();
+    mResult = result;
+    mThread = QThread::create([result, context, probeMidi, midiApi]() {
+        if (context) {
+            result->audio = AudioEnumerator::probe(context.get());
+        }
+        if (probeMidi) {
+            result->midi = MidiEnumerator::probe(midiApi);
+        }
+    });
+    connect(mThread, &QThread::finished, this, &DeviceScanner::finish);
+    mThread->start(QThread::LowPriority);
+}
+
+void DeviceScanner::wait() {
+    finish();
+}
+
+void DeviceScanner::finish() {
+    if (mThread == nullptr) {
+        // already finished by wait()
+        return;
+    }
+
+    mThread->wait();
+    delete mThread;
+    mThread = nullptr;
+
+    if (mResult->audio) {
+        mAudio.setDevices(mAudioBackend, std::move(*mResult->audio));
+    }
+    if (mMidiBackend != -1) {
+        mMidi.setDevices(mMidiBackend, std::move(mResult->midi));
+    }
+    mResult.reset();
+
+    emit finished();
+}
@@ -0,0 +1,66 @@
+
+#pragma once
+
+#include "audio/AudioEnumerator.hpp"
+#include "midi/MidiEnumerator.hpp"
+
+#include <QObject>
+#include <QThread>
+
+#include <memory>
+#include <optional>
+
+//
+// Probes the devices of an audio and a MIDI backend on a worker thread, so
+// that slow backends do not hold up the GUI thread. The results are given to
+// the enumerators from the GUI thread, after which finished() is emitted.
+//
+class DeviceScanner : public QObject {
+
+    Q_OBJECT
+
+public:
+
+    explicit DeviceScanner(AudioEnumerator &audio, MidiEnumerator &midi, QObject *parent = nullptr);
+    ~DeviceScanner();
+
+    bool isScanning() const;
+
+    //
+    // Starts probing the given backends, use -1 to skip either one. The audio
+    // backend must already be initialized (see AudioEnumerator::prepare).
+    // Does nothing if a scan is in progress.
+    //
+    void scan(int audioBackend, int midiBackend);
+
+    //
+    // Blocks until the scan in progress, if any, finishes and gives its
+    // results to the enumerators. Use this before accessing the enumerators
+    // by device index, as the device lists may change when the scan finishes.
+    //
+    void wait();
+
+signals:
+
+    void finished();
+
+private:
+    Q_DISABLE_COPY(DeviceScanner)
+
+    struct Result {
+        std::optional<AudioEnumerator::DeviceList> audio;
+        std::optional<QStringList> midi;
+    };
+
+    void finish();
+
+    AudioEnumerator &mAudio;
+    MidiEnumerator &mMidi;
+
+    QThread *mThread;
+    // written by the worker thread, only accessed after it has finished
+    std::shared_ptr<Result> mResult;
+    int mAudioBackend;
+    int mMidiBackend;
+
+};
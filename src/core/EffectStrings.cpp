@@ -0,0 +1,59 @@
+
+#include "core/EffectStrings.hpp"
+
+
+namespace EffectStrings {
+
+char toChar(trackerboy::EffectType et) {
+
+    switch (et) {
+        case trackerboy::EffectType::patternGoto:
+            return 'B';
+        case trackerboy::EffectType::patternHalt:
+            return 'C';
+        case trackerboy::EffectType::patternSkip:
+            return 'D';
+        case trackerboy::EffectType::setTempo:
+            return 'F';
+        case trackerboy::EffectType::sfx:
+            return 'T';
+        case trackerboy::EffectType::setEnvelope:
+            return 'E';
+        case trackerboy::EffectType::setTimbre:
+            return 'V';
+        case trackerboy::EffectType::setPanning:
+            return 'I';
+        case trackerboy::EffectType::setSweep:
+            return 'H';
+        case trackerboy::EffectType::delayedCut:
+            return 'S';
+        case trackerboy::EffectType::delayedNote:
+            return 'G';
+        case trackerboy::EffectType::lock:
+            return 'L';
+        case trackerboy::EffectType::arpeggio:
+            return '0';
+        case trackerboy::EffectType::pitchUp:
+            return '1';
+        case trackerboy::EffectType::pitchDown:
+            return '2';
+        case trackerboy::EffectType::autoPortamento:
+            return '3';
+        case trackerboy::EffectType::vibrato:
+            return '4';
+        case trackerboy::EffectType::vibratoDelay:
+            return '5';
+        case trackerboy::EffectType::tuning:
+            return 'P';
+        case trackerboy::EffectType::noteSlideUp:
+            return 'Q';
+        case trackerboy::EffectType::noteSlideDown:
+            return 'R';
+        case trackerboy::EffectType::setGlobalVolume:
+            return 'J';
+        default:
+            return '?';
+    }
+}
+
+}
@@ -0,0 +1,18 @@
+
+#pragma once
+
+#include "trackerboy/data/TrackRow.hpp"
+
+//
+// Namespace contains conversions from an effect type to the character used
+// when displaying it (ie setTempo is 'F', arpeggio is '0')
+//
+namespace EffectStrings {
+
+//
+// Gets the character for the given effect type. '?' is returned for
+// EffectType::noEffect or an unknown type.
+//
+char toChar(trackerboy::EffectType et);
+
+}
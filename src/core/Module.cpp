@@ -1,14 +1,18 @@
 
 #include "core/Module.hpp"
+#include "core/UndoStorage.hpp"
 
+#include <algorithm>
+#include <vector>
 
-Module::Editor::Editor(Module &mod) :
-    QMutexLocker<QMutex>(&mod.mMutex)
+
+Module::Editor::Editor(Module &mod, LockSite site) :
+    ProfiledLocker(mod.mMutex, mod.mLockStats, site)
 {
 }
 
-Module::PermanentEditor::PermanentEditor(Module &mod) :
-    Editor(mod),
+Module::PermanentEditor::PermanentEditor(Module &mod, LockSite site) :
+    Editor(mod, site),
     mModule(mod)
 {
 }
@@ -16,17 +20,22 @@ Module::PermanentEditor::PermanentEditor(Module &mod) :
 Module::PermanentEditor::~PermanentEditor() {
     unlock();
     mModule.makeDirty();
+    emit mModule.usageChanged();
 }
 
 Module::Module(QObject *parent) :
     QObject(parent),
     mModule(),
     mMutex(),
+    mLockStats("Module", mMutex),
     mUndoGroup(new QUndoGroup(this)),
     mUndoStacks(),
     mSong(),
+    mUsageIndexes(),
     mPermaDirty(false),
-    mModified(false)
+    mModified(false),
+    mUndoMemoryUsage(0),
+    mUndoMemoryLimit(0)
 {
     nameFirstSong();
     reset();
@@ -44,6 +53,10 @@ Module::Module(QObject *parent) :
 void Module::clear() {
     // clear song history
     mUndoStacks.clear();
+    if (mUndoMemoryUsage) {
+        mUndoMemoryUsage = 0;
+        emit undoMemoryChanged();
+    }
 
     mModule.clear();
     nameFirstSong();
@@ -78,6 +91,10 @@ QMutex& Module::mutex() {
     return mMutex;
 }
 
+ProfiledLocker Module::lock(LockSite site) {
+    return { mMutex, mLockStats, site };
+}
+
 QUndoGroup* Module::undoGroup() {
     return mUndoGroup;
 }
@@ -88,17 +105,20 @@ QUndoStack* Module::undoStack() {
 
 void Module::reset() {
 
+    // song data was replaced, all indexes must be rebuilt
+    mUsageIndexes.clear();
     setSong(0);
     clean();
+    emit usageChanged();
     emit reloaded();
 }
 
-Module::Editor Module::edit() {
-    return { *this };
+Module::Editor Module::edit(LockSite site) {
+    return { *this, site };
 }
 
-Module::PermanentEditor Module::permanentEdit() {
-    return { *this };
+Module::PermanentEditor Module::permanentEdit(LockSite site) {
+    return { *this, site };
 }
 
 void Module::clean() {
@@ -130,19 +150,176 @@ void Module::setSong(int index) {
     auto iter = mUndoStacks.find(mSong.get());
     if (iter != mUndoStacks.end()) {
         // contain the existing stack
-        stack = iter->second.get();
+        stack = iter->second.stack.get();
     } else {
         // no history for this song yet, create it and add to group
         stack = new QUndoStack(this);
         mUndoGroup->addStack(stack);
-        mUndoStacks.emplace(mSong.get(), stack);
+        auto &history = mUndoStacks.emplace(
+            mSong.get(),
+            UndoHistory{ std::unique_ptr<QUndoStack>(stack), {}, 0, 0, 0 }
+        ).first->second;
+        // indexChanged is emitted for every push, merge, undo and redo
+        connect(stack, &QUndoStack::indexChanged, this,
+            [this, &history]() {
+                auto const usage = mUndoMemoryUsage;
+                syncUndoHistory(history);
+                if (trimUndoHistory() || mUndoMemoryUsage != usage) {
+                    emit undoMemoryChanged();
+                }
+                emit usageChanged();
+            });
     }
     mUndoGroup->setActiveStack(stack);
     emit songChanged();
 }
 
 void Module::removeHistory(trackerboy::Song *song) {
-    mUndoStacks.erase(song);
+    auto iter = mUndoStacks.find(song);
+    if (iter != mUndoStacks.end()) {
+        auto const usage = iter->second.usage;
+        mUndoStacks.erase(iter);
+        if (usage) {
+            mUndoMemoryUsage -= usage;
+            emit undoMemoryChanged();
+        }
+    }
+    mUsageIndexes.erase(song);
+    emit usageChanged();
+}
+
+size_t Module::undoMemoryUsage() const {
+    return mUndoMemoryUsage;
+}
+
+size_t Module::undoMemoryLimit() const {
+    return mUndoMemoryLimit;
+}
+
+void Module::setUndoMemoryLimit(size_t limit) {
+    if (mUndoMemoryLimit != limit) {
+        mUndoMemoryLimit = limit;
+        trimUndoHistory();
+        emit undoMemoryChanged();
+    }
+}
+
+int Module::undoTrimmedCount(QUndoStack const* stack) const {
+    for (auto const& pair : mUndoStacks) {
+        if (pair.second.stack.get() == stack) {
+            return pair.second.trimmed;
+        }
+    }
+    return 0;
+}
+
+void Module::syncUndoHistory(UndoHistory &history) {
+    auto const stack = history.stack.get();
+    auto &usages = history.usages;
+    auto const count = stack->count();
+    auto const index = stack->index();
+    auto const lastCount = (int)usages.size();
+
+    // Only the commands between the last index and the new one were undone
+    // or redone, along with the one below them which may have been merged
+    // into. If commands were added or removed (pushed, or obsolete commands
+    // deleted by the stack), everything above that point is redone.
+    auto const from = std::max(0, std::min(history.index, index) - 1);
+    int to, lastTo;
+    if (count == lastCount) {
+        to = lastTo = std::min(count, std::max(history.index, index));
+    } else {
+        to = count;
+        lastTo = lastCount;
+    }
+
+    size_t removed = 0;
+    for (int i = from; i < lastTo; ++i) {
+        removed += usages[i];
+    }
+    usages.resize((size_t)count);
+    size_t added = 0;
+    for (int i = from; i < to; ++i) {
+        auto const usage = UndoStorage::memoryUsage(stack->command(i));
+        usages[i] = usage;
+        added += usage;
+    }
+
+    history.usage = history.usage - removed + added;
+    mUndoMemoryUsage = mUndoMemoryUsage - removed + added;
+    history.index = index;
+
+    if (history.trimmed > from) {
+        // the stack deletes obsolete commands when they are undone, so
+        // some of the trimmed commands may be gone
+        history.trimmed = from;
+        while (history.trimmed < count && stack->command(history.trimmed)->isObsolete()) {
+            ++history.trimmed;
+        }
+    }
+}
+
+bool Module::trimUndoHistory() {
+    if (mUndoMemoryLimit == 0) {
+        return false;
+    }
+
+    // trim the oldest command from the history using the most memory until
+    // we are within the limit. Only commands that have been done can be
+    // trimmed, as the redo branch is discarded by the next push anyways.
+    bool trimmed = false;
+    while (mUndoMemoryUsage > mUndoMemoryLimit) {
+        UndoHistory *largest = nullptr;
+        for (auto &pair : mUndoStacks) {
+            auto &history = pair.second;
+            if (history.trimmed < history.stack->index() && (largest == nullptr || history.usage > largest->usage)) {
+                largest = &history;
+            }
+        }
+        if (largest == nullptr) {
+            // nothing left to trim
+            break;
+        }
+
+        auto cmd = const_cast<QUndoCommand*>(largest->stack->command(largest->trimmed));
+        UndoStorage::trim(cmd);
+        auto &usage = largest->usages[largest->trimmed];
+        auto const freed = usage - UndoStorage::memoryUsage(cmd);
+        usage -= freed;
+        largest->usage -= freed;
+        mUndoMemoryUsage -= freed;
+        ++largest->trimmed;
+        trimmed = true;
+    }
+
+    return trimmed;
+}
+
+UsageIndex& Module::usageIndex() {
+    return mUsageIndexes[mSong.get()];
+}
+
+std::vector<UsageIndex::Location> Module::findUsage(UsageIndex::Kind kind, int id) {
+    return builtUsageIndex(mSong.get()).find(kind, id);
+}
+
+size_t Module::usageCount(UsageIndex::Kind kind, int id) {
+    auto &songs = mModule.songs();
+    size_t count = 0;
+    for (int i = 0; i < (int)songs.size(); ++i) {
+        count += builtUsageIndex(songs.get(i)).count(kind, id);
+    }
+    return count;
+}
+
+UsageIndex& Module::builtUsageIndex(trackerboy::Song *song) {
+    auto &index = mUsageIndexes[song];
+    if (!index.isValid()) {
+        // rebuilding may create tracks
+        auto ctx = edit();
+        index.rebuild(*song);
+    }
+    return index;
 }
 
 void Module::beginSave() {
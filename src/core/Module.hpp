@@ -1,6 +1,9 @@
 
 #pragma once
 
+#include "core/UsageIndex.hpp"
+#include "utils/LockProfiler.hpp"
+
 #include "trackerboy/data/Module.hpp"
 #include "trackerboy/data/Song.hpp"
 
@@ -12,6 +15,7 @@
 
 #include <unordered_map>
 #include <memory>
+#include <vector>
 
 //
 // Container class for a trackerboy::Module. Also contains a QMutex and
@@ -24,15 +28,15 @@ class Module : public QObject {
 public:
 
     //
-    // Editor is just a QMutexLocker subclass. This
-    // context is used for edits that can be undone, by using a QUndoCommand
-    // subclass.
+    // Editor is just a QMutexLocker subclass (profiled when lock profiling
+    // is enabled). This context is used for edits that can be undone, by
+    // using a QUndoCommand subclass.
     //
-    class Editor : public QMutexLocker<QMutex> {
+    class Editor : public ProfiledLocker {
 
         friend class Module;
 
-        Editor(Module &module);
+        Editor(Module &module, LockSite site);
     };
 
     //
@@ -47,7 +51,7 @@ public:
     private:
         friend class Module;
 
-        PermanentEditor(Module &module);
+        PermanentEditor(Module &module, LockSite site);
 
         Module &mModule;
 
@@ -81,6 +85,12 @@ public:
 
     QMutex& mutex();
 
+    //
+    // Locks the module for reading from another thread, such as the renderer.
+    // The module's mutex is unlocked when the returned locker is destructed.
+    //
+    ProfiledLocker lock(LockSite site = LockSite::current());
+
     QUndoGroup* undoGroup();
 
     QUndoStack* undoStack();
@@ -111,13 +121,13 @@ public:
     // Begins an edit operation. The module's mutex is locked and unlocked when
     // the returned editor is destructed.
     //
-    Editor edit();
+    Editor edit(LockSite site = LockSite::current());
 
     //
     // Same as edit, but sets the permanent dirty flag on destruction. Edits to
     // the document that cannot be undone should use this context.
     //
-    PermanentEditor permanentEdit();
+    PermanentEditor permanentEdit(LockSite site = LockSite::current());
 
     //
     // Sets the permanent dirty flag. 
@@ -135,6 +145,50 @@ public:
     //
     void removeHistory(trackerboy::Song *song);
 
+    //
+    // Gets the estimated amount of memory, in bytes, used by the undo history
+    // of all songs in the module.
+    //
+    size_t undoMemoryUsage() const;
+
+    //
+    // Gets the undo memory limit, in bytes. 0 is returned for no limit.
+    //
+    size_t undoMemoryLimit() const;
+
+    //
+    // Sets the undo memory limit, in bytes. When the undo history of all songs
+    // exceeds this limit, the oldest commands are trimmed until the history
+    // is within the limit. A limit of 0 disables trimming.
+    //
+    void setUndoMemoryLimit(size_t limit);
+
+    //
+    // Gets the number of commands at the bottom of the given stack that were
+    // trimmed from the undo history. Trimmed commands do nothing when undone
+    // or redone, and views of the history should hide them.
+    //
+    int undoTrimmedCount(QUndoStack const* stack) const;
+
+    // Usage -----------------------------------------------------------------
+
+    //
+    // Gets the usage index of the current song, for updating it after editing
+    // the song's pattern data. The index may not be built yet, use findUsage
+    // or usageCount for queries.
+    //
+    UsageIndex& usageIndex();
+
+    //
+    // Finds all rows in the current song using the given id.
+    //
+    std::vector<UsageIndex::Location> findUsage(UsageIndex::Kind kind, int id);
+
+    //
+    // Counts the rows using the given id in every song of the module.
+    //
+    size_t usageCount(UsageIndex::Kind kind, int id);
+
     //
     // Gets the default song name for new songs.
     //
@@ -167,23 +221,74 @@ signals:
     //
     void aboutToSave();
 
+    //
+    // Emitted when the memory usage of the undo history or its limit has
+    // changed, or when commands were trimmed from the history.
+    //
+    void undoMemoryChanged();
+
+    //
+    // Emitted after an edit that may have changed the usage counts of
+    // instruments, waveforms or effects: an undo stack push, undo or redo,
+    // a permanent edit, or a song being removed. Models caching usageCount
+    // should discard their cache.
+    //
+    void usageChanged();
+
 private:
 
     Q_DISABLE_COPY(Module)
 
+    //
+    // Undo history of a song, along with the memory usage of its commands so
+    // that the total usage can be kept without visiting every command.
+    //
+    struct UndoHistory {
+        std::unique_ptr<QUndoStack> stack;
+        // memory usage of each command in the stack, as of the last sync
+        std::vector<size_t> usages;
+        // index of the stack as of the last sync
+        int index;
+        // number of commands trimmed from the bottom of the stack
+        int trimmed;
+        // sum of usages
+        size_t usage;
+    };
+
     void nameFirstSong();
 
+    //
+    // Updates the memory usage of the history's commands after its stack's
+    // index has changed (push, merge, undo or redo).
+    //
+    void syncUndoHistory(UndoHistory &history);
+
+    //
+    // Trims the oldest commands from the largest history until the usage is
+    // within the limit. Returns true if any commands were trimmed.
+    //
+    bool trimUndoHistory();
+
+    //
+    // Gets the usage index for the given song, building it if needed.
+    //
+    UsageIndex& builtUsageIndex(trackerboy::Song *song);
+
     trackerboy::Module mModule;
 
     QMutex mMutex;
+    LockStats mLockStats;
     QUndoGroup *mUndoGroup;
 
     // each Song has its own QUndoStack and is created when the user selects the song
     // for editing
-    std::unordered_map<trackerboy::Song*, std::unique_ptr<QUndoStack> > mUndoStacks;
+    std::unordered_map<trackerboy::Song*, UndoHistory> mUndoStacks;
 
     std::shared_ptr<trackerboy::Song> mSong;
 
+    // usage index for each song, built when first queried
+    std::unordered_map<trackerboy::Song const*, UsageIndex> mUsageIndexes;
+
     // permanent dirty flag. Not all edits to the document can be undone. When such
     // edit occurs, this flag is set to true. It is reset when the document is
     // saved or when the document is reset or loaded from disk.
@@ -195,5 +300,8 @@ private:
     //
     bool mModified;
 
+    size_t mUndoMemoryUsage;
+    size_t mUndoMemoryLimit;
+
 };
 
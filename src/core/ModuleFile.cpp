@@ -1,5 +1,6 @@
 
 #include "core/ModuleFile.hpp"
+#include "utils/Trace.hpp"
 
 #include <QDateTime>
 #include <QDir>
@@ -18,6 +19,7 @@ ModuleFile::ModuleFile() :
 }
 
 bool ModuleFile::open(QString const& path, Module &mod) {
+    TRACE_ZONE("ModuleFile::open");
     
     std::ifstream in(path.toStdString(), std::ios::binary | std::ios::in);
     mIoError = in.fail();
@@ -132,6 +134,7 @@ void ModuleFile::setAutoBackup(bool backup) {
 }
 
 bool ModuleFile::doSave(QString const& filename, Module &mod) {
+    TRACE_ZONE("ModuleFile::save");
     if (mAutoBackup) {
         static constexpr auto errorPrefix = "failed to backup module:";
 
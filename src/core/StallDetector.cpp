@@ -0,0 +1,166 @@
+
+#include "core/StallDetector.hpp"
+#include "utils/Trace.hpp"
+
+#include <QMetaEnum>
+#include <QMutexLocker>
+#include <QtDebug>
+
+#include <algorithm>
+
+#define TU StallDetectorTU
+namespace TU {
+
+// time between pings, while the GUI is responsive
+constexpr auto PING_INTERVAL = std::chrono::milliseconds(50);
+
+constexpr auto FIRST_THRESHOLD = std::chrono::milliseconds(StallDetector::THRESHOLDS[0]);
+
+}
+
+StallDetector::Dispatch::Dispatch(StallDetector *detector, QObject *receiver, QEvent *evt) :
+    mDetector(nullptr),
+    mPrevious()
+{
+    if (detector && detector->thread() == QThread::currentThread()) {
+        mDetector = detector;
+        mPrevious = detector->mCurrent;
+        detector->mCurrent = { receiver->metaObject()->className(), (int)evt->type() };
+        detector->mActive.store(detector->mCurrent);
+    }
+}
+
+StallDetector::Dispatch::~Dispatch() {
+    if (mDetector) {
+        mDetector->mCurrent = mPrevious;
+        mDetector->mActive.store(mPrevious);
+    }
+}
+
+StallDetector::StallDetector(QObject *parent) :
+    QObject(parent),
+    mCurrent(),
+    mActive(),
+    mPingMutex(),
+    mPingCond(),
+    mPong(0),
+    mQuit(false),
+    mStallMutex(),
+    mStalls(),
+    mStallCount(0),
+    mCounts(),
+    mThread(nullptr)
+{
+    mThread = QThread::create([this]() {
+        run();
+    });
+    mThread->setObjectName(QStringLiteral("stall watchdog thread"));
+    mThread->start(QThread::HighPriority);
+}
+
+StallDetector::~StallDetector() {
+    {
+        std::scoped_lock lock(mPingMutex);
+        mQuit = true;
+    }
+    mPingCond.notify_one();
+    mThread->wait();
+    delete mThread;
+}
+
+StallDetector::Counts StallDetector::counts() const {
+    QMutexLocker locker(&mStallMutex);
+    return mCounts;
+}
+
+std::vector<StallDetector::Stall> StallDetector::stalls() const {
+    QMutexLocker locker(&mStallMutex);
+    std::vector<Stall> result;
+    auto const count = std::min(mStallCount, HISTORY);
+    result.reserve(count);
+    for (auto i = mStallCount - count; i < mStallCount; ++i) {
+        result.push_back(mStalls[i % HISTORY]);
+    }
+    return result;
+}
+
+QString StallDetector::eventName(QEvent::Type type) {
+    auto const key = QMetaEnum::fromType<QEvent::Type>().valueToKey(type);
+    return key ? QString::fromLatin1(key) : QString::number((int)type);
+}
+
+void StallDetector::clear() {
+    QMutexLocker locker(&mStallMutex);
+    mStallCount = 0;
+    mCounts.fill(0);
+}
+
+void StallDetector::run() {
+    TRACE_THREAD("Stall watchdog");
+
+    std::unique_lock lock(mPingMutex);
+    uint64_t ping = 0;
+    for (;;) {
+        ++ping;
+        auto const sent = Clock::now();
+        QMetaObject::invokeMethod(this, [this, ping]() { pong(ping); }, Qt::QueuedConnection);
+
+        auto const answered = [this, ping]() {
+            return mQuit || mPong == ping;
+        };
+        Active culprit{};
+        bool stalled = false;
+        if (!mPingCond.wait_until(lock, sent + TU::FIRST_THRESHOLD, answered)) {
+            // the GUI thread is still busy, blame whatever it is dispatching
+            culprit = mActive.load();
+            stalled = true;
+            mPingCond.wait(lock, answered);
+        }
+        if (mQuit) {
+            break;
+        }
+        if (stalled) {
+            auto const elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - sent);
+            lock.unlock();
+            record((int)elapsed.count(), culprit);
+            lock.lock();
+        }
+
+        if (mPingCond.wait_for(lock, TU::PING_INTERVAL, [this]() { return mQuit; })) {
+            break;
+        }
+    }
+}
+
+void StallDetector::pong(uint64_t ping) {
+    {
+        std::scoped_lock lock(mPingMutex);
+        mPong = ping;
+    }
+    mPingCond.notify_one();
+}
+
+void StallDetector::record(int elapsed, Active const& culprit) {
+    TRACE_INSTANT("GUI stall");
+    if (elapsed >= THRESHOLDS.back()) {
+        qWarning().nospace() << "[StallDetector] GUI stalled for " << elapsed << " ms, receiver: "
+                             << (culprit.receiver ? culprit.receiver : "none")
+                             << ", event: " << eventName((QEvent::Type)culprit.event);
+    }
+
+    QMutexLocker locker(&mStallMutex);
+    mStalls[mStallCount % HISTORY] = {
+        QTime::currentTime(),
+        elapsed,
+        culprit.receiver,
+        (QEvent::Type)culprit.event
+    };
+    ++mStallCount;
+    for (size_t i = 0; i < THRESHOLDS.size(); ++i) {
+        if (elapsed >= THRESHOLDS[i]) {
+            ++mCounts[i];
+        }
+    }
+}
+
+#undef TU
@@ -0,0 +1,132 @@
+
+#pragma once
+
+#include "utils/Seqlock.hpp"
+
+#include <QEvent>
+#include <QMutex>
+#include <QObject>
+#include <QThread>
+#include <QTime>
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+//
+// Detects stalls of the GUI thread's event loop, and what caused them.
+//
+// A watchdog thread posts a ping to the GUI thread and waits for it to be
+// answered. When the round trip takes longer than the first threshold, the
+// event being dispatched on the GUI thread at that moment (as reported by
+// Dispatch) is blamed for the stall. Stalls are counted against each
+// threshold and the most recent ones are kept for the diagnostics dialog.
+//
+class StallDetector : public QObject {
+
+    Q_OBJECT
+
+    // an event being dispatched on the GUI thread
+    struct Active {
+        char const* receiver;
+        int event;
+    };
+
+public:
+
+    using Clock = std::chrono::steady_clock;
+
+    //
+    // Round trip times, in milliseconds, that stalls are counted against.
+    // Shorter round trips are not stalls.
+    //
+    static constexpr std::array<int, 3> THRESHOLDS = { 16, 50, 100 };
+
+    //
+    // Number of stalls kept in the history
+    //
+    static constexpr size_t HISTORY = 64;
+
+    struct Stall {
+        // wall clock time when the stall ended
+        QTime time;
+        // round trip time of the ping, in milliseconds
+        int elapsed;
+        // class name of the event's receiver, nullptr if no event was being
+        // dispatched (ie blocked in a native event handler)
+        char const* receiver;
+        QEvent::Type event;
+    };
+
+    using Counts = std::array<unsigned, THRESHOLDS.size()>;
+
+    //
+    // Marks an event as being dispatched on the GUI thread for the lifetime
+    // of this object. Used by Application::notify, does nothing for other
+    // threads or a null detector.
+    //
+    class Dispatch {
+
+    public:
+        Dispatch(StallDetector *detector, QObject *receiver, QEvent *evt);
+        ~Dispatch();
+
+    private:
+        Q_DISABLE_COPY(Dispatch)
+
+        StallDetector *mDetector;
+        // the dispatch this one is nested in
+        Active mPrevious;
+    };
+
+    explicit StallDetector(QObject *parent = nullptr);
+    ~StallDetector();
+
+    //
+    // Gets the number of stalls that reached each of the THRESHOLDS.
+    //
+    Counts counts() const;
+
+    //
+    // Gets the recent stalls, oldest first.
+    //
+    std::vector<Stall> stalls() const;
+
+    void clear();
+
+    //
+    // Gets the name of an event type, for display
+    //
+    static QString eventName(QEvent::Type type);
+
+private:
+    Q_DISABLE_COPY(StallDetector)
+
+    void run();
+
+    void pong(uint64_t ping);
+
+    void record(int elapsed, Active const& culprit);
+
+    // the innermost event being dispatched on the GUI thread. mCurrent is
+    // only accessed from the GUI thread, the watchdog reads the copy in
+    // mActive
+    Active mCurrent;
+    Seqlock<Active> mActive;
+
+    std::mutex mPingMutex;
+    std::condition_variable mPingCond;
+    uint64_t mPong;
+    bool mQuit;
+
+    mutable QMutex mStallMutex;
+    std::array<Stall, HISTORY> mStalls;
+    size_t mStallCount;
+    Counts mCounts;
+
+    QThread *mThread;
+
+};
@@ -0,0 +1,46 @@
+
+#include "core/UndoStorage.hpp"
+
+#define TU UndoStorageTU
+namespace TU {
+
+//
+// Approximate size of a command object, including QUndoCommand's private data
+//
+constexpr size_t COMMAND_OVERHEAD = 96;
+
+}
+
+namespace UndoStorage {
+
+size_t memoryUsage(QUndoCommand const* cmd) {
+    size_t usage = TU::COMMAND_OVERHEAD + (size_t)cmd->text().size() * sizeof(QChar);
+    auto storage = dynamic_cast<IUndoStorage const*>(cmd);
+    if (storage) {
+        usage += storage->storageSize();
+    }
+
+    auto const children = cmd->childCount();
+    for (int i = 0; i < children; ++i) {
+        usage += memoryUsage(cmd->child(i));
+    }
+
+    return usage;
+}
+
+void trim(QUndoCommand *cmd) {
+    cmd->setObsolete(true);
+    auto storage = dynamic_cast<IUndoStorage*>(cmd);
+    if (storage) {
+        storage->releaseStorage();
+    }
+
+    auto const children = cmd->childCount();
+    for (int i = 0; i < children; ++i) {
+        trim(const_cast<QUndoCommand*>(cmd->child(i)));
+    }
+}
+
+}
+
+#undef TU
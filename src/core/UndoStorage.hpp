@@ -0,0 +1,50 @@
+
+#pragma once
+
+#include <QUndoCommand>
+
+#include <cstddef>
+
+//
+// Interface for undo commands that store a payload of module data, such as a
+// PatternClip. Module uses this interface to account for the memory used by
+// its undo history and to release the payload of commands trimmed from it.
+//
+class IUndoStorage {
+
+public:
+    virtual ~IUndoStorage() = default;
+
+    //
+    // Gets the amount of heap memory, in bytes, used by the command's payload.
+    //
+    virtual size_t storageSize() const = 0;
+
+    //
+    // Releases the command's payload. This is only called for trimmed
+    // commands, whose undo() and redo() do nothing (see UndoStorage::trim).
+    //
+    virtual void releaseStorage() = 0;
+
+};
+
+namespace UndoStorage {
+
+//
+// Estimates the memory used by the given command and its children. Commands
+// not implementing IUndoStorage are estimated by their size and text.
+//
+size_t memoryUsage(QUndoCommand const* cmd);
+
+//
+// Trims the given command from the undo history. The command and its children
+// are marked obsolete and the payload of each is released. The effects of a
+// trimmed command become permanent.
+//
+// QUndoStack deletes an obsolete command once it is reached, but setIndex()
+// (ie clicking a QUndoView) still calls undo() on it beforehand. So every
+// command's undo() and redo() must do nothing when isObsolete() is set.
+//
+void trim(QUndoCommand *cmd);
+
+}
@@ -0,0 +1,180 @@
+
+#include "core/UsageIndex.hpp"
+
+#include <QtGlobal>
+
+#include <algorithm>
+
+#define TU UsageIndexTU
+namespace TU {
+
+// each kind of key has 256 possible ids
+constexpr int KEYS_PER_KIND = 256;
+constexpr int KEY_COUNT = KEYS_PER_KIND * 3;
+
+}
+
+UsageIndex::UsageIndex() :
+    mValid(false),
+    mReferences(),
+    mLocations(TU::KEY_COUNT),
+    mRows()
+{
+}
+
+bool UsageIndex::isValid() const {
+    return mValid;
+}
+
+void UsageIndex::invalidate() {
+    mValid = false;
+}
+
+void UsageIndex::rebuild(trackerboy::Song &song) {
+    for (auto &locations : mLocations) {
+        locations.clear();
+    }
+    mRows.clear();
+    for (auto &references : mReferences) {
+        references.fill(0);
+    }
+    // validate now, so that updateTrack does not ignore our updates
+    mValid = true;
+
+    auto &order = song.order();
+    for (int i = 0; i < (int)order.size(); ++i) {
+        auto const& row = order[i];
+        for (size_t ch = 0; ch < row.size(); ++ch) {
+            ++mReferences[ch][row[ch]];
+        }
+    }
+
+    auto &patterns = song.patterns();
+    for (size_t ch = 0; ch < mReferences.size(); ++ch) {
+        auto const channel = static_cast<trackerboy::ChType>(ch);
+        for (int trackId = 0; trackId < 256; ++trackId) {
+            if (mReferences[ch][trackId]) {
+                updateTrack(channel, (uint8_t)trackId, patterns.getTrack(channel, (uint8_t)trackId));
+            }
+        }
+    }
+}
+
+void UsageIndex::addReference(trackerboy::ChType ch, uint8_t trackId, trackerboy::Track const& track) {
+    if (!mValid) {
+        return;
+    }
+
+    if (mReferences[(size_t)ch][trackId]++ == 0) {
+        updateTrack(ch, trackId, track);
+    }
+}
+
+void UsageIndex::removeReference(trackerboy::ChType ch, uint8_t trackId) {
+    if (!mValid) {
+        return;
+    }
+
+    auto &references = mReferences[(size_t)ch][trackId];
+    Q_ASSERT(references > 0);
+    if (--references == 0) {
+        for (int row = 0; row < 256; ++row) {
+            removeRow(packLocation(ch, trackId, (uint8_t)row));
+        }
+    }
+}
+
+void UsageIndex::updateRow(trackerboy::ChType ch, uint8_t trackId, uint8_t row, trackerboy::TrackRow const& rowdata) {
+    if (!mValid || mReferences[(size_t)ch][trackId] == 0) {
+        return;
+    }
+
+    auto const location = packLocation(ch, trackId, row);
+    removeRow(location);
+
+    auto const keys = rowKeys(ch, rowdata);
+    if (keys.count) {
+        for (uint8_t i = 0; i < keys.count; ++i) {
+            mLocations[keys.keys[i]].insert(location);
+        }
+        mRows.emplace(location, keys);
+    }
+}
+
+void UsageIndex::updateTrack(trackerboy::ChType ch, uint8_t trackId, trackerboy::Track const& track) {
+    if (!mValid) {
+        return;
+    }
+
+    auto const rows = track.size();
+    for (size_t row = 0; row < rows; ++row) {
+        updateRow(ch, trackId, (uint8_t)row, track[(uint16_t)row]);
+    }
+}
+
+size_t UsageIndex::count(Kind kind, int id) const {
+    return mLocations[key(kind, id)].size();
+}
+
+std::vector<UsageIndex::Location> UsageIndex::find(Kind kind, int id) const {
+    auto const& locations = mLocations[key(kind, id)];
+    std::vector<Location> result;
+    result.reserve(locations.size());
+    for (auto location : locations) {
+        result.push_back({
+            static_cast<trackerboy::ChType>(location >> 16),
+            (uint8_t)(location >> 8),
+            (uint8_t)location
+        });
+    }
+    return result;
+}
+
+uint16_t UsageIndex::key(Kind kind, int id) {
+    Q_ASSERT(id >= 0 && id < TU::KEYS_PER_KIND);
+    return (uint16_t)((int)kind * TU::KEYS_PER_KIND + id);
+}
+
+uint32_t UsageIndex::packLocation(trackerboy::ChType ch, uint8_t trackId, uint8_t row) {
+    return ((uint32_t)ch << 16) | ((uint32_t)trackId << 8) | row;
+}
+
+UsageIndex::RowKeys UsageIndex::rowKeys(trackerboy::ChType ch, trackerboy::TrackRow const& rowdata) {
+    RowKeys result{};
+
+    auto add = [&result](uint16_t k) {
+        // a row can use the same effect more than once
+        auto const end = result.keys.begin() + result.count;
+        if (std::find(result.keys.begin(), end, k) == end) {
+            result.keys[result.count++] = k;
+        }
+    };
+
+    if (auto instrument = rowdata.queryInstrument(); instrument) {
+        add(key(Kind::instrument, *instrument));
+    }
+    for (auto const& effect : rowdata.effects) {
+        if (effect.type != trackerboy::EffectType::noEffect) {
+            add(key(Kind::effect, (int)effect.type));
+            // Exx on CH3 sets the waveform
+            if (ch == trackerboy::ChType::ch3 && effect.type == trackerboy::EffectType::setEnvelope) {
+                add(key(Kind::waveform, effect.param));
+            }
+        }
+    }
+
+    return result;
+}
+
+void UsageIndex::removeRow(uint32_t location) {
+    auto iter = mRows.find(location);
+    if (iter != mRows.end()) {
+        auto const& keys = iter->second;
+        for (uint8_t i = 0; i < keys.count; ++i) {
+            mLocations[keys.keys[i]].erase(location);
+        }
+        mRows.erase(iter);
+    }
+}
+
+#undef TU
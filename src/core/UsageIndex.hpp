@@ -0,0 +1,125 @@
+
+#pragma once
+
+#include "trackerboy/data/Song.hpp"
+#include "trackerboy/data/TrackRow.hpp"
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+//
+// Inverted index of a song's track rows, mapping instruments, waveforms
+// (Exx on CH3) and effect types to the rows that use them. The index is
+// updated incrementally by the pattern edit commands, so that queries do not
+// need to scan the entire song.
+//
+// Only tracks referenced by the song's order are indexed. The index counts
+// the order rows referencing each track, which the order edits maintain via
+// addReference and removeReference, and a track is dropped from the index
+// once no order row references it.
+//
+class UsageIndex {
+
+public:
+
+    enum class Kind : uint8_t {
+        instrument,
+        waveform,
+        effect
+    };
+
+    struct Location {
+        trackerboy::ChType channel;
+        uint8_t trackId;
+        uint8_t row;
+    };
+
+    UsageIndex();
+
+    //
+    // Returns true if the index is built. Updates to an invalid index are
+    // ignored, as it will be rebuilt entirely.
+    //
+    bool isValid() const;
+
+    //
+    // Marks the index as invalid, use this when the song was modified in a
+    // way that was not tracked by the index.
+    //
+    void invalidate();
+
+    //
+    // Rebuilds the index from every track referenced by the song's order.
+    // Tracks may be created if they do not exist, so the song should be
+    // locked.
+    //
+    void rebuild(trackerboy::Song &song);
+
+    //
+    // Adds a reference to a track from an order row. The track is indexed
+    // if it was not referenced before.
+    //
+    void addReference(trackerboy::ChType ch, uint8_t trackId, trackerboy::Track const& track);
+
+    //
+    // Removes a reference to a track from an order row. The track's rows are
+    // removed from the index if it is no longer referenced.
+    //
+    void removeReference(trackerboy::ChType ch, uint8_t trackId);
+
+    //
+    // Re-indexes a single row with its current data. Rows of tracks not
+    // referenced by the order are ignored.
+    //
+    void updateRow(trackerboy::ChType ch, uint8_t trackId, uint8_t row, trackerboy::TrackRow const& rowdata);
+
+    //
+    // Re-indexes all rows in a track.
+    //
+    void updateTrack(trackerboy::ChType ch, uint8_t trackId, trackerboy::Track const& track);
+
+    //
+    // Gets the number of rows using the given id. For effects, the id is
+    // the EffectType.
+    //
+    size_t count(Kind kind, int id) const;
+
+    //
+    // Gets the locations of all rows using the given id, in no particular
+    // order.
+    //
+    std::vector<Location> find(Kind kind, int id) const;
+
+private:
+
+    // maximum number of keys for a single row: the instrument, and the type
+    // and waveform of each of the 3 effects
+    static constexpr size_t MAX_ROW_KEYS = 7;
+
+    struct RowKeys {
+        std::array<uint16_t, MAX_ROW_KEYS> keys;
+        uint8_t count;
+    };
+
+    static uint16_t key(Kind kind, int id);
+
+    static uint32_t packLocation(trackerboy::ChType ch, uint8_t trackId, uint8_t row);
+
+    static RowKeys rowKeys(trackerboy::ChType ch, trackerboy::TrackRow const& rowdata);
+
+    void removeRow(uint32_t location);
+
+    bool mValid;
+
+    // number of order rows referencing each track, per channel
+    std::array<std::array<uint16_t, 256>, 4> mReferences;
+
+    // key -> locations of the rows with that key
+    std::vector<std::unordered_set<uint32_t>> mLocations;
+    // location -> keys for that location, only rows with keys are stored
+    std::unordered_map<uint32_t, RowKeys> mRows;
+
+};
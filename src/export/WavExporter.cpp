@@ -2,6 +2,7 @@
 #include "export/WavExporter.hpp"
 
 #include "audio/Wav.hpp"
+#include "utils/Trace.hpp"
 
 #include <QDir>
 #include <QFileInfo>
@@ -71,6 +72,8 @@ struct Batch {
 
 
 void WavExporter::run() {
+    TRACE_THREAD("WAV export");
+    TRACE_ZONE("WavExporter::run");
 
     // batches for this run
     std::array<TU::Batch, 4> batches;
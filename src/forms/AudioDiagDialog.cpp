@@ -10,21 +10,28 @@ constexpr int DEFAULT_REFRESH_INTERVAL = 100;
 
 }
 
-AudioDiagDialog::AudioDiagDialog(Renderer &renderer, QWidget *parent) :
+AudioDiagDialog::AudioDiagDialog(Renderer &renderer, StallDetector &stallDetector, QWidget *parent) :
     QDialog(parent, Qt::WindowTitleHint | Qt::WindowSystemMenuHint | Qt::WindowCloseButtonHint),
     mRenderer(renderer),
+    mStallDetector(stallDetector),
     mTimerId(-1),
     mLastIsRunning(true),
+    mLastStallCount(~0u),
     mLayout(),
     mRenderGroup(tr("Render statistics")),
     mRenderLayout(),
     mUnderrunLabel(),
+    mStallLabel(),
     mBufferProgress(),
     mStatusLabel(),
     mElapsedLabel(),
     mPeriodLabel(),
     mPeriodWrittenLabel(),
     mClearButton(tr("Clear")),
+    mStallGroup(tr("GUI stalls")),
+    mStallLayout(),
+    mStallTree(),
+    mStallClearButton(tr("Clear")),
     mButtonLayout(),
     mAutoRefreshCheck(tr("Auto refresh")),
     mIntervalSpin(),
@@ -32,14 +39,19 @@ AudioDiagDialog::AudioDiagDialog(Renderer &renderer, QWidget *parent) :
     mCloseButton(tr("Close"))
 {
     mRenderLayout.addRow(tr("Underruns"), &mUnderrunLabel);
+    mRenderLayout.addRow(tr("GUI stalls"), &mStallLabel);
     mRenderLayout.addRow(tr("Buffer usage"), &mBufferProgress);
     mRenderLayout.addRow(tr("Status"), &mStatusLabel);
     mRenderLayout.addRow(tr("Elapsed"), &mElapsedLabel);
     mRenderLayout.addRow(tr("Refresh rate"), &mPeriodLabel);
     mRenderLayout.addRow(tr("Samples written"), &mPeriodWrittenLabel);
-    mRenderLayout.setWidget(6, QFormLayout::LabelRole, &mClearButton);
+    mRenderLayout.setWidget(7, QFormLayout::LabelRole, &mClearButton);
     mRenderGroup.setLayout(&mRenderLayout);
 
+    mStallLayout.addWidget(&mStallTree, 1);
+    mStallLayout.addWidget(&mStallClearButton, 0, Qt::AlignLeft);
+    mStallGroup.setLayout(&mStallLayout);
+
     mButtonLayout.addWidget(&mAutoRefreshCheck);
     mButtonLayout.addWidget(&mIntervalSpin);
     mButtonLayout.addWidget(&mRefreshButton);
@@ -47,6 +59,7 @@ AudioDiagDialog::AudioDiagDialog(Renderer &renderer, QWidget *parent) :
     mButtonLayout.addWidget(&mCloseButton);
 
     mLayout.addWidget(&mRenderGroup, 1);
+    mLayout.addWidget(&mStallGroup, 1);
     mLayout.addLayout(&mButtonLayout);
     mLayout.setSizeConstraint(QLayout::SizeConstraint::SetFixedSize);
     setLayout(&mLayout);
@@ -60,6 +73,10 @@ AudioDiagDialog::AudioDiagDialog(Renderer &renderer, QWidget *parent) :
     mBufferProgress.setAlignment(Qt::AlignCenter);
     mBufferProgress.setFormat(tr("%p% (%v / %m samples)"));
 
+    mStallTree.setHeaderLabels({ tr("Time"), tr("Duration"), tr("Receiver"), tr("Event") });
+    mStallTree.setRootIsDecorated(false);
+    mStallTree.setMinimumWidth(480);
+
     mCloseButton.setDefault(true);
 
     setElapsed(0);
@@ -69,6 +86,11 @@ AudioDiagDialog::AudioDiagDialog(Renderer &renderer, QWidget *parent) :
     connect(&mCloseButton, &QPushButton::clicked, this, &AudioDiagDialog::close);
     connect(&mRefreshButton, &QPushButton::clicked, this, &AudioDiagDialog::refresh);
     connect(&mClearButton, &QPushButton::clicked, &mRenderer, &Renderer::clearDiagnostics);
+    connect(&mStallClearButton, &QPushButton::clicked, this,
+        [this]() {
+            mStallDetector.clear();
+            refreshStalls();
+        });
     connect(&mAutoRefreshCheck, &QCheckBox::stateChanged, this,
         [this](int state) {
             bool checked = state == Qt::Checked;
@@ -133,6 +155,34 @@ void AudioDiagDialog::refresh() {
     mBufferProgress.setValue(bufferStat.usage);
     mPeriodLabel.setText(tr("%1 ms").arg(bufferStat.lastPeriodMs, 0, 'f', 3));
     mPeriodWrittenLabel.setText(QString::number(bufferStat.writesSinceLastPeriod));
+
+    refreshStalls();
+}
+
+void AudioDiagDialog::refreshStalls() {
+    auto const counts = mStallDetector.counts();
+    QStringList countStrs;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        countStrs.append(tr("%1 (%2+ ms)").arg(counts[i]).arg(StallDetector::THRESHOLDS[i]));
+    }
+    mStallLabel.setText(countStrs.join(QStringLiteral(", ")));
+
+    // every stall reaches the first threshold
+    if (counts[0] == mLastStallCount) {
+        return;
+    }
+    mLastStallCount = counts[0];
+
+    mStallTree.clear();
+    auto const stalls = mStallDetector.stalls();
+    // most recent first
+    for (auto iter = stalls.rbegin(); iter != stalls.rend(); ++iter) {
+        auto item = new QTreeWidgetItem(&mStallTree);
+        item->setText(0, iter->time.toString(QStringLiteral("HH:mm:ss.zzz")));
+        item->setText(1, tr("%1 ms").arg(iter->elapsed));
+        item->setText(2, iter->receiver ? QString::fromLatin1(iter->receiver) : tr("(none)"));
+        item->setText(3, iter->receiver ? StallDetector::eventName(iter->event) : QString());
+    }
 }
 
 void AudioDiagDialog::setRunningLabel(bool const isRunning) {
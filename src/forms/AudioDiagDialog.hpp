@@ -3,6 +3,7 @@
 
 #include "audio/Renderer.hpp"
 #include "config/Config.hpp"
+#include "core/StallDetector.hpp"
 
 #include <QCheckBox>
 #include <QDialog>
@@ -13,9 +14,11 @@
 #include <QProgressBar>
 #include <QPushButton>
 #include <QSpinBox>
+#include <QTreeWidget>
 
 //
-// Audio diagnostics dialog. Shows stats about the Renderer and detailed device information
+// Audio diagnostics dialog. Shows stats about the Renderer and detailed device information,
+// along with stalls of the GUI thread
 //
 class AudioDiagDialog : public QDialog {
 
@@ -23,7 +26,7 @@ class AudioDiagDialog : public QDialog {
 
 public:
 
-    explicit AudioDiagDialog(Renderer &renderer, QWidget *parent = nullptr);
+    explicit AudioDiagDialog(Renderer &renderer, StallDetector &stallDetector, QWidget *parent = nullptr);
     ~AudioDiagDialog();
 
 protected:
@@ -43,14 +46,20 @@ private:
 
     void setElapsed(long const msecs);
 
+    void refreshStalls();
+
     Renderer &mRenderer;
+    StallDetector &mStallDetector;
     int mTimerId;
     bool mLastIsRunning;
+    // stall count when the stall list was last populated
+    unsigned mLastStallCount;
 
     QVBoxLayout mLayout;
         QGroupBox mRenderGroup;
             QFormLayout mRenderLayout;
                 QLabel mUnderrunLabel;
+                QLabel mStallLabel;
                 //QLabel mBufferLabel;
                 QProgressBar mBufferProgress;
                 QLabel mStatusLabel;
@@ -58,6 +67,10 @@ private:
                 QLabel mPeriodLabel;
                 QLabel mPeriodWrittenLabel;
                 QPushButton mClearButton;
+        QGroupBox mStallGroup;
+            QVBoxLayout mStallLayout;
+                QTreeWidget mStallTree;
+                QPushButton mStallClearButton;
         QHBoxLayout mButtonLayout;
             QCheckBox mAutoRefreshCheck;
             QSpinBox mIntervalSpin;
@@ -0,0 +1,153 @@
+
+#include "forms/BulkEditDialog.hpp"
+
+#include "utils/connectutils.hpp"
+
+#include <QCheckBox>
+#include <QComboBox>
+#include <QGridLayout>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QPushButton>
+#include <QSpinBox>
+
+BulkEditDialog::BulkEditDialog(PatternModel &model, QWidget *parent) :
+    QDialog(parent, Qt::WindowTitleHint | Qt::WindowSystemMenuHint | Qt::WindowCloseButtonHint),
+    mModel(model),
+    mTypeCombo(nullptr),
+    mAmountLabel(nullptr),
+    mAmountSpin(nullptr),
+    mInstrumentFromSpin(nullptr),
+    mInstrumentToSpin(nullptr),
+    mOrderStartSpin(nullptr),
+    mOrderEndSpin(nullptr),
+    mChannelChecks(),
+    mResultLabel(nullptr)
+{
+    setWindowTitle(tr("Bulk edit"));
+
+    auto layout = new QGridLayout;
+
+    QLabel *label;
+    label = new QLabel(tr("Operation"));
+    mTypeCombo = new QComboBox;
+    mTypeCombo->addItem(tr("Transpose"));
+    mTypeCombo->addItem(tr("Replace instrument"));
+    mTypeCombo->addItem(tr("Scale volume"));
+    label->setBuddy(mTypeCombo);
+    layout->addWidget(label, 0, 0);
+    layout->addWidget(mTypeCombo, 0, 1, 1, 2);
+
+    mAmountLabel = new QLabel;
+    mAmountSpin = new QSpinBox;
+    mAmountLabel->setBuddy(mAmountSpin);
+    layout->addWidget(mAmountLabel, 1, 0);
+    layout->addWidget(mAmountSpin, 1, 1, 1, 2);
+
+    label = new QLabel(tr("Instrument"));
+    mInstrumentFromSpin = new QSpinBox;
+    mInstrumentToSpin = new QSpinBox;
+    label->setBuddy(mInstrumentFromSpin);
+    layout->addWidget(label, 2, 0);
+    layout->addWidget(mInstrumentFromSpin, 2, 1);
+    layout->addWidget(mInstrumentToSpin, 2, 2);
+
+    label = new QLabel(tr("Orders"));
+    mOrderStartSpin = new QSpinBox;
+    mOrderEndSpin = new QSpinBox;
+    label->setBuddy(mOrderStartSpin);
+    layout->addWidget(label, 3, 0);
+    layout->addWidget(mOrderStartSpin, 3, 1);
+    layout->addWidget(mOrderEndSpin, 3, 2);
+
+    auto channelLayout = new QHBoxLayout;
+    for (size_t i = 0; i < mChannelChecks.size(); ++i) {
+        auto check = new QCheckBox(tr("CH%1").arg(i + 1));
+        check->setChecked(true);
+        channelLayout->addWidget(check);
+        mChannelChecks[i] = check;
+    }
+    layout->addWidget(new QLabel(tr("Channels")), 4, 0);
+    layout->addLayout(channelLayout, 4, 1, 1, 2);
+
+    mResultLabel = new QLabel;
+    layout->addWidget(mResultLabel, 5, 0, 1, 3);
+
+    auto applyButton = new QPushButton(tr("Apply"));
+    applyButton->setDefault(true);
+    auto closeButton = new QPushButton(tr("Close"));
+    layout->addWidget(applyButton, 6, 1);
+    layout->addWidget(closeButton, 6, 2);
+
+    layout->setSizeConstraint(QLayout::SizeConstraint::SetFixedSize);
+    setLayout(layout);
+
+    mInstrumentFromSpin->setRange(-1, 0x3F);
+    mInstrumentFromSpin->setDisplayIntegerBase(16);
+    mInstrumentFromSpin->setSpecialValueText(tr("Any"));
+    mInstrumentFromSpin->setValue(-1);
+    mInstrumentToSpin->setRange(0, 0x3F);
+    mInstrumentToSpin->setDisplayIntegerBase(16);
+    mInstrumentToSpin->setPrefix(tr("to "));
+
+    mOrderStartSpin->setDisplayIntegerBase(16);
+    mOrderEndSpin->setDisplayIntegerBase(16);
+    mOrderEndSpin->setPrefix(tr("to "));
+    updateOrderRange();
+    mOrderEndSpin->setValue(mOrderEndSpin->maximum());
+
+    updateType(0);
+
+    connect(mTypeCombo, qOverload<int>(&QComboBox::currentIndexChanged), this, &BulkEditDialog::updateType);
+    connect(&mModel, &PatternModel::patternCountChanged, this, &BulkEditDialog::updateOrderRange);
+    connect(mOrderStartSpin, qOverload<int>(&QSpinBox::valueChanged), this,
+        [this](int value) {
+            mOrderEndSpin->setMinimum(value);
+        });
+    lazyconnect(applyButton, clicked, this, apply);
+    lazyconnect(closeButton, clicked, this, close);
+}
+
+void BulkEditDialog::updateType(int index) {
+    auto const type = static_cast<BulkOperation::Type>(index);
+    bool const hasAmount = type != BulkOperation::Type::replaceInstrument;
+    mAmountLabel->setEnabled(hasAmount);
+    mAmountSpin->setEnabled(hasAmount);
+    mInstrumentFromSpin->setEnabled(!hasAmount);
+    mInstrumentToSpin->setEnabled(!hasAmount);
+
+    if (type == BulkOperation::Type::scaleVolume) {
+        mAmountLabel->setText(tr("Scale"));
+        mAmountSpin->setRange(0, 400);
+        mAmountSpin->setSuffix(tr("%"));
+        mAmountSpin->setValue(100);
+    } else {
+        mAmountLabel->setText(tr("Semitones"));
+        mAmountSpin->setRange(-96, 96);
+        mAmountSpin->setSuffix(QString());
+        mAmountSpin->setValue(0);
+    }
+    mResultLabel->clear();
+}
+
+void BulkEditDialog::updateOrderRange() {
+    auto const last = mModel.patterns() - 1;
+    mOrderStartSpin->setMaximum(last);
+    mOrderEndSpin->setMaximum(last);
+}
+
+void BulkEditDialog::apply() {
+    BulkOperation operation;
+    operation.type = static_cast<BulkOperation::Type>(mTypeCombo->currentIndex());
+    operation.amount = mAmountSpin->value();
+    operation.instrumentFrom = mInstrumentFromSpin->value();
+    operation.instrumentTo = mInstrumentToSpin->value();
+    operation.orderStart = mOrderStartSpin->value();
+    operation.orderEnd = mOrderEndSpin->value();
+    for (size_t i = 0; i < mChannelChecks.size(); ++i) {
+        operation.channels[i] = mChannelChecks[i]->isChecked();
+    }
+
+    auto const count = mModel.bulkEdit(operation);
+    mResultLabel->setText(tr("%n row(s) changed", nullptr, count));
+}
@@ -0,0 +1,47 @@
+
+#pragma once
+
+#include "model/PatternModel.hpp"
+
+#include <QDialog>
+
+#include <array>
+
+class QCheckBox;
+class QComboBox;
+class QLabel;
+class QSpinBox;
+
+//
+// Dialog for applying a BulkOperation to the entire song, or a range of its
+// order.
+//
+class BulkEditDialog : public QDialog {
+
+    Q_OBJECT
+
+public:
+
+    explicit BulkEditDialog(PatternModel &model, QWidget *parent = nullptr);
+
+private:
+
+    void updateType(int index);
+
+    void updateOrderRange();
+
+    void apply();
+
+    PatternModel &mModel;
+
+    QComboBox *mTypeCombo;
+    QLabel *mAmountLabel;
+    QSpinBox *mAmountSpin;
+    QSpinBox *mInstrumentFromSpin;
+    QSpinBox *mInstrumentToSpin;
+    QSpinBox *mOrderStartSpin;
+    QSpinBox *mOrderEndSpin;
+    std::array<QCheckBox*, 4> mChannelChecks;
+    QLabel *mResultLabel;
+
+};
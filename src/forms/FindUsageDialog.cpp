@@ -0,0 +1,179 @@
+
+#include "forms/FindUsageDialog.hpp"
+
+#include "core/EffectStrings.hpp"
+#include "utils/connectutils.hpp"
+
+#include <QComboBox>
+#include <QGridLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QTreeWidget>
+
+#include <algorithm>
+#include <array>
+#include <tuple>
+#include <vector>
+
+#define TU FindUsageDialogTU
+namespace TU {
+
+// data roles for a result item
+constexpr int ROLE_PATTERN = Qt::UserRole;
+constexpr int ROLE_TRACK = Qt::UserRole + 1;
+constexpr int ROLE_ROW = Qt::UserRole + 2;
+
+static QString hex(int value) {
+    return QString::number(value, 16).toUpper().rightJustified(2, '0');
+}
+
+}
+
+FindUsageDialog::FindUsageDialog(Module &mod, PatternModel &model, QWidget *parent) :
+    QDialog(parent, Qt::WindowTitleHint | Qt::WindowSystemMenuHint | Qt::WindowCloseButtonHint),
+    mModule(mod),
+    mModel(model),
+    mKindCombo(nullptr),
+    mIdSpin(nullptr),
+    mEffectCombo(nullptr),
+    mResults(nullptr),
+    mResultLabel(nullptr),
+    mReplaceSpin(nullptr),
+    mReplaceButton(nullptr)
+{
+    setWindowTitle(tr("Find usage"));
+
+    auto layout = new QGridLayout;
+
+    mKindCombo = new QComboBox;
+    mKindCombo->addItem(tr("Instrument"));
+    mKindCombo->addItem(tr("Waveform"));
+    mKindCombo->addItem(tr("Effect"));
+    mIdSpin = new QSpinBox;
+    mEffectCombo = new QComboBox;
+    auto findButton = new QPushButton(tr("Find"));
+    findButton->setDefault(true);
+    layout->addWidget(mKindCombo, 0, 0);
+    layout->addWidget(mIdSpin, 0, 1);
+    layout->addWidget(mEffectCombo, 0, 1);
+    layout->addWidget(findButton, 0, 2);
+
+    mResults = new QTreeWidget;
+    mResults->setHeaderLabels({ tr("Order"), tr("Channel"), tr("Row") });
+    mResults->setRootIsDecorated(false);
+    mResults->setUniformRowHeights(true);
+    mResults->header()->setSectionResizeMode(QHeaderView::Stretch);
+    layout->addWidget(mResults, 1, 0, 1, 3);
+
+    mResultLabel = new QLabel;
+    layout->addWidget(mResultLabel, 2, 0, 1, 3);
+
+    mReplaceSpin = new QSpinBox;
+    mReplaceButton = new QPushButton(tr("Replace all"));
+    auto closeButton = new QPushButton(tr("Close"));
+    layout->addWidget(mReplaceSpin, 3, 0);
+    layout->addWidget(mReplaceButton, 3, 1);
+    layout->addWidget(closeButton, 3, 2);
+
+    setLayout(layout);
+
+    mIdSpin->setRange(0, 0x3F);
+    mIdSpin->setDisplayIntegerBase(16);
+    mReplaceSpin->setRange(0, 0x3F);
+    mReplaceSpin->setDisplayIntegerBase(16);
+    mReplaceSpin->setPrefix(tr("with "));
+
+    // all known effect types, identified by the character displayed for them
+    for (int type = 1; type < 256; ++type) {
+        auto const ch = EffectStrings::toChar(static_cast<trackerboy::EffectType>(type));
+        if (ch != '?') {
+            mEffectCombo->addItem(QString(QChar(ch)), type);
+        }
+    }
+
+    updateKind(0);
+
+    connect(mKindCombo, qOverload<int>(&QComboBox::currentIndexChanged), this, &FindUsageDialog::updateKind);
+    connect(mResults, &QTreeWidget::itemDoubleClicked, this,
+        [this](QTreeWidgetItem *item) {
+            mModel.setCursorPattern(item->data(0, TU::ROLE_PATTERN).toInt());
+            mModel.setCursorTrack(item->data(0, TU::ROLE_TRACK).toInt());
+            mModel.setCursorRow(item->data(0, TU::ROLE_ROW).toInt());
+        });
+    lazyconnect(findButton, clicked, this, find);
+    lazyconnect(mReplaceButton, clicked, this, replace);
+    lazyconnect(closeButton, clicked, this, close);
+}
+
+void FindUsageDialog::updateKind(int index) {
+    bool const isEffect = static_cast<UsageIndex::Kind>(index) == UsageIndex::Kind::effect;
+    bool const isInstrument = static_cast<UsageIndex::Kind>(index) == UsageIndex::Kind::instrument;
+    mIdSpin->setVisible(!isEffect);
+    mEffectCombo->setVisible(isEffect);
+    mReplaceSpin->setEnabled(isInstrument);
+    mReplaceButton->setEnabled(isInstrument);
+    mResults->clear();
+    mResultLabel->clear();
+}
+
+UsageIndex::Kind FindUsageDialog::kind() const {
+    return static_cast<UsageIndex::Kind>(mKindCombo->currentIndex());
+}
+
+int FindUsageDialog::searchId() const {
+    if (kind() == UsageIndex::Kind::effect) {
+        return mEffectCombo->currentData().toInt();
+    } else {
+        return mIdSpin->value();
+    }
+}
+
+void FindUsageDialog::find() {
+    auto const locations = mModule.findUsage(kind(), searchId());
+
+    // map each track to the order rows using it, so that locations can be
+    // reported as patterns
+    auto const& order = mModel.order();
+    std::array<std::array<std::vector<int>, 256>, 4> trackPatterns;
+    for (int i = 0; i < (int)order.size(); ++i) {
+        auto const& row = order[i];
+        for (size_t ch = 0; ch < row.size(); ++ch) {
+            trackPatterns[ch][row[ch]].push_back(i);
+        }
+    }
+
+    std::vector<std::tuple<int, int, int>> results;
+    for (auto const& location : locations) {
+        auto const track = (int)location.channel;
+        for (auto pattern : trackPatterns[track][location.trackId]) {
+            results.emplace_back(pattern, track, (int)location.row);
+        }
+    }
+    std::sort(results.begin(), results.end());
+
+    mResults->clear();
+    QList<QTreeWidgetItem*> items;
+    items.reserve((int)results.size());
+    for (auto const& [pattern, track, row] : results) {
+        auto item = new QTreeWidgetItem({ TU::hex(pattern), tr("CH%1").arg(track + 1), TU::hex(row) });
+        item->setData(0, TU::ROLE_PATTERN, pattern);
+        item->setData(0, TU::ROLE_TRACK, track);
+        item->setData(0, TU::ROLE_ROW, row);
+        items.append(item);
+    }
+    mResults->addTopLevelItems(items);
+    mResultLabel->setText(tr("%n row(s) found", nullptr, (int)results.size()));
+}
+
+void FindUsageDialog::replace() {
+    BulkOperation operation;
+    operation.type = BulkOperation::Type::replaceInstrument;
+    operation.instrumentFrom = mIdSpin->value();
+    operation.instrumentTo = mReplaceSpin->value();
+    mModel.bulkEdit(operation);
+    find();
+}
+
+#undef TU
@@ -0,0 +1,50 @@
+
+#pragma once
+
+#include "core/Module.hpp"
+#include "model/PatternModel.hpp"
+
+#include <QDialog>
+
+class QComboBox;
+class QLabel;
+class QPushButton;
+class QSpinBox;
+class QTreeWidget;
+
+//
+// Dialog for finding the rows in the current song that use an instrument,
+// waveform or effect. Instruments found can be replaced with another.
+//
+class FindUsageDialog : public QDialog {
+
+    Q_OBJECT
+
+public:
+
+    explicit FindUsageDialog(Module &mod, PatternModel &model, QWidget *parent = nullptr);
+
+private:
+
+    void updateKind(int index);
+
+    void find();
+
+    void replace();
+
+    UsageIndex::Kind kind() const;
+
+    int searchId() const;
+
+    Module &mModule;
+    PatternModel &mModel;
+
+    QComboBox *mKindCombo;
+    QSpinBox *mIdSpin;
+    QComboBox *mEffectCombo;
+    QTreeWidget *mResults;
+    QLabel *mResultLabel;
+    QSpinBox *mReplaceSpin;
+    QPushButton *mReplaceButton;
+
+};
@@ -3,6 +3,7 @@
 
 #include "utils/connectutils.hpp"
 #include "utils/IconLocator.hpp"
+#include "utils/PhaseTimer.hpp"
 #include "utils/utils.hpp"
 #include "widgets/TableView.hpp"
 #include "version.hpp"
@@ -44,9 +45,12 @@ static constexpr int WINDOW_STATE_VERSION = 2;
 
 }
 
-MainWindow::MainWindow() :
+MainWindow::MainWindow(StallDetector &stallDetector) :
     QMainWindow(),
     mAudioEnumerator(),
+    mMidiEnumerator(),
+    mDeviceScanner(mAudioEnumerator, mMidiEnumerator),
+    mStallDetector(stallDetector),
     mUntitledString(tr("Untitled")),
     mPianoInput(),
     mMidi(),
@@ -59,11 +63,14 @@ MainWindow::MainWindow() :
     mAutosaveIntervalMs(30000),
     mAudioDiag(nullptr),
     mTempoCalc(nullptr),
+    mBulkEditDialog(nullptr),
+    mFindUsageDialog(nullptr),
     mCommentsDialog(nullptr),
     mInstrumentEditor(nullptr),
     mWaveEditor(nullptr),
     mHistoryDialog(nullptr)
 {
+    PhaseTimer timer("[Startup] MainWindow");
 
     // create models
     mModule = new Module(this);
@@ -74,8 +81,10 @@ MainWindow::MainWindow() :
     mWaveModel = new WaveListModel(*mModule, this);
 
     mRenderer = new Renderer(*mModule, this);
+    timer.phase("models");
 
     setupUi();
+    timer.phase("ui");
 
     // read in application configuration
     //mConfig.readSettings(mAudioEnumerator, mMidiEnumerator);
@@ -133,15 +142,37 @@ MainWindow::MainWindow() :
     };
     restoreSplitter(*mVSplitter, settings.value(TU::KEY_VSPLITTER).toByteArray(), TU::DEFAULT_VSPLITTER_RATIO);
     restoreSplitter(*mHSplitter, settings.value(TU::KEY_HSPLITTER).toByteArray(), TU::DEFAULT_HSPLITTER_RATIO);
+    settings.endGroup();
 
     mModuleFile.setName(mUntitledString);
     updateWindowTitle();
+    timer.phase("window state");
+
+    // device lists from the last session, so that the configured devices
+    // can be opened without probing every device
+    mAudioEnumerator.loadCache(settings);
+    mMidiEnumerator.loadCache(settings);
 
     // apply the read in configuration
     Config config;
     config.readSettings(mAudioEnumerator, mMidiEnumerator);
+    timer.phase("read config");
     applyConfig(config, Config::CategoryAll);
     config.writeSettings(mAudioEnumerator, mMidiEnumerator);
+    timer.phase("apply config");
+
+    // refresh any cached device lists in the background
+    auto const audioBackend = config.sound().backendIndex();
+    auto const midiBackend = config.midi().backendIndex();
+    lazyconnect(&mDeviceScanner, finished, this, saveDeviceCache);
+    mDeviceScanner.scan(
+        mAudioEnumerator.isCached(audioBackend) ? audioBackend : -1,
+        mMidiEnumerator.isCached(midiBackend) ? midiBackend : -1
+    );
+    if (!mDeviceScanner.isScanning()) {
+        // nothing was cached, the lists were probed while reading the config
+        saveDeviceCache();
+    }
 
     setStyleSheet(QStringLiteral(R"stylesheet(
 QToolBar QLabel {
@@ -304,6 +335,8 @@ void MainWindow::setupUi() {
 
     setCentralWidget(centralWidget);
     mMidi.setReceiver(mPatternEditor);
+    mMidi.setRenderer(mRenderer);
+    mPatternEditor->setTimeline(&mRenderer->timeline());
 
     {
         auto grid = mPatternEditor->grid();
@@ -327,6 +360,7 @@ void MainWindow::setupUi() {
                 }
             }
             mPatternEditor->setInstrument(id);
+            updateMidiTarget();
         });
 
     connect(mWaveforms, &TableView::selectedItemChanged, this,
@@ -473,6 +507,14 @@ void MainWindow::setupUi() {
     auto scope = mSidebar->scope();
     scope->setBuffer(&mRenderer->visualizerBuffer());
     connect(mRenderer, &Renderer::updateVisualizers, scope, qOverload<>(&AudioScope::update));
+    auto spectrum = mSidebar->spectrum();
+    spectrum->setBuffer(&mRenderer->visualizerBuffer());
+    connect(mRenderer, &Renderer::updateVisualizers, spectrum, &AudioSpectrum::analyse);
+    connect(mRenderer, &Renderer::updateVisualizers, this,
+        [this]() {
+            auto const levels = mRenderer->levels();
+            mSidebar->peakMeter()->setLevels(levels.peakLeft, levels.peakRight, levels.rmsLeft, levels.rmsRight);
+        });
 
     lazyconnect(mRenderer, isPlayingChanged, mPatternModel, setPlaying);
 
@@ -483,6 +525,12 @@ void MainWindow::setupUi() {
 
     lazyconnect(mPatternModel, patternCountChanged, this, onPatternCountChanged);
     lazyconnect(mPatternModel, cursorPatternChanged, this, onPatternCursorChanged);
+    connect(mPatternModel, &PatternModel::cursorChanged, this,
+        [this](PatternModel::CursorChangeFlags flags) {
+            if (flags.testFlag(PatternModel::CursorTrackChanged)) {
+                updateMidiTarget();
+            }
+        });
     connect(mPatternModel, &PatternModel::aboutToRemoveLastPattern, this,
         [this]() {
             mRenderer->jumpToPattern(0);
@@ -581,10 +629,35 @@ void MainWindow::handleFocusChange(QWidget *oldWidget, QWidget *newWidget) {
             widget = widget->parentWidget();
         }
         mMidi.setReceiver(receiver);
+        updateMidiTarget();
     }
 
 }
 
+void MainWindow::updateMidiTarget() {
+    // same previews as the receivers do when notified by Midi
+    Renderer::PreviewTarget target{ Renderer::PreviewTarget::none, 0, -1 };
+    auto const receiver = mMidi.receiver();
+    if (receiver == mPatternEditor) {
+        target = {
+            Renderer::PreviewTarget::note,
+            mPatternModel->cursorTrack(),
+            mPatternEditor->instrument().value_or(-1)
+        };
+    } else if (mInstrumentEditor && receiver == mInstrumentEditor->piano()) {
+        auto const item = mInstrumentEditor->currentItem();
+        if (item != -1) {
+            target = { Renderer::PreviewTarget::instrument, 0, mInstrumentModel->id(item) };
+        }
+    } else if (mWaveEditor && receiver == mWaveEditor->piano()) {
+        auto const item = mWaveEditor->currentItem();
+        if (item != -1) {
+            target = { Renderer::PreviewTarget::waveform, 0, mWaveModel->id(item) };
+        }
+    }
+    mRenderer->setMidiTarget(target);
+}
+
 namespace TU {
 
 //
@@ -662,4 +735,16 @@ void MainWindow::configureActions(QWidget &widget, ShortcutTable const& shortcut
     }
 }
 
+void MainWindow::saveDeviceCache() {
+    #ifdef QT_DEBUG
+    if (!mSaveConfig) {
+        return;
+    }
+    #endif
+
+    QSettings settings;
+    mAudioEnumerator.saveCache(settings);
+    mMidiEnumerator.saveCache(settings);
+}
+
 #undef TU
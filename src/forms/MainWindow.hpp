@@ -10,14 +10,18 @@
 #include "model/SongModel.hpp"
 #include "model/SongListModel.hpp"
 #include "model/TableModel.hpp"
+#include "core/DeviceScanner.hpp"
 #include "core/Module.hpp"
 #include "core/ModuleFile.hpp"
+#include "core/StallDetector.hpp"
 #include "config/data/PianoInput.hpp"
 #include "forms/editors/InstrumentEditor.hpp"
 #include "forms/editors/WaveEditor.hpp"
 #include "forms/AudioDiagDialog.hpp"
+#include "forms/BulkEditDialog.hpp"
 #include "forms/TempoCalculator.hpp"
 #include "forms/CommentsDialog.hpp"
+#include "forms/FindUsageDialog.hpp"
 #include "midi/Midi.hpp"
 #include "widgets/PatternEditor.hpp"
 #include "widgets/Sidebar.hpp"
@@ -43,7 +47,7 @@ class MainWindow : public QMainWindow {
     Q_OBJECT
 
 public:
-    explicit MainWindow();
+    explicit MainWindow(StallDetector &stallDetector);
 
     virtual QMenu* createPopupMenu() override;
 
@@ -87,6 +91,8 @@ private:
     
     void onViewResetLayout();
 
+    void onHelpRecordTrace(bool record);
+
     void onMidiError();
 
     //
@@ -101,6 +107,8 @@ private:
     void showConfigDialog();
     void showExportWavDialog();
     void showTempoCalculator();
+    void showBulkEditDialog();
+    void showFindUsageDialog();
     void showInstrumentEditor();
     void showWaveEditor();
     void showHistory();
@@ -228,6 +236,12 @@ private:
     //
     void handleFocusChange(QWidget *oldWidget, QWidget *newWidget);
 
+    //
+    // Updates the renderer's MIDI preview target from the current midi
+    // receiver. Call when the receiver, or what it previews, changes.
+    //
+    void updateMidiTarget();
+
     //
     // Pushes the given filename to the recent files list. Each file that is
     // successfully opened and newly saved files should get added to this list
@@ -252,8 +266,16 @@ private:
     //
     void configureActions(QWidget &widget, ShortcutTable const& shortcuts);
 
+    //
+    // Saves the device lists of the enumerators, for the next session.
+    //
+    void saveDeviceCache();
+
     AudioEnumerator mAudioEnumerator;
     MidiEnumerator mMidiEnumerator;
+    // refreshes the cached device lists after startup
+    DeviceScanner mDeviceScanner;
+    StallDetector &mStallDetector;
     QString const mUntitledString;
 
     #ifdef QT_DEBUG
@@ -288,6 +310,8 @@ private:
     // dialogs
     AudioDiagDialog *mAudioDiag;
     TempoCalculator *mTempoCalc;
+    BulkEditDialog *mBulkEditDialog;
+    FindUsageDialog *mFindUsageDialog;
     CommentsDialog *mCommentsDialog;
     InstrumentEditor *mInstrumentEditor;
     WaveEditor *mWaveEditor;
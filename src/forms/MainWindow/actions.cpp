@@ -4,6 +4,8 @@
 #include "utils/actions.hpp"
 #include "utils/connectutils.hpp"
 #include "utils/IconLocator.hpp"
+#include "utils/LockProfiler.hpp"
+#include "utils/Trace.hpp"
 
 #include <QAction>
 #include <QApplication>
@@ -159,6 +161,9 @@ void MainWindow::createActions(TableActions const& instrumentActions, TableActio
     act->setData(ShortcutTable::ReplaceInstrument);
     connectActionTo(act, mPatternEditor, replaceInstrument);
 
+    act = setupAction(menuEdit, tr("&Find usage..."), tr("Finds the rows using an instrument, waveform or effect"), QKeySequence::Find);
+    connectActionToThis(act, showFindUsageDialog);
+
     menuEdit->addSeparator(); // ----------------------------------------------
 
     act = setupAction(menuEdit, tr("Key repetition"), tr("Toggles key repetition for pattern editor"));
@@ -209,6 +214,9 @@ void MainWindow::createActions(TableActions const& instrumentActions, TableActio
     act = setupAction(menuSong, tr("Tempo calculator..."), tr("Shows the tempo calculator dialog"));
     connectActionToThis(act, showTempoCalculator);
 
+    act = setupAction(menuSong, tr("Bulk edit..."), tr("Transposes, replaces instruments or scales volume in the entire song"));
+    connectActionToThis(act, showBulkEditDialog);
+
     // > Instrument ===========================================================
     auto menuInstrument = menubar->addMenu(tr("Instrument"));
 
@@ -343,6 +351,27 @@ void MainWindow::createActions(TableActions const& instrumentActions, TableActio
 
     act = setupAction(menuHelp, tr("Audio diagnostics..."), tr("Shows the audio diagnostics dialog"));
     connectActionToThis(act, showAudioDiag);
+
+    act = setupAction(menuHelp, tr("Record trace"), tr("Records what each thread is doing, and saves it as a trace when stopped"));
+    act->setCheckable(true);
+    // may have been started from the command line
+    act->setChecked(Trace::isEnabled());
+    connectActionToThis(act, onHelpRecordTrace);
+
+    #ifdef TRACKERBOY_LOCK_PROFILING
+    act = setupAction(menuHelp, tr("Lock profile..."), tr("Shows the wait and hold times of the shared locks"));
+    connect(act, &QAction::triggered, this, [this]() {
+        QMessageBox msgbox(this);
+        msgbox.setIcon(QMessageBox::Information);
+        msgbox.setWindowTitle(tr("Lock profile"));
+        msgbox.setText(tr("Lock statistics since startup or the last reset."));
+        msgbox.setDetailedText(LockStats::report());
+        msgbox.setStandardButtons(QMessageBox::Ok | QMessageBox::Reset);
+        if (msgbox.exec() == QMessageBox::Reset) {
+            LockStats::resetAll();
+        }
+    });
+    #endif
     
     menuHelp->addSeparator(); // ----------------------------------------------
     
@@ -4,11 +4,13 @@
 
 #include "utils/connectutils.hpp"
 #include "utils/string.hpp"
+#include "utils/Trace.hpp"
 #include "export/ExportWavDialog.hpp"
 #include "forms/ModulePropertiesDialog.hpp"
 #include "widgets/TableView.hpp"
 
 #include <QApplication>
+#include <QDir>
 #include <QElapsedTimer>
 #include <QFileDialog>
 #include <QStringBuilder>
@@ -244,6 +246,33 @@ void MainWindow::onViewResetLayout() {
     initSplitters();
 }
 
+void MainWindow::onHelpRecordTrace(bool record) {
+    if (record) {
+        Trace::start();
+        Trace::setThreadName("GUI");
+        return;
+    }
+
+    Trace::stop();
+    auto path = QFileDialog::getSaveFileName(
+        this,
+        tr("Save trace"),
+        QStringLiteral("trackerboy-trace.json"),
+        tr("Chrome trace (*.json)")
+    );
+    if (path.isEmpty()) {
+        return;
+    }
+
+    if (!Trace::write(path)) {
+        QMessageBox::critical(
+            this,
+            tr("Could not save trace"),
+            tr("The trace could not be written to %1").arg(QDir::toNativeSeparators(path))
+        );
+    }
+}
+
 void MainWindow::onMidiError() {
     if (isVisible()) {
         QMessageBox msgbox(this);
@@ -274,6 +303,9 @@ Config::Categories MainWindow::applyConfig(Config const& config, Config::Categor
 
         // page step
         mPatternEditor->setPageStep(general.pageStep());
+
+        // undo history
+        mModule->setUndoMemoryLimit((size_t)general.undoMemoryLimit() * 1024 * 1024);
     }
 
 
@@ -310,6 +342,7 @@ Config::Categories MainWindow::applyConfig(Config const& config, Config::Categor
         orderGrid->setColors(mPalette);
 
         mSidebar->scope()->setColors(mPalette);
+        mSidebar->spectrum()->setColors(mPalette);
         if (mInstrumentEditor) {
             mInstrumentEditor->setColors(mPalette);
         }
@@ -341,6 +374,7 @@ Config::Categories MainWindow::applyConfig(Config const& config, Config::Categor
 
     if (categories.testFlag(Config::CategoryMidi)) {
         auto const& midiConfig = config.midi();
+        mPatternEditor->setRecordQuantize(midiConfig.recordQuantize());
 
         if (!midiConfig.isEnabled() || midiConfig.portIndex() == -1) {
             mMidi.close();
@@ -367,7 +401,7 @@ void MainWindow::showAboutDialog() {
 
 void MainWindow::showAudioDiag() {
     if (mAudioDiag == nullptr) {
-        mAudioDiag = new AudioDiagDialog(*mRenderer, this);
+        mAudioDiag = new AudioDiagDialog(*mRenderer, mStallDetector, this);
     }
 
     mAudioDiag->show();
@@ -375,6 +409,9 @@ void MainWindow::showAudioDiag() {
 
 void MainWindow::showConfigDialog() {
 
+    // devices are addressed by index, which a scan in progress may change
+    mDeviceScanner.wait();
+
     Config config;
     config.readSettings(mAudioEnumerator, mMidiEnumerator);
 
@@ -425,6 +462,20 @@ void MainWindow::showTempoCalculator() {
     mTempoCalc->show();
 }
 
+void MainWindow::showBulkEditDialog() {
+    if (mBulkEditDialog == nullptr) {
+        mBulkEditDialog = new BulkEditDialog(*mPatternModel, this);
+    }
+    mBulkEditDialog->show();
+}
+
+void MainWindow::showFindUsageDialog() {
+    if (mFindUsageDialog == nullptr) {
+        mFindUsageDialog = new FindUsageDialog(*mModule, *mPatternModel, this);
+    }
+    mFindUsageDialog->show();
+}
+
 void MainWindow::showInstrumentEditor() {
     if (mInstrumentEditor == nullptr) {
         mInstrumentEditor = new InstrumentEditor(*mModule, *mInstrumentModel, *mWaveModel, mPianoInput, this);
@@ -442,6 +493,7 @@ void MainWindow::showInstrumentEditor() {
         lazyconnect(piano, keyChange, mRenderer, setPreviewNote);
         lazyconnect(piano, keyUp, mRenderer, stopPreview);
         lazyconnect(mInstrumentEditor, openWaveEditor, this, editWaveform);
+        lazyconnect(mInstrumentEditor, currentItemChanged, this, updateMidiTarget);
     }
 
     mInstrumentEditor->show();
@@ -462,6 +514,7 @@ void MainWindow::showWaveEditor() {
             });
         lazyconnect(piano, keyChange, mRenderer, setPreviewNote);
         lazyconnect(piano, keyUp, mRenderer, stopPreview);
+        lazyconnect(mWaveEditor, currentItemChanged, this, updateMidiTarget);
     }
     mWaveEditor->show();
 }
@@ -471,8 +524,34 @@ void MainWindow::showHistory() {
         mHistoryDialog = new PersistantDialog(this, Qt::WindowTitleHint | Qt::WindowSystemMenuHint | Qt::WindowCloseButtonHint);
         auto layout = new QVBoxLayout;
         auto undoView = new QUndoView(mModule->undoGroup());
+        auto memoryLabel = new QLabel;
         layout->addWidget(undoView);
+        layout->addWidget(memoryLabel);
         mHistoryDialog->setLayout(layout);
+
+        auto updateMemoryLabel = [this, memoryLabel]() {
+            auto const locale = memoryLabel->locale();
+            memoryLabel->setText(tr("Memory: %1 / %2").arg(
+                locale.formattedDataSize((qint64)mModule->undoMemoryUsage()),
+                locale.formattedDataSize((qint64)mModule->undoMemoryLimit())
+            ));
+        };
+        updateMemoryLabel();
+        connect(mModule, &Module::undoMemoryChanged, memoryLabel, updateMemoryLabel);
+
+        // row 0 is the empty state and row n is the state after the nth
+        // command, so the states before the last trimmed command are hidden
+        auto hideTrimmed = [this, undoView]() {
+            auto const trimmed = mModule->undoTrimmedCount(mModule->undoStack());
+            for (int row = 0; row < trimmed; ++row) {
+                undoView->setRowHidden(row, true);
+            }
+        };
+        hideTrimmed();
+        // the view's model is reset whenever the active stack or its index
+        // changes, which clears any hidden rows
+        connect(undoView->model(), &QAbstractItemModel::modelReset, undoView, hideTrimmed);
+        connect(mModule, &Module::undoMemoryChanged, undoView, hideTrimmed);
         mHistoryDialog->setWindowTitle(tr("History"));
     } 
     mHistoryDialog->show();
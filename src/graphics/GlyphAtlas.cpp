@@ -0,0 +1,96 @@
+
+#include "graphics/GlyphAtlas.hpp"
+
+#include <QPainter>
+
+#include <cmath>
+
+#define TU GlyphAtlasTU
+namespace TU {
+
+// cells are stored for printable ASCII, and CELL_NONE (0x7F)
+constexpr int FIRST_CHAR = 0x20;
+constexpr int CHAR_COUNT = 0x80 - FIRST_CHAR;
+
+}
+
+GlyphAtlas::GlyphAtlas() :
+    mPixmap(),
+    mDevicePixelRatio(1.0),
+    mCellWidth(0.0),
+    mCellHeight(0.0),
+    mValid(false)
+{
+}
+
+bool GlyphAtlas::isValid() const {
+    return mValid;
+}
+
+void GlyphAtlas::invalidate() {
+    mValid = false;
+}
+
+void GlyphAtlas::build(
+    QFont const& font,
+    int cellWidth,
+    int cellHeight,
+    std::vector<QColor> const& colors,
+    qreal devicePixelRatio
+) {
+    mDevicePixelRatio = devicePixelRatio;
+    mCellWidth = cellWidth * devicePixelRatio;
+    mCellHeight = cellHeight * devicePixelRatio;
+
+    mPixmap = QPixmap(
+        (int)std::ceil(mCellWidth * TU::CHAR_COUNT),
+        (int)std::ceil(mCellHeight * colors.size())
+    );
+    mPixmap.setDevicePixelRatio(devicePixelRatio);
+    mPixmap.fill(Qt::transparent);
+
+    QPainter painter(&mPixmap);
+    painter.setFont(font);
+
+    QString str(1, '\0');
+    int ypos = 0;
+    for (auto const& color : colors) {
+        painter.setPen(color);
+        int xpos = 0;
+        for (int i = 0; i < TU::CHAR_COUNT; ++i) {
+            auto const ch = (char)(TU::FIRST_CHAR + i);
+            if (ch == CELL_NONE) {
+                // same as PatternPainter::drawNone
+                auto const liney = ypos + cellHeight / 2;
+                painter.drawLine(xpos + 3, liney, xpos + cellWidth - 3, liney);
+            } else {
+                str[0] = ch;
+                painter.drawText(xpos, ypos, cellWidth, cellHeight, Qt::AlignBottom, str);
+            }
+            xpos += cellWidth;
+        }
+        ypos += cellHeight;
+    }
+
+    mValid = true;
+}
+
+qreal GlyphAtlas::devicePixelRatio() const {
+    return mDevicePixelRatio;
+}
+
+QPixmap const& GlyphAtlas::pixmap() const {
+    return mPixmap;
+}
+
+QRectF GlyphAtlas::cell(int color, char ch) const {
+    Q_ASSERT(ch >= TU::FIRST_CHAR);
+    return {
+        (ch - TU::FIRST_CHAR) * mCellWidth,
+        color * mCellHeight,
+        mCellWidth,
+        mCellHeight
+    };
+}
+
+#undef TU
@@ -0,0 +1,72 @@
+
+#pragma once
+
+#include <QColor>
+#include <QFont>
+#include <QPixmap>
+#include <QRectF>
+
+#include <vector>
+
+//
+// Pixmap of pre-rasterised cells, one for each paintable character in each of
+// a set of colors. Painting a cell from the atlas is a single pixmap copy, as
+// opposed to laying out and rasterising text with QPainter::drawText.
+//
+// Cells are transparent except for the glyph, so they can be drawn over any
+// background.
+//
+class GlyphAtlas {
+
+public:
+
+    //
+    // Character for an empty cell, a horizontal line centered in the cell
+    //
+    static constexpr char CELL_NONE = '\x7F';
+
+    GlyphAtlas();
+
+    //
+    // Returns true if the atlas has been built and not invalidated since.
+    //
+    bool isValid() const;
+
+    //
+    // Marks the atlas for rebuilding, call when the font or colors change.
+    //
+    void invalidate();
+
+    //
+    // Rasterises all cells, for the given font, cell size and colors. The
+    // atlas is rendered at the given device pixel ratio, so that cells are
+    // copied 1:1 on high DPI screens.
+    //
+    void build(
+        QFont const& font,
+        int cellWidth,
+        int cellHeight,
+        std::vector<QColor> const& colors,
+        qreal devicePixelRatio
+    );
+
+    qreal devicePixelRatio() const;
+
+    QPixmap const& pixmap() const;
+
+    //
+    // Gets the source rectangle, in pixmap pixels, of the cell for the given
+    // character and color index.
+    //
+    QRectF cell(int color, char ch) const;
+
+private:
+
+    QPixmap mPixmap;
+    qreal mDevicePixelRatio;
+    // size of a cell, in pixmap pixels
+    qreal mCellWidth;
+    qreal mCellHeight;
+    bool mValid;
+
+};
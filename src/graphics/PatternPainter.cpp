@@ -1,6 +1,8 @@
 
 #include "graphics/PatternPainter.hpp"
 
+#include "core/EffectStrings.hpp"
+
 #include "trackerboy/note.hpp"
 
 #include <QPainter>
@@ -8,60 +10,137 @@
 #define TU PatternPainterTU
 namespace TU {
 
-// TODO: move this somewhere in the library
-static char effectTypeToChar(trackerboy::EffectType et) {
-
-    switch (et) {
-        case trackerboy::EffectType::patternGoto:
-            return 'B';
-        case trackerboy::EffectType::patternHalt:
-            return 'C';
-        case trackerboy::EffectType::patternSkip:
-            return 'D';
-        case trackerboy::EffectType::setTempo:
-            return 'F';
-        case trackerboy::EffectType::sfx:
-            return 'T';
-        case trackerboy::EffectType::setEnvelope:
-            return 'E';
-        case trackerboy::EffectType::setTimbre:
-            return 'V';
-        case trackerboy::EffectType::setPanning:
-            return 'I';
-        case trackerboy::EffectType::setSweep:
-            return 'H';
-        case trackerboy::EffectType::delayedCut:
-            return 'S';
-        case trackerboy::EffectType::delayedNote:
-            return 'G';
-        case trackerboy::EffectType::lock:
-            return 'L';
-        case trackerboy::EffectType::arpeggio:
-            return '0';
-        case trackerboy::EffectType::pitchUp:
-            return '1';
-        case trackerboy::EffectType::pitchDown:
-            return '2';
-        case trackerboy::EffectType::autoPortamento:
-            return '3';
-        case trackerboy::EffectType::vibrato:
-            return '4';
-        case trackerboy::EffectType::vibratoDelay:
-            return '5';
-        case trackerboy::EffectType::tuning:
-            return 'P';
-        case trackerboy::EffectType::noteSlideUp:
-            return 'Q';
-        case trackerboy::EffectType::noteSlideDown:
-            return 'R';
-        case trackerboy::EffectType::setGlobalVolume:
-            return 'J';
-        default:
-            return '?';
+static const char HEX_CHARS[] = "0123456789ABCDEF";
+
+//
+// Appends pixmap fragments for the cells of a row, for drawPatternAtlas.
+// Fragments are positioned by their center, and scaled from pixmap pixels to
+// logical pixels.
+//
+struct AtlasWriter {
+    GlyphAtlas const& atlas;
+    std::vector<QPainter::PixmapFragment> &fragments;
+    std::vector<std::pair<QRect, int>> &noteCuts;
+    NoteStrings::NoteTable const& noteTable;
+    int const cellWidth;
+    int const cellHeight;
+    qreal const halfWidth;
+    qreal const halfHeight;
+    qreal const scale;
+
+    int cell(int color, char ch, int xpos, int ypos) {
+        fragments.push_back(QPainter::PixmapFragment::create(
+            QPointF(xpos + halfWidth, ypos + halfHeight),
+            atlas.cell(color, ch),
+            scale,
+            scale
+        ));
+        return xpos + cellWidth;
+    }
+
+    int hex(int color, int value, int xpos, int ypos) {
+        xpos = cell(color, HEX_CHARS[(value >> 4) & 0xF], xpos, ypos);
+        return cell(color, HEX_CHARS[value & 0xF], xpos, ypos);
+    }
+
+    int none(int color, int cells, int xpos, int ypos) {
+        for (int i = cells; i--; ) {
+            xpos = cell(color, GlyphAtlas::CELL_NONE, xpos, ypos);
+        }
+        return xpos;
+    }
+};
+
+// color indices in the glyph atlas, indices 0-2 are the foreground colors
+constexpr int ATLAS_INSTRUMENT = 3;
+constexpr int ATLAS_EFFECT = 4;
+
+//
+// Row kernels. These are instantiated for every layout a track can have, so
+// that the number of effects and note names are known at compile time and
+// the cells of a track are composed without branching on the layout.
+//
+
+template <bool hex>
+static void drawRowno(AtlasWriter &w, int rowno, int fg, int ypos) {
+    if constexpr (hex) {
+        w.hex(fg, rowno, PatternLayout::SPACING, ypos);
+    } else {
+        auto xpos = w.cell(fg, (char)('0' + (rowno / 100)), PatternLayout::SPACING, ypos);
+        xpos = w.cell(fg, (char)('0' + (rowno / 10 % 10)), xpos, ypos);
+        w.cell(fg, (char)('0' + (rowno % 10)), xpos, ypos);
     }
 }
 
-} // namespace TU
+// effect count for the generic kernel, which gets the count and note table
+// at runtime
+constexpr int EFFECTS_ANY = 0;
+
+template <int effects, bool flats>
+static int drawTrack(AtlasWriter &w, trackerboy::TrackRow const& rowdata, int effectsVisible, int fg, int xpos, int ypos) {
+    NoteStrings::NoteTable const* noteTable;
+    if constexpr (effects == EFFECTS_ANY) {
+        noteTable = &w.noteTable;
+    } else {
+        noteTable = flats ? &NoteStrings::Flats : &NoteStrings::Sharps;
+        effectsVisible = effects;
+    }
+
+    auto note = rowdata.queryNote();
+    if (note) {
+        if (*note == trackerboy::NOTE_CUT) {
+            w.noteCuts.emplace_back(QRect(xpos, ypos + w.cellHeight / 2, w.cellWidth * 2, 4), fg);
+            xpos += w.cellWidth * 3;
+        } else {
+            auto notestr = (*noteTable)[*note % 12];
+            xpos = w.cell(fg, notestr[0], xpos, ypos);
+            xpos = w.cell(fg, notestr[1], xpos, ypos);
+            xpos = w.cell(fg, (char)('0' + *note / 12 + 2), xpos, ypos);
+        }
+    } else {
+        xpos = w.none(fg, 3, xpos, ypos);
+    }
+
+    xpos += PatternLayout::SPACING;
+    auto instrument = rowdata.queryInstrument();
+    if (instrument) {
+        xpos = w.hex(ATLAS_INSTRUMENT, *instrument, xpos, ypos);
+    } else {
+        xpos = w.none(fg, 2, xpos, ypos);
+    }
+
+    xpos += PatternLayout::SPACING;
+
+    for (int effect = 0; effect < effectsVisible; ++effect) {
+        auto effectdata = rowdata.effects[effect];
+        if (effectdata.type != trackerboy::EffectType::noEffect) {
+            xpos = w.cell(ATLAS_EFFECT, EffectStrings::toChar(effectdata.type), xpos, ypos);
+            xpos = w.hex(fg, effectdata.param, xpos, ypos);
+        } else {
+            xpos = w.none(fg, 3, xpos, ypos);
+        }
+
+        xpos += PatternLayout::SPACING;
+    }
+
+    return xpos + PatternLayout::LINE_WIDTH + PatternLayout::SPACING;
+}
+
+using RownoKernel = void (*)(AtlasWriter&, int, int, int);
+using TrackKernel = int (*)(AtlasWriter&, trackerboy::TrackRow const&, int, int, int, int);
+
+// dispatch tables, indexed by [rownoHex]
+constexpr RownoKernel ROWNO_KERNELS[2] = { drawRowno<false>, drawRowno<true> };
+
+// indexed by [flats][effectsVisible - 1]
+constexpr TrackKernel TRACK_KERNELS[2][3] = {
+    { drawTrack<1, false>, drawTrack<2, false>, drawTrack<3, false> },
+    { drawTrack<1, true>, drawTrack<2, true>, drawTrack<3, true> }
+};
+
+constexpr TrackKernel TRACK_KERNEL_ANY = drawTrack<EFFECTS_ANY, false>;
+
+}
 
 // NOTE
 // Do not create temporary QPens! The member variable, mPen, should be used
@@ -82,9 +161,15 @@ PatternPainter::PatternPainter(QFont const& font) :
     mColorCursor(),
     mColorLine(),
     mRowColors(),
-    mPen()
+    mPen(),
+    mFont(font),
+    mUseAtlas(true),
+    mUseRowKernels(true),
+    mAtlas(),
+    mFragments(),
+    mNoteCuts()
 {
-    setFont(font);
+    CellPainter::setFont(font);
 }
 
 bool PatternPainter::flats() const {
@@ -105,6 +190,28 @@ void PatternPainter::setFlats(bool flats) {
     mNoteTable = (flats) ? &NoteStrings::Flats : &NoteStrings::Sharps;
 }
 
+void PatternPainter::setFont(QFont const& font) {
+    CellPainter::setFont(font);
+    mFont = font;
+    mAtlas.invalidate();
+}
+
+bool PatternPainter::usesGlyphAtlas() const {
+    return mUseAtlas;
+}
+
+void PatternPainter::setUseGlyphAtlas(bool use) {
+    mUseAtlas = use;
+}
+
+bool PatternPainter::usesRowKernels() const {
+    return mUseRowKernels;
+}
+
+void PatternPainter::setUseRowKernels(bool use) {
+    mUseRowKernels = use;
+}
+
 void PatternPainter::setColors(Palette const& colors) {
     mForegroundColors[0] = colors[Palette::ColorForeground];
     mForegroundColors[1] = colors[Palette::ColorForegroundHighlight1];
@@ -127,6 +234,7 @@ void PatternPainter::setColors(Palette const& colors) {
         color.setAlpha(128);
     }
 
+    mAtlas.invalidate();
 }
 
 void PatternPainter::drawRowBackground(QPainter &p, PatternLayout const& l, RowType type, int row) const {
@@ -193,6 +301,93 @@ int PatternPainter::drawPattern(
     int rowStart,
     int rowEnd,
     int ypos
+) const {
+    if (mUseAtlas) {
+        return drawPatternAtlas(p, l, pattern, rowStart, rowEnd, ypos);
+    } else {
+        return drawPatternText(p, l, pattern, rowStart, rowEnd, ypos);
+    }
+}
+
+int PatternPainter::drawPatternAtlas(
+    QPainter &p,
+    PatternLayout const& l,
+    trackerboy::Pattern const& pattern,
+    int rowStart,
+    int rowEnd,
+    int ypos
+) const {
+    auto const _cellWidth = cellWidth();
+    auto const _cellHeight = cellHeight();
+    auto const start = l.patternStart();
+
+    auto const dpr = p.device()->devicePixelRatioF();
+    if (!mAtlas.isValid() || mAtlas.devicePixelRatio() != dpr) {
+        std::vector<QColor> colors(mForegroundColors.begin(), mForegroundColors.end());
+        colors.push_back(mColorInstrument);
+        colors.push_back(mColorEffect);
+        mAtlas.build(mFont, _cellWidth, _cellHeight, colors, dpr);
+    }
+
+    mFragments.clear();
+    mNoteCuts.clear();
+
+    TU::AtlasWriter writer{
+        mAtlas,
+        mFragments,
+        mNoteCuts,
+        *mNoteTable,
+        _cellWidth,
+        _cellHeight,
+        _cellWidth * 0.5,
+        _cellHeight * 0.5,
+        1.0 / dpr
+    };
+
+    // select the kernels for this layout, once for all rows
+    std::array<TU::TrackKernel, 4> trackKernels;
+    std::array<int, 4> effectsVisible;
+    for (int track = 0; track < 4; ++track) {
+        effectsVisible[track] = l.effectsVisible(track);
+        trackKernels[track] = mUseRowKernels
+            ? TU::TRACK_KERNELS[flats()][effectsVisible[track] - 1]
+            : TU::TRACK_KERNEL_ANY;
+    }
+    auto const rownoKernel = TU::ROWNO_KERNELS[l.rownoHex()];
+
+    mFragments.reserve((size_t)(rowEnd - rowStart + 1) * (3 + (5 + 3 * 3) * 4));
+
+    // text centering
+    ypos++;
+
+    for (int rowno = rowStart; rowno <= rowEnd; ++rowno) {
+        auto const fg = highlightIndex(rowno);
+        rownoKernel(writer, rowno, fg, ypos);
+
+        int xpos = start + PatternLayout::SPACING;
+        for (int track = 0; track <= 3; ++track) {
+            auto &trackdata = pattern.getTrackRow(static_cast<trackerboy::ChType>(track), rowno);
+            xpos = trackKernels[track](writer, trackdata, effectsVisible[track], fg, xpos, ypos);
+        }
+
+        ypos += _cellHeight;
+    }
+
+    p.drawPixmapFragments(mFragments.data(), (int)mFragments.size(), mAtlas.pixmap());
+    for (auto const& [rect, fg] : mNoteCuts) {
+        p.fillRect(rect, mForegroundColors[fg]);
+    }
+
+    return ypos - 1;
+}
+
+int PatternPainter::drawPatternText(
+    QPainter &p,
+    PatternLayout const& l,
+    trackerboy::Pattern const& pattern,
+    int rowStart,
+    int rowEnd,
+    int ypos
 ) const {
     auto const _cellHeight = cellHeight();
     auto const start = l.patternStart();
@@ -235,7 +430,7 @@ int PatternPainter::drawPattern(
                 if (effectdata.type != trackerboy::EffectType::noEffect) {
                     p.setPen(mPen.get(mColorEffect));
 
-                    xpos = drawCell(p, TU::effectTypeToChar(effectdata.type), xpos, ypos);
+                    xpos = drawCell(p, EffectStrings::toChar(effectdata.type), xpos, ypos);
 
                     p.setPen(mPen.get(fgcolor));
                     xpos = drawHex(p, effectdata.param, xpos, ypos);
@@ -7,13 +7,17 @@
 #include "core/NoteStrings.hpp"
 #include "graphics/CachedPen.hpp"
 #include "graphics/CellPainter.hpp"
+#include "graphics/GlyphAtlas.hpp"
 #include "graphics/PatternLayout.hpp"
 
 #include "trackerboy/data/Pattern.hpp"
 
 #include <QColor>
+#include <QPainter>
 
 #include <array>
+#include <utility>
+#include <vector>
 
 
 class PatternPainter : public CellPainter {
@@ -41,6 +45,35 @@ public:
 
     void setFlats(bool flats);
 
+    //
+    // Sets the font used for pattern data. Hides CellPainter::setFont so that
+    // the glyph atlas is rebuilt for the new font.
+    //
+    void setFont(QFont const& font);
+
+    //
+    // Returns true if pattern data is painted from a glyph atlas (default)
+    //
+    bool usesGlyphAtlas() const;
+
+    //
+    // Enables or disables painting pattern data from a glyph atlas. When
+    // disabled, each cell is painted with QPainter::drawText.
+    //
+    void setUseGlyphAtlas(bool use);
+
+    //
+    // Returns true if rows painted from the glyph atlas are composed by row
+    // kernels specialised for the layout (default)
+    //
+    bool usesRowKernels() const;
+
+    //
+    // Enables or disables the specialised row kernels. When disabled, a
+    // generic kernel is used that checks the layout for every track.
+    //
+    void setUseRowKernels(bool use);
+
     // drawing functions
 
     //
@@ -90,6 +123,29 @@ public:
 private:
 
     int highlightIndex(int rowno) const;
+
+    //
+    // drawPattern implementation composing rows from the glyph atlas, with a
+    // single QPainter::drawPixmapFragments call
+    //
+    int drawPatternAtlas(
+        QPainter &p, PatternLayout const& l,
+        trackerboy::Pattern const& pattern,
+        int rowStart,
+        int rowEnd,
+        int ypos
+    ) const;
+
+    //
+    // drawPattern implementation using QPainter::drawText for each cell
+    //
+    int drawPatternText(
+        QPainter &p, PatternLayout const& l,
+        trackerboy::Pattern const& pattern,
+        int rowStart,
+        int rowEnd,
+        int ypos
+    ) const;
     
     int mHighlightInterval1;
     int mHighlightInterval2;
@@ -110,5 +166,13 @@ private:
 
     CachedPen mutable mPen;
 
+    QFont mFont;
+    bool mUseAtlas;
+    bool mUseRowKernels;
+    GlyphAtlas mutable mAtlas;
+    // scratch buffers for drawPatternAtlas, kept to avoid reallocating
+    std::vector<QPainter::PixmapFragment> mutable mFragments;
+    std::vector<std::pair<QRect, int>> mutable mNoteCuts;
+
 
 };
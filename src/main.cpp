@@ -1,5 +1,9 @@
 
+#include "core/StallDetector.hpp"
 #include "forms/MainWindow.hpp"
+#include "utils/LockProfiler.hpp"
+#include "utils/PhaseTimer.hpp"
+#include "utils/Trace.hpp"
 
 #include <QApplication>
 #include <QCommandLineParser>
@@ -7,7 +11,6 @@
 #include <QFontDatabase>
 #include <QFile>
 #include <QFileInfo>
-#include <QElapsedTimer>
 #include <QMessageBox>
 #include <QPointer>
 #include <QStringBuilder>
@@ -98,16 +101,31 @@ private:
 };
 
 //
-// custom QApplication subclass that catches any uncaught exceptions
+// custom QApplication subclass that catches any uncaught exceptions, and
+// reports the events it dispatches to the stall detector
 //
 class Application final : public QApplication {
 
     Q_OBJECT
 
 public:
-    using QApplication::QApplication;
+    Application(int &argc, char **argv) :
+        QApplication(argc, argv),
+        mStallDetector(std::make_unique<StallDetector>())
+    {
+    }
+
+    ~Application() {
+        // events sent while the application is destroyed are not reported
+        mStallDetector.reset();
+    }
+
+    StallDetector& stallDetector() {
+        return *mStallDetector;
+    }
 
     virtual bool notify(QObject *receiver, QEvent *evt) override {
+        StallDetector::Dispatch dispatch(mStallDetector.get(), receiver, evt);
         try {
             return QApplication::notify(receiver, evt);
         } catch (std::bad_alloc &) {
@@ -123,6 +141,9 @@ public:
         }
     }
 
+private:
+    std::unique_ptr<StallDetector> mStallDetector;
+
 };
 
 
@@ -131,10 +152,7 @@ int main(int argc, char *argv[]) {
 
     int code;
 
-    #ifndef QT_NO_INFO_OUTPUT
-    QElapsedTimer timer;
-    timer.start();
-    #endif
+    PhaseTimer timer("[Startup]");
 
     Application app(argc, argv);
     QCoreApplication::setOrganizationName("Trackerboy");
@@ -150,9 +168,21 @@ int main(int argc, char *argv[]) {
     parser.addHelpOption();
     parser.addVersionOption();
     parser.addPositionalArgument("[module_file]", main_tr("(Optional) the module file to open"));
+    QCommandLineOption traceOption(
+        QStringLiteral("trace"),
+        main_tr("Records a trace of the session, written to <file> on exit. The trace can be viewed in chrome://tracing or ui.perfetto.dev"),
+        main_tr("file")
+    );
+    parser.addOption(traceOption);
 
     parser.process(app);
 
+    auto const traceFile = parser.value(traceOption);
+    if (!traceFile.isEmpty()) {
+        Trace::start();
+        Trace::setThreadName("GUI");
+    }
+
     QString fileToOpen;
     auto const positionals = parser.positionalArguments();
     switch (positionals.size()) {
@@ -176,10 +206,13 @@ int main(int argc, char *argv[]) {
 
     // instantiate the custom message handler for logging to file
     MessageHandler::instance();
+    timer.phase("application");
    
-    auto win = std::make_unique<MainWindow>();
+    auto win = std::make_unique<MainWindow>(app.stallDetector());
     MessageHandler::instance().setWindow(win.get());
+    timer.phase("main window");
     win->show();
+    timer.phase("show");
 
     if (!fileToOpen.isEmpty()) {
         QFileInfo info(fileToOpen);
@@ -197,6 +230,7 @@ int main(int argc, char *argv[]) {
             );
         } else {
             win->openFile(fileToOpen);
+            timer.phase("open module");
         }
     }
 
@@ -212,6 +246,18 @@ int main(int argc, char *argv[]) {
         return EXIT_BAD_ALLOC;
     }
 
+    #ifdef TRACKERBOY_LOCK_PROFILING
+    // written directly, as info messages are disabled for release builds
+    fputs(qPrintable(LockStats::report()), stderr);
+    #endif
+
+    if (!traceFile.isEmpty()) {
+        Trace::stop();
+        if (!Trace::write(traceFile)) {
+            qCritical() << "could not write trace to" << traceFile;
+        }
+    }
+
     return code;
 }
 
@@ -1,17 +1,27 @@
 
 #pragma once
 
+#include <chrono>
+
 //
-// Interface for receiving MIDI input messages
+// Interface for receiving MIDI input messages. previewed is true when the
+// note was already sent to the renderer for previewing, in which case the
+// receiver should only update its display or record the note.
 //
 class IMidiReceiver {
 
 
 public:
 
-    virtual void midiNoteOn(int note) = 0;
+    using Clock = std::chrono::steady_clock;
+
+    //
+    // time is when the message was received by the MIDI thread, which may be
+    // some time before this is called.
+    //
+    virtual void midiNoteOn(int note, bool previewed, Clock::time_point time) = 0;
 
-    virtual void midiNoteOff() = 0;
+    virtual void midiNoteOff(bool previewed) = 0;
 
 protected:
     IMidiReceiver() = default;
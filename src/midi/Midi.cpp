@@ -36,9 +36,16 @@ public:
         NoteOff
     };
 
-    explicit MidiEvent(Message msg, int note = -1) :
+    explicit MidiEvent(
+        Message msg,
+        bool previewed,
+        IMidiReceiver::Clock::time_point time,
+        int note = -1
+    ) :
         QEvent(getType()),
         mMessage(msg),
+        mPreviewed(previewed),
+        mTime(time),
         mNote(note)
     {
 
@@ -51,6 +58,20 @@ public:
         return mMessage;
     }
 
+    //
+    // Determines if the message was sent to the renderer for previewing
+    //
+    bool previewed() const {
+        return mPreviewed;
+    }
+
+    //
+    // Get the time the message was received
+    //
+    IMidiReceiver::Clock::time_point time() const {
+        return mTime;
+    }
+
     //
     // Get the note pressed if the message type was NoteOn
     //
@@ -66,6 +87,8 @@ public:
 
 private:
     Message const mMessage;
+    bool const mPreviewed;
+    IMidiReceiver::Clock::time_point const mTime;
     int const mNote;
 
 
@@ -77,6 +100,7 @@ private:
 Midi::Midi(QObject *parent) :
     QObject(parent),
     mReceiver(nullptr),
+    mRenderer(nullptr),
     mNoteDown(false),
     mMidiIn(),
     mMutex(),
@@ -167,7 +191,7 @@ void Midi::setReceiver(IMidiReceiver *receiver) {
             // force the note off
             // if we don't do this, the previous receiver won't get the next noteOff message
             // and the note will be held indefinitely
-            mReceiver->midiNoteOff();
+            mReceiver->midiNoteOff(false);
             mNoteDown = false;
         }
         mReceiver = receiver;
@@ -175,19 +199,32 @@ void Midi::setReceiver(IMidiReceiver *receiver) {
     }
 }
 
+IMidiReceiver* Midi::receiver() const {
+    return mReceiver;
+}
+
+void Midi::setRenderer(Renderer *renderer) {
+    Q_ASSERT(!isOpen());
+    mRenderer = renderer;
+}
+
 void Midi::customEvent(QEvent *evt) {
     if (evt->type() == TU::MidiEvent::getType()) {
         auto midiEvt = static_cast<TU::MidiEvent*>(evt);
         switch (midiEvt->message()) {
             case TU::MidiEvent::NoteOff:
                 if (mReceiver) {
-                    mReceiver->midiNoteOff();
+                    mReceiver->midiNoteOff(midiEvt->previewed());
                     mNoteDown = false;
                 }
                 break;
             case TU::MidiEvent::NoteOn:
+                if (midiEvt->previewed()) {
+                    // the render thread only picks up the note if running
+                    mRenderer->wakeForMidi();
+                }
                 if (mReceiver) {
-                    mReceiver->midiNoteOn(midiEvt->note());
+                    mReceiver->midiNoteOn(midiEvt->note(), midiEvt->previewed(), midiEvt->time());
                     mNoteDown = true;
                 }
                 break;
@@ -235,6 +272,10 @@ void Midi::midiInCallback(double deltatime, std::vector<unsigned char> *message,
 
 void Midi::handleMidiIn(double deltatime, std::vector<unsigned char> &message) {
     Q_UNUSED(deltatime)
+    // deltatime is relative to the previous message, timestamp the message
+    // with the time we received it instead, so that receivers can map it to
+    // what was being heard at that time
+    auto const now = IMidiReceiver::Clock::now();
 
     auto const msgSize = message.size();
     if (msgSize == 0) {
@@ -248,7 +289,8 @@ void Midi::handleMidiIn(double deltatime, std::vector<unsigned char> &message) {
             if (msgSize == 3) {
                 if (mLastNotePitch == (int)message[1]) {
                     mLastNotePitch = -1;
-                    QCoreApplication::postEvent(this, new TU::MidiEvent(TU::MidiEvent::NoteOff), Qt::HighEventPriority);
+                    bool const previewed = mRenderer && mRenderer->sendMidiNote(Renderer::MIDI_NOTE_OFF);
+                    QCoreApplication::postEvent(this, new TU::MidiEvent(TU::MidiEvent::NoteOff, previewed, now), Qt::HighEventPriority);
                 }
             }
             break;
@@ -259,7 +301,9 @@ void Midi::handleMidiIn(double deltatime, std::vector<unsigned char> &message) {
                 // 69 is A-4
                 // 36 is C-2
                 int trackerboyNote = std::clamp((int)message[1] - 36, 0, (int)trackerboy::NOTE_LAST);
-                QCoreApplication::postEvent(this, new TU::MidiEvent(TU::MidiEvent::NoteOn, trackerboyNote), Qt::HighEventPriority);
+                // preview now, the GUI is only notified for display and recording
+                bool const previewed = mRenderer && mRenderer->sendMidiNote(trackerboyNote);
+                QCoreApplication::postEvent(this, new TU::MidiEvent(TU::MidiEvent::NoteOn, previewed, now, trackerboyNote), Qt::HighEventPriority);
             }
             break;
         default:
@@ -3,6 +3,7 @@
 
 #include "midi/MidiEnumerator.hpp"
 #include "midi/IMidiReceiver.hpp"
+#include "audio/Renderer.hpp"
 
 #include "RtMidi.h"
 
@@ -27,6 +28,10 @@
 // Midi class. Notifies an IMidiReceiver whenever a MIDI note message
 // is received.
 //
+// When a Renderer is set, notes are also sent to it straight from the MIDI
+// callback thread so that previews don't wait on the GUI thread. The receiver
+// is still notified via the event loop, for display and recording.
+//
 class Midi : public QObject {
 
     Q_OBJECT
@@ -61,6 +66,14 @@ public:
     //
     void setReceiver(IMidiReceiver *receiver);
 
+    IMidiReceiver* receiver() const;
+
+    //
+    // Set the renderer that notes are sent to directly for previewing. Must
+    // be set before a port is opened.
+    //
+    void setRenderer(Renderer *renderer);
+
     
 signals:
     //
@@ -76,6 +89,7 @@ private:
     Q_DISABLE_COPY(Midi)
 
     IMidiReceiver *mReceiver;
+    Renderer *mRenderer;
     bool mNoteDown;
 
     // callback functions
@@ -1,5 +1,6 @@
 
 #include "midi/MidiEnumerator.hpp"
+#include "config/data/keys.hpp"
 
 
 MidiEnumerator::Device::Device() :
@@ -17,7 +18,9 @@ MidiEnumerator::Device::Device(RtMidi::Api api, std::string &&name) :
 MidiEnumerator::Context::Context(RtMidi::Api api) :
     api(api),
     deviceNames(),
-    available(false)
+    available(false),
+    populated(false),
+    cached(false)
 {
 }
 
@@ -113,23 +116,94 @@ void MidiEnumerator::populate(int backend) {
         return;
     }
 
-    auto &ctx = mContexts[backend];
-    ctx.deviceNames.clear();
+    setDevices(backend, probe(mContexts[backend].api));
+}
+
+void MidiEnumerator::prepare(int backend) {
+    if (indexIsInvalid(backend)) {
+        return;
+    }
+
+    if (!mContexts[backend].populated) {
+        populate(backend);
+    }
+}
+
+bool MidiEnumerator::isCached(int backend) const {
+    if (indexIsInvalid(backend)) {
+        return false;
+    }
+    return mContexts[backend].cached;
+}
+
+RtMidi::Api MidiEnumerator::api(int backend) const {
+    if (indexIsInvalid(backend)) {
+        return RtMidi::UNSPECIFIED;
+    }
+    return mContexts[backend].api;
+}
 
+std::optional<QStringList> MidiEnumerator::probe(RtMidi::Api api) {
     try {
-        RtMidiIn midiIn(ctx.api);
+        RtMidiIn midiIn(api);
 
+        QStringList names;
         auto const portCount = midiIn.getPortCount();
         for (unsigned port = 0; port < portCount; ++port) {
-            ctx.deviceNames.append(QString::fromStdString(midiIn.getPortName(port)));
+            names.append(QString::fromStdString(midiIn.getPortName(port)));
         }
-
-        ctx.available = true;
+        return names;
     }  catch (RtMidiError const&) {
-        ctx.available = false;
+        return std::nullopt;
     }
 }
 
+void MidiEnumerator::setDevices(int backend, std::optional<QStringList> &&devices) {
+    if (indexIsInvalid(backend)) {
+        return;
+    }
+
+    auto &ctx = mContexts[backend];
+    ctx.available = devices.has_value();
+    ctx.deviceNames = devices.value_or(QStringList());
+    ctx.populated = true;
+    ctx.cached = false;
+}
+
+void MidiEnumerator::loadCache(QSettings &settings) {
+    settings.beginGroup(Keys::DeviceCache);
+    settings.beginGroup(Keys::Midi);
+
+    for (auto &ctx : mContexts) {
+        auto const key = QString::fromStdString(RtMidi::getApiName(ctx.api));
+        if (settings.contains(key)) {
+            // the api was available when cached, probing will tell otherwise
+            ctx.deviceNames = settings.value(key).toStringList();
+            ctx.available = true;
+            ctx.populated = true;
+            ctx.cached = true;
+        }
+    }
+
+    settings.endGroup();
+    settings.endGroup();
+}
+
+void MidiEnumerator::saveCache(QSettings &settings) const {
+    settings.beginGroup(Keys::DeviceCache);
+    settings.beginGroup(Keys::Midi);
+    settings.remove(QString());
+
+    for (auto const& ctx : mContexts) {
+        if (ctx.populated && ctx.available) {
+            settings.setValue(QString::fromStdString(RtMidi::getApiName(ctx.api)), ctx.deviceNames);
+        }
+    }
+
+    settings.endGroup();
+    settings.endGroup();
+}
+
 bool MidiEnumerator::indexIsInvalid(int backend) const {
     return backend < 0 || backend >= (int)mContexts.size();
 }
@@ -2,14 +2,17 @@
 
 #include "RtMidi.h"
 
+#include <QSettings>
 #include <QStringList>
 #include <QVariant>
 
+#include <optional>
 #include <vector>
 
 //
 // Class for enumerating MIDI input devices. Devices are addressable via a backend (api) and device
-// index, similiarly to AudioEnumerator.
+// index, similiarly to AudioEnumerator. Like AudioEnumerator, device lists
+// can be cached between sessions and probed on a worker thread.
 //
 class MidiEnumerator {
 
@@ -51,6 +54,32 @@ public:
 
     void populate(int backend);
 
+    //
+    // Populates the device list for the given backend if it has not been
+    // populated yet, by probing or from the cache.
+    //
+    void prepare(int backend);
+
+    bool isCached(int backend) const;
+
+    //
+    // Gets the RtMidi api of the given backend, for probe()
+    //
+    RtMidi::Api api(int backend) const;
+
+    //
+    // Probes the input ports of the given api, or nullopt if the api is not
+    // available. Thread-safe, give the result to setDevices from the
+    // enumerator's thread.
+    //
+    static std::optional<QStringList> probe(RtMidi::Api api);
+
+    void setDevices(int backend, std::optional<QStringList> &&devices);
+
+    void loadCache(QSettings &settings);
+
+    void saveCache(QSettings &settings) const;
+
 private:
 
     bool indexIsInvalid(int backend) const;
@@ -62,6 +91,8 @@ private:
         RtMidi::Api api;
         QStringList deviceNames;
         bool available;
+        bool populated;
+        bool cached;
 
     };
 
@@ -3,15 +3,22 @@
 
 #include <QStringBuilder>
 
-BaseTableModel::BaseTableModel(Module &mod, QString defaultName, QObject *parent) :
+BaseTableModel::BaseTableModel(Module &mod, QString defaultName, UsageIndex::Kind usageKind, QObject *parent) :
     QAbstractListModel(parent),
     mModule(mod),
     mItems(),
     mDefaultName(defaultName),
-    mShouldCommit(false)
+    mUsageKind(usageKind),
+    mShouldCommit(false),
+    mUsageCounts()
 {
+    mUsageCounts.fill(-1);
     connect(&mod, &Module::reloaded, this, &BaseTableModel::reload);
     connect(&mod, &Module::aboutToSave, this, &BaseTableModel::commit);
+    connect(&mod, &Module::usageChanged, this,
+        [this]() {
+            mUsageCounts.fill(-1);
+        });
 }
 
 bool BaseTableModel::canAdd() const {
@@ -62,11 +69,26 @@ QVariant BaseTableModel::data(const QModelIndex &index, int role) const {
             // decoration role
             return iconData(modelItem.first);
         }
+    } else if (role == Qt::ToolTipRole) {
+        auto const count = cachedUsageCount(mItems[index.row()].first);
+        return count ? tr("Used in %n row(s)", nullptr, count) : tr("Unused");
     }
 
     return QVariant();
 }
 
+int BaseTableModel::usageCount(int index) {
+    return cachedUsageCount(mItems[index].first);
+}
+
+int BaseTableModel::cachedUsageCount(int id) const {
+    auto &count = mUsageCounts[id];
+    if (count == -1) {
+        count = (int)mModule.usageCount(mUsageKind, id);
+    }
+    return count;
+}
+
 int BaseTableModel::id(int index) {
     return mItems[index].first;
 }
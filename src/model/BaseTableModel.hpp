@@ -5,6 +5,7 @@
 #include <QAbstractListModel>
 #include <QIcon>
 
+#include <array>
 #include <string>
 #include <utility>
 #include <vector>
@@ -49,9 +50,15 @@ public:
 
     void updateChannelIcon(int index);
 
+    //
+    // Gets the number of rows, in all songs, that use the item at the given
+    // index. An item should not be removed while it is in use.
+    //
+    int usageCount(int index);
+
 
 protected:
-    BaseTableModel(Module &mod, QString defaultName, QObject *parent = nullptr);
+    BaseTableModel(Module &mod, QString defaultName, UsageIndex::Kind usageKind, QObject *parent = nullptr);
 
     virtual QIcon iconData(int id) const = 0;
 
@@ -85,11 +92,23 @@ private:
 
     int insertData(ModelData const& data);
 
+    //
+    // Gets the usage count of the given id from the cache, counting it if
+    // needed. Tooltips query counts on every hover, and counting may build
+    // the usage index of every song with the module locked.
+    //
+    int cachedUsageCount(int id) const;
+
     // maps a model index -> table index
     std::vector<ModelData> mItems;
 
     QString const mDefaultName;
+    UsageIndex::Kind const mUsageKind;
     bool mShouldCommit;
 
+    // usage count of each id, -1 if not yet counted. Cleared when the module
+    // signals usageChanged.
+    std::array<int, trackerboy::InstrumentTable::MAX_SIZE> mutable mUsageCounts;
+
     
 };
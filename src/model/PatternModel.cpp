@@ -35,7 +35,10 @@ PatternModel::PatternModel(Module &mod, SongModel &songModel, QObject *parent) :
     mPatternCurr(mod.song()->getPattern(0)),
     mPatternNext(),
     mHasSelection(false),
-    mSelection()
+    mSelection(),
+    mMaxColumns(),
+    mInvalidatePending(false),
+    mInvalidRegion()
 {
     setMaxColumns();
     connect(&songModel, &SongModel::patternSizeChanged, this,
@@ -478,7 +481,7 @@ void PatternModel::setPreviewEnable(bool enable) {
             mPatternPrev.reset();
             mPatternNext.reset();
         }
-        emit invalidated();
+        invalidateLater();
     }
 }
 
@@ -495,9 +498,16 @@ trackerboy::Song* PatternModel::source() const {
 }
 
 void PatternModel::setPatterns(int pattern, CursorChangeFlags &flags) {
+    reloadPatterns(pattern, flags);
+    invalidateLater();
+}
+
+bool PatternModel::reloadPatterns(int pattern, CursorChangeFlags &flags) {
 
     auto song = source();
 
+    auto const prevsize = mPatternPrev ? mPatternPrev->totalRows() : 0;
+    auto const nextsize = mPatternNext ? mPatternNext->totalRows() : 0;
     if (mShowPreviews) {
         setPreviewPatterns(pattern);
     }
@@ -511,12 +521,14 @@ void PatternModel::setPatterns(int pattern, CursorChangeFlags &flags) {
         emit patternSizeChanged(newsize);
     }
 
-    emit invalidated();
-
     if (mCursor.row >= newsize) {
         mCursor.row = newsize - 1;
         flags |= CursorRowChanged;
     }
+
+    return oldsize != newsize ||
+           prevsize != (mPatternPrev ? mPatternPrev->totalRows() : 0) ||
+           nextsize != (mPatternNext ? mPatternNext->totalRows() : 0);
 }
 
 void PatternModel::emitIfChanged(CursorChangeFlags flags) {
@@ -563,12 +575,116 @@ void PatternModel::invalidate(int pattern, bool updatePatterns) {
             emitIfChanged(flags);
         } else {
             // views just need to redraw
-            emit invalidated();
+            invalidateLater();
         }
     }
 
 }
 
+void PatternModel::invalidate(int pattern, bool updatePatterns, int rowStart, int rowEnd, int trackStart, int trackEnd) {
+
+    bool isInvalid = (mCursorPattern == pattern) ||
+                     (mPatternPrev && pattern == mCursorPattern - 1) ||
+                     (mPatternNext && pattern == mCursorPattern + 1);
+
+    if (isInvalid) {
+        bool resized = false;
+        CursorChangeFlags flags = CursorUnchanged;
+        if (updatePatterns) {
+            resized = reloadPatterns(mCursorPattern, flags);
+        }
+        if (resized) {
+            // rows have moved, so everything needs to be redrawn
+            invalidateLater();
+        } else {
+            invalidateLater(pattern, rowStart, rowEnd, trackStart, trackEnd);
+        }
+        emitIfChanged(flags);
+    }
+}
+
+void PatternModel::invalidateLater() {
+    mInvalidRegion.reset();
+    if (!mInvalidatePending) {
+        mInvalidatePending = true;
+        QMetaObject::invokeMethod(this, [this]() {
+            mInvalidatePending = false;
+            if (mInvalidRegion) {
+                auto const region = *mInvalidRegion;
+                mInvalidRegion.reset();
+                emit rowsInvalidated(region.pattern, region.rowStart, region.rowEnd, region.trackStart, region.trackEnd);
+            } else {
+                emit invalidated();
+            }
+        }, Qt::QueuedConnection);
+    }
+}
+
+void PatternModel::invalidateLater(int pattern, int rowStart, int rowEnd, int trackStart, int trackEnd) {
+    if (mInvalidatePending) {
+        // merge with the pending region, if there is one. Regions in
+        // different patterns invalidate everything
+        if (mInvalidRegion) {
+            if (mInvalidRegion->pattern == pattern) {
+                mInvalidRegion->rowStart = std::min(mInvalidRegion->rowStart, rowStart);
+                mInvalidRegion->rowEnd = std::max(mInvalidRegion->rowEnd, rowEnd);
+                mInvalidRegion->trackStart = std::min(mInvalidRegion->trackStart, trackStart);
+                mInvalidRegion->trackEnd = std::max(mInvalidRegion->trackEnd, trackEnd);
+            } else {
+                mInvalidRegion.reset();
+            }
+        }
+    } else {
+        invalidateLater();
+        mInvalidRegion = InvalidRegion{ pattern, rowStart, rowEnd, trackStart, trackEnd };
+    }
+}
+
+void PatternModel::updateUsage(int pattern, int trackStart, int trackEnd) {
+    auto &index = mModule.usageIndex();
+    if (!index.isValid()) {
+        // nothing to update, the index is rebuilt when it is next queried
+        return;
+    }
+
+    auto song = source();
+    auto const& orderRow = song->order()[pattern];
+    for (int track = trackStart; track <= trackEnd; ++track) {
+        auto const ch = static_cast<trackerboy::ChType>(track);
+        index.updateTrack(ch, orderRow[track], song->patterns().getTrack(ch, orderRow[track]));
+    }
+}
+
+void PatternModel::updateRowUsage(int pattern, int track, int row, trackerboy::TrackRow const& rowdata) {
+    mModule.usageIndex().updateRow(
+        static_cast<trackerboy::ChType>(track),
+        source()->order()[pattern][track],
+        (uint8_t)row,
+        rowdata
+    );
+}
+
+void PatternModel::addOrderUsage(trackerboy::OrderRow const& row) {
+    auto &index = mModule.usageIndex();
+    if (!index.isValid()) {
+        return;
+    }
+
+    auto &patterns = source()->patterns();
+    for (size_t track = 0; track < row.size(); ++track) {
+        auto const ch = static_cast<trackerboy::ChType>(track);
+        // may create the track
+        index.addReference(ch, row[track], patterns.getTrack(ch, row[track]));
+    }
+}
+
+void PatternModel::removeOrderUsage(trackerboy::OrderRow const& row) {
+    auto &index = mModule.usageIndex();
+    for (size_t track = 0; track < row.size(); ++track) {
+        index.removeReference(static_cast<trackerboy::ChType>(track), row[track]);
+    }
+}
+
 bool PatternModel::selectionDataIsEmpty() {
     if (mHasSelection) {
         auto iter = mSelection.iterator();
@@ -633,6 +749,24 @@ void PatternModel::setMaxColumns() {
 
 // editing ====================================================================
 
+void PatternModel::recordNote(int pattern, int row, std::optional<uint8_t> note, std::optional<uint8_t> instrument) {
+    if (pattern < 0 || pattern >= patterns()) {
+        return;
+    }
+
+    CursorChangeFlags flags = CursorUnchanged;
+    setCursorPatternImpl(pattern, flags);
+    if (row >= (int)mPatternCurr.totalRows()) {
+        // playback continues with the next pattern, or loops to the first
+        setCursorPatternImpl((pattern + 1) % patterns(), flags);
+        row = 0;
+    }
+    setCursorRowImpl(std::max(0, row), flags);
+    emitIfChanged(flags);
+
+    setNote(note, instrument);
+}
+
 void PatternModel::setNote(std::optional<uint8_t> note, std::optional<uint8_t> instrument) {
         
     auto &rowdata = cursorTrackRow();
@@ -646,37 +780,27 @@ void PatternModel::setNote(std::optional<uint8_t> note, std::optional<uint8_t> i
     }
     // edit the instrument if the instrument has a value and the it does not equal the current instrument
     auto const editInstrument = instrument && oldInstrument != instrument;
-    int editCount = editNote + editInstrument;
-    if (editCount) {
-        QUndoCommand *parent = nullptr;
-        QUndoCommand *cmd = nullptr;
-
-        if (editCount == 2) {
-            parent = new QUndoCommand;
-        }
+    if (editNote || editInstrument) {
+        // note and instrument are edited by a single command, so that
+        // consecutive note entries can be merged
+        auto cmd = new TrackEditCmd(*this);
 
         if (editNote) {
-            cmd = new NoteEditCmd(
-                *this,
+            cmd->addEdit(
+                TrackEditCmd::Column::note,
                 trackerboy::TrackRow::convertColumn(note),
-                trackerboy::TrackRow::convertColumn(oldNote),
-                parent
+                trackerboy::TrackRow::convertColumn(oldNote)
             );
         }
 
         if (editInstrument) {
-            cmd = new InstrumentEditCmd(
-                *this,
+            cmd->addEdit(
+                TrackEditCmd::Column::instrument,
                 trackerboy::TrackRow::convertColumn(instrument),
-                trackerboy::TrackRow::convertColumn(oldInstrument),
-                parent
+                trackerboy::TrackRow::convertColumn(oldInstrument)
             );
         }
 
-        if (parent) {
-            cmd = parent;
-        }
-
         if (note) {
             cmd->setText(tr("Note entry")); // todo: put the pattern, row, and track in this text
         } else {
@@ -729,28 +853,16 @@ void PatternModel::setEffectType(trackerboy::EffectType type) {
             static_cast<uint8_t>(effect.type)
         );
 
-        auto stack = mModule.undoStack();
         if (type == trackerboy::EffectType::noEffect) {
-
-            static auto CLEAR_EFFECT_STR = QT_TR_NOOP("clear effect");
-
             // we also need to clear the parameter
             if (effect.param != 0) {
-                stack->beginMacro(tr(CLEAR_EFFECT_STR));
-                stack->push(cmd);
-                stack->push(new EffectParamEditCmd(
-                    *this, (uint8_t)effectNo, 0, effect.param
-                ));
-                stack->endMacro();
-            } else {
-                cmd->setText(tr(CLEAR_EFFECT_STR));
-                stack->push(cmd);
+                cmd->addEdit(TrackEditCmd::Column::effectParam, 0, effect.param, (uint8_t)effectNo);
             }
-            
+            cmd->setText(tr("clear effect"));
         } else {
             cmd->setText(tr("set effect type"));
-            stack->push(cmd);
         }
+        mModule.undoStack()->push(cmd);
     }
 
 }
@@ -791,46 +903,24 @@ void PatternModel::deleteSelection() {
     } else {
         switch (mCursor.column) {
             case PatternCursor::ColumnNote: {
-                // four possibilities
-                // 1. just the note is set          -> erase the note
-                // 2. just the instrument is set    -> erase the instrument
-                // 3. both are set (use a macro)    -> erase both (macro)
-                // 4. neither are set               -> do nothing
+                // erase the note and/or instrument, if they are set
 
                 auto &rowdata = cursorTrackRow();
                 auto oldNote = rowdata.queryNote();
                 auto oldInstrument = rowdata.queryInstrument();
 
-                QUndoCommand *noteClear = nullptr;
-                QUndoCommand *instClear = nullptr;
-
-                if (oldNote.has_value()) {
-                    noteClear = new NoteEditCmd(*this, trackerboy::TrackRow::convertColumn({}), trackerboy::TrackRow::convertColumn(oldNote));
-                }
-
-                if (oldInstrument.has_value()) {
-                    instClear = new InstrumentEditCmd(*this, trackerboy::TrackRow::convertColumn({}), trackerboy::TrackRow::convertColumn(oldInstrument));
+                if (oldNote || oldInstrument) {
+                    auto cmd = new TrackEditCmd(*this);
+                    if (oldNote) {
+                        cmd->addEdit(TrackEditCmd::Column::note, trackerboy::TrackRow::convertColumn({}), trackerboy::TrackRow::convertColumn(oldNote));
+                    }
+                    if (oldInstrument) {
+                        cmd->addEdit(TrackEditCmd::Column::instrument, trackerboy::TrackRow::convertColumn({}), trackerboy::TrackRow::convertColumn(oldInstrument));
+                    }
+                    cmd->setText(tr("Clear note"));
+                    mModule.undoStack()->push(cmd);
                 }
 
-                auto getCommandText = []() { return tr("Clear note"); };
-
-                auto undoStack = mModule.undoStack();
-                if (noteClear && instClear) {
-                    // 3
-                    undoStack->beginMacro(getCommandText());
-                    undoStack->push(noteClear);
-                    undoStack->push(instClear);
-                    undoStack->endMacro();
-                } else if (noteClear) {
-                    // 1
-                    noteClear->setText(getCommandText());
-                    undoStack->push(noteClear);
-                } else if (instClear) {
-                    // 2
-                    instClear->setText(getCommandText());
-                    undoStack->push(instClear);
-                } // 4
-
                 break;
             }
             case PatternCursor::ColumnInstrumentHigh:
@@ -934,6 +1024,26 @@ void PatternModel::backspace() {
     }
 }
 
+int PatternModel::bulkEdit(BulkOperation const& operation) {
+    auto cmd = std::make_unique<BulkEditCmd>(*this, operation);
+    auto const count = cmd->changeCount();
+    if (count) {
+        switch (operation.type) {
+            case BulkOperation::Type::transpose:
+                cmd->setText(tr("transpose song"));
+                break;
+            case BulkOperation::Type::replaceInstrument:
+                cmd->setText(tr("replace instrument in song"));
+                break;
+            case BulkOperation::Type::scaleVolume:
+                cmd->setText(tr("scale volume in song"));
+                break;
+        }
+        mModule.undoStack()->push(cmd.release());
+    }
+    return count;
+}
+
 void PatternModel::setOrderRow(trackerboy::OrderRow row) {
     if (order()[mCursorPattern] != row) {
         auto cmd = new OrderEditCmd(*this, row, mCursorPattern);
@@ -1022,6 +1132,8 @@ void PatternModel::insertOrderImpl(const trackerboy::OrderRow &row, int before)
     {
         auto editor = mModule.edit();
         _order.insert(before, row);
+        // indexing may create the new tracks
+        addOrderUsage(row);
     }
 
     emit patternCountChanged(_order.size());
@@ -1040,6 +1152,7 @@ void PatternModel::removeOrderImpl(int at) {
         if (at == _order.size() - 1) {
             emit aboutToRemoveLastPattern();
         }
+        removeOrderUsage(_order[at]);
         _order.remove(at);
     }
 
@@ -2,6 +2,7 @@
 #pragma once
 
 #include "clipboard/PatternClip.hpp"
+#include "core/BulkOperation.hpp"
 #include "model/SongModel.hpp"
 #include "core/Module.hpp"
 #include "core/PatternCursor.hpp"
@@ -157,6 +158,14 @@ public:
     // with the note
     //
     void setNote(std::optional<uint8_t> note, std::optional<uint8_t> instrument);
+
+    //
+    // Moves the cursor to the given pattern and row and sets the note there,
+    // for recording notes while music is playing. A row past the end of the
+    // pattern is recorded at the start of the next pattern.
+    //
+    void recordNote(int pattern, int row, std::optional<uint8_t> note, std::optional<uint8_t> instrument);
+
     void setInstrument(std::optional<uint8_t> nibble);
     void setEffectType(trackerboy::EffectType type);
     void setEffectParam(uint8_t nibble);
@@ -180,6 +189,13 @@ public:
 
     void backspace();
 
+    //
+    // Applies the given operation to the song as a single undoable command.
+    // Returns the number of track rows changed, nothing is pushed to the undo
+    // stack if no rows were changed.
+    //
+    int bulkEdit(BulkOperation const& operation);
+
     // order
 
     //
@@ -260,6 +276,13 @@ signals:
     //
     void invalidated();
 
+    //
+    // emitted instead of invalidated when only a region of a pattern has
+    // changed. The pattern is an index in the order and may be the previous
+    // or next pattern. Rows and tracks are inclusive.
+    //
+    void rowsInvalidated(int pattern, int rowStart, int rowEnd, int trackStart, int trackEnd);
+
     void effectsVisibleChanged();
 
     void totalColumnsChanged(int columns);
@@ -276,6 +299,7 @@ private:
     friend class ReverseCmd;
     friend class ReplaceInstrumentCmd;
     friend class BackspaceCmd;
+    friend class BulkEditCmd;
     friend class OrderEditCmd;
     friend class OrderInsertCmd;
     friend class OrderRemoveCmd;
@@ -293,6 +317,13 @@ private:
     void setCursorPatternImpl(int pattern, CursorChangeFlags &flags);
 
     void setPatterns(int pattern, CursorChangeFlags &flags);
+
+    //
+    // Resets the pattern accessors without invalidating. Returns true if the
+    // size of any accessible pattern changed, in which case every visible
+    // row has moved.
+    //
+    bool reloadPatterns(int pattern, CursorChangeFlags &flags);
     void setPreviewPatterns(int pattern);
 
     void emitIfChanged(CursorChangeFlags flags);
@@ -311,6 +342,45 @@ private:
 
     void invalidate(int pattern, bool updatePatterns);
 
+    //
+    // Same as above, but only the given region of the pattern has changed.
+    // Rows and tracks are inclusive.
+    //
+    void invalidate(int pattern, bool updatePatterns, int rowStart, int rowEnd, int trackStart, int trackEnd);
+
+    //
+    // Emits invalidated once control returns to the event loop. Invalidating
+    // multiple times before then results in a single emission, so a batch of
+    // edits only redraws views once.
+    //
+    void invalidateLater();
+
+    //
+    // Same as above, but emits rowsInvalidated for the given region instead.
+    // Regions invalidated before the emission are merged, and a full
+    // invalidation takes precedence.
+    //
+    void invalidateLater(int pattern, int rowStart, int rowEnd, int trackStart, int trackEnd);
+
+    //
+    // Updates the module's usage index for the tracks in [trackStart, trackEnd]
+    // of the given pattern. Commands call this after editing pattern data.
+    //
+    void updateUsage(int pattern, int trackStart = 0, int trackEnd = 3);
+
+    //
+    // Same as updateUsage, but for a single row.
+    //
+    void updateRowUsage(int pattern, int track, int row, trackerboy::TrackRow const& rowdata);
+
+    //
+    // Adds or removes the usage index's references to the tracks of an order
+    // row. Order commands call these, with the module locked, when a row
+    // enters or leaves the order.
+    //
+    void addOrderUsage(trackerboy::OrderRow const& row);
+    void removeOrderUsage(trackerboy::OrderRow const& row);
+
     bool selectionDataIsEmpty();
 
     // called by insert, remove and duplicate commands
@@ -341,6 +411,18 @@ private:
 
     std::array<int, 4> mMaxColumns;
 
+    bool mInvalidatePending;
+    // region to emit with rowsInvalidated, if not set the entire pattern is
+    // invalidated
+    struct InvalidRegion {
+        int pattern;
+        int rowStart;
+        int rowEnd;
+        int trackStart;
+        int trackEnd;
+    };
+    std::optional<InvalidRegion> mInvalidRegion;
+
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(PatternModel::CursorChangeFlags)
@@ -90,6 +90,8 @@ void SongModel::setPatternSize(int rows) {
             auto ctx = mModule.permanentEdit();
             pm.setLength((uint16_t)rows);
         }
+        // resizing the tracks is not tracked by the usage index
+        mModule.usageIndex().invalidate();
         emit patternSizeChanged(rows);
     }
 }
@@ -8,13 +8,13 @@
 
 template <>
 TableModel<trackerboy::Instrument>::TableModel(Module &mod, QObject *parent) :
-    BaseTableModel(mod, tr("New instrument"), parent)
+    BaseTableModel(mod, tr("New instrument"), UsageIndex::Kind::instrument, parent)
 {
 }
 
 template <>
 TableModel<trackerboy::Waveform>::TableModel(Module &mod, QObject *parent) :
-    BaseTableModel(mod, tr("New waveform"), parent)
+    BaseTableModel(mod, tr("New waveform"), UsageIndex::Kind::waveform, parent)
 {
 }
 
@@ -3,6 +3,7 @@
 
 #include "core/Module.hpp"
 #include "model/PatternModel.hpp"
+#include "utils/Trace.hpp"
 
 #include "trackerboy/data/Order.hpp"
 
@@ -14,10 +15,18 @@ OrderDuplicateCmd::OrderDuplicateCmd(PatternModel &model, int row) :
 }
 
 void OrderDuplicateCmd::redo() {
+    TRACE_ZONE("OrderDuplicateCmd::redo");
+    if (isObsolete()) {
+        return;
+    }
     mModel.insertOrderImpl(mModel.order()[mRow], mRow + 1);
 }
 
 void OrderDuplicateCmd::undo() {
+    TRACE_ZONE("OrderDuplicateCmd::undo");
+    if (isObsolete()) {
+        return;
+    }
     mModel.removeOrderImpl(mRow + 1);
 }
 
@@ -30,17 +39,29 @@ OrderEditCmd::OrderEditCmd(PatternModel &model, trackerboy::OrderRow newRow, int
 }
 
 void OrderEditCmd::redo() {
+    TRACE_ZONE("OrderEditCmd::redo");
+    if (isObsolete()) {
+        return;
+    }
     setData(mNewRow);
 }
 
 void OrderEditCmd::undo() {
+    TRACE_ZONE("OrderEditCmd::undo");
+    if (isObsolete()) {
+        return;
+    }
     setData(mOldRow);
 }
 
 void OrderEditCmd::setData(trackerboy::OrderRow row) {
     {
         auto editor = mModel.mModule.edit();
-        mModel.order()[mPattern] = row;
+        auto &orderRow = mModel.order()[mPattern];
+        mModel.removeOrderUsage(orderRow);
+        orderRow = row;
+        // indexing may create the new tracks
+        mModel.addOrderUsage(row);
     }
     mModel.invalidate(mPattern, true);
 }
@@ -52,10 +73,18 @@ OrderInsertCmd::OrderInsertCmd(PatternModel &model, int row) :
 }
 
 void OrderInsertCmd::redo() {
+    TRACE_ZONE("OrderInsertCmd::redo");
+    if (isObsolete()) {
+        return;
+    }
     mModel.insertOrderImpl(mModel.order().nextUnused(), mRow + 1);
 }
 
 void OrderInsertCmd::undo() {
+    TRACE_ZONE("OrderInsertCmd::undo");
+    if (isObsolete()) {
+        return;
+    }
     // to undo an insert, we remove the inserted row
     mModel.removeOrderImpl(mRow + 1);
 }
@@ -68,10 +97,18 @@ OrderRemoveCmd::OrderRemoveCmd(PatternModel &model, int row) :
 }
 
 void OrderRemoveCmd::redo() {
+    TRACE_ZONE("OrderRemoveCmd::redo");
+    if (isObsolete()) {
+        return;
+    }
     mModel.removeOrderImpl(mRow);
 }
 
 void OrderRemoveCmd::undo() {
+    TRACE_ZONE("OrderRemoveCmd::undo");
+    if (isObsolete()) {
+        return;
+    }
     // to undo, re-insert the previously removed row
     mModel.insertOrderImpl(mRemovedRow, mRow);
 }
@@ -84,11 +121,19 @@ OrderSwapCmd::OrderSwapCmd(PatternModel &model, int from, int to) :
 }
 
 void OrderSwapCmd::redo() {
+    TRACE_ZONE("OrderSwapCmd::redo");
+    if (isObsolete()) {
+        return;
+    }
     swap();
     mModel.setCursorPattern(mTo);
 }
 
 void OrderSwapCmd::undo() {
+    TRACE_ZONE("OrderSwapCmd::undo");
+    if (isObsolete()) {
+        return;
+    }
     swap();
     mModel.setCursorPattern(mFrom);
 }
@@ -1,6 +1,19 @@
 
 #include "model/commands/pattern.hpp"
 #include "model/PatternModel.hpp"
+#include "utils/Trace.hpp"
+
+#include <algorithm>
+
+#define TU patternTU
+namespace TU {
+
+//
+// QUndoCommand::id for commands that can be merged
+//
+constexpr int TRACK_EDIT_ID = 1;
+
+}
 
 SelectionCmd::SelectionCmd(PatternModel &model) :
     mModel(model),
@@ -8,16 +21,40 @@ SelectionCmd::SelectionCmd(PatternModel &model) :
     mClip()
 {
     mClip.save(model.mPatternCurr, model.mSelection);
+    mClip.compact();
+}
+
+size_t SelectionCmd::storageSize() const {
+    return mClip.memoryUsage();
+}
+
+void SelectionCmd::releaseStorage() {
+    mClip.clear();
 }
 
 void SelectionCmd::restore(bool update) {
+    if (!mClip.hasData()) {
+        return;
+    }
+
     auto pattern = mModel.source()->getPattern(mPattern);
     {
         auto ctx = mModel.mModule.edit();
         mClip.restore(pattern);
     }
 
-    mModel.invalidate(mPattern, update);
+    updateUsage();
+    invalidate(update);
+}
+
+void SelectionCmd::updateUsage() {
+    auto iter = mClip.selection().iterator();
+    mModel.updateUsage(mPattern, iter.trackStart(), iter.trackEnd());
+}
+
+void SelectionCmd::invalidate(bool update) {
+    auto iter = mClip.selection().iterator();
+    mModel.invalidate(mPattern, update, iter.rowStart(), iter.rowEnd(), iter.trackStart(), iter.trackEnd());
 }
 
 EraseCmd::EraseCmd(PatternModel &model) :
@@ -26,6 +63,11 @@ EraseCmd::EraseCmd(PatternModel &model) :
 }
 
 void EraseCmd::redo() {
+    TRACE_ZONE("EraseCmd::redo");
+    if (isObsolete() || !mClip.hasData()) {
+        return;
+    }
+
     {
         auto ctx = mModel.mModule.edit();
         // clear all set data in the selection
@@ -60,10 +102,15 @@ void EraseCmd::redo() {
 
     }
 
-    mModel.invalidate(mPattern, true);
+    updateUsage();
+    invalidate(true);
 }
 
 void EraseCmd::undo() {
+    TRACE_ZONE("EraseCmd::undo");
+    if (isObsolete()) {
+        return;
+    }
     restore(true);
 }
 
@@ -85,26 +132,60 @@ PasteCmd::PasteCmd(
     region.moveTo(pos);
     region.clamp(model.mPatternCurr.size() - 1);
     mPast.save(model.mPatternCurr, region);
+    mSrc.compact();
+    mPast.compact();
 }
 
 void PasteCmd::redo() {
+    TRACE_ZONE("PasteCmd::redo");
+    if (isObsolete() || !mSrc.hasData()) {
+        return;
+    }
+
     {
         auto ctx = mModel.mModule.edit();
         auto pattern = mModel.source()->getPattern(mPattern);
         mSrc.paste(pattern, mPos, mMix);
     }
 
-    mModel.invalidate(mPattern, true);
+    updateUsage();
+    invalidate();
 }
 
 void PasteCmd::undo() {
+    TRACE_ZONE("PasteCmd::undo");
+    if (isObsolete() || !mPast.hasData()) {
+        return;
+    }
+
     {
         auto ctx = mModel.mModule.edit();
         auto pattern = mModel.source()->getPattern(mPattern);
         mPast.restore(pattern);
     }
 
-    mModel.invalidate(mPattern, true);
+    updateUsage();
+    invalidate();
+}
+
+size_t PasteCmd::storageSize() const {
+    return mSrc.memoryUsage() + mPast.memoryUsage();
+}
+
+void PasteCmd::releaseStorage() {
+    mSrc.clear();
+    mPast.clear();
+}
+
+void PasteCmd::updateUsage() {
+    // mPast contains the region being pasted to
+    auto iter = mPast.selection().iterator();
+    mModel.updateUsage(mPattern, iter.trackStart(), iter.trackEnd());
+}
+
+void PasteCmd::invalidate() {
+    auto iter = mPast.selection().iterator();
+    mModel.invalidate(mPattern, true, iter.rowStart(), iter.rowEnd(), iter.trackStart(), iter.trackEnd());
 }
 
 ReverseCmd::ReverseCmd(PatternModel &model) :
@@ -115,10 +196,18 @@ ReverseCmd::ReverseCmd(PatternModel &model) :
 }
 
 void ReverseCmd::redo() {
+    TRACE_ZONE("ReverseCmd::redo");
+    if (isObsolete()) {
+        return;
+    }
     reverse();
 }
 
 void ReverseCmd::undo() {
+    TRACE_ZONE("ReverseCmd::undo");
+    if (isObsolete()) {
+        return;
+    }
     // same as redo() since reversing is an involutory function
     reverse();
 }
@@ -164,7 +253,9 @@ void ReverseCmd::reverse() {
             }
         }
     }
-    mModel.invalidate(mPattern, true);
+    auto iter = mSelection.iterator();
+    mModel.updateUsage(mPattern, iter.trackStart(), iter.trackEnd());
+    mModel.invalidate(mPattern, true, iter.rowStart(), iter.rowEnd(), iter.trackStart(), iter.trackEnd());
 }
 
 ReplaceInstrumentCmd::ReplaceInstrumentCmd(PatternModel &model, int instrument) :
@@ -175,6 +266,11 @@ ReplaceInstrumentCmd::ReplaceInstrumentCmd(PatternModel &model, int instrument)
 }
 
 void ReplaceInstrumentCmd::redo() {
+    TRACE_ZONE("ReplaceInstrumentCmd::redo");
+    if (isObsolete() || !mClip.hasData()) {
+        return;
+    }
+
     {
         auto ctx = mModel.mModule.edit();
         auto iter = mClip.selection().iterator();
@@ -193,104 +289,205 @@ void ReplaceInstrumentCmd::redo() {
         }
     }
 
-    mModel.invalidate(mPattern, false);
+    updateUsage();
+    invalidate(false);
 }
 
 void ReplaceInstrumentCmd::undo() {
+    TRACE_ZONE("ReplaceInstrumentCmd::undo");
+    if (isObsolete()) {
+        return;
+    }
     restore(false);
 }
 
 
-TrackEditCmd::TrackEditCmd(
-    PatternModel &model,
-    uint8_t dataNew,
-    uint8_t dataOld,
-    QUndoCommand *parent
-) :
+TrackEditCmd::TrackEditCmd(PatternModel &model, QUndoCommand *parent) :
     QUndoCommand(parent),
     mModel(model),
-    mTrack((uint8_t)(model.mCursor.track)),
     mPattern((uint8_t)model.mCursorPattern),
-    mRow((uint8_t)model.mCursor.row),
-    mNewData(dataNew),
-    mOldData(dataOld)
+    mEdits(),
+    mTimer()
 {
+    mTimer.start();
 }
 
-void TrackEditCmd::redo() {
-    setData(mNewData);
+void TrackEditCmd::addEdit(Column column, uint8_t dataNew, uint8_t dataOld, uint8_t effectNo) {
+    mEdits.append({
+        (uint8_t)mModel.mCursor.track,
+        (uint8_t)mModel.mCursor.row,
+        column,
+        effectNo,
+        dataNew,
+        dataOld
+    });
 }
 
-void TrackEditCmd::undo() {
-    setData(mOldData);
+int TrackEditCmd::id() const {
+    return TU::TRACK_EDIT_ID;
 }
 
-trackerboy::TrackRow& TrackEditCmd::getRow() {
-    return mModel.source()->getRow(
-        static_cast<trackerboy::ChType>(mTrack),
-        mPattern,
-        (uint16_t)mRow
-    );
+bool TrackEditCmd::mergeWith(QUndoCommand const* other) {
+    auto const cmd = static_cast<TrackEditCmd const*>(other);
+    // edits are never merged into a trimmed command, as they could not be
+    // undone
+    if (isObsolete() ||
+        &cmd->mModel != &mModel ||
+        cmd->mPattern != mPattern ||
+        cmd->text() != text() ||
+        mTimer.elapsed() > MERGE_INTERVAL) {
+        return false;
+    }
+
+    // other has already been redone by the stack, so we just take its edits
+    mEdits.append(cmd->mEdits.constData(), cmd->mEdits.size());
+    mTimer.restart();
+    return true;
 }
 
-void TrackEditCmd::setData(uint8_t data) {
-    auto &rowdata = mModel.source()->getRow(
-        static_cast<trackerboy::ChType>(mTrack),
-        mPattern,
-        (uint16_t)mRow
-    );
+void TrackEditCmd::redo() {
+    TRACE_ZONE("TrackEditCmd::redo");
+    if (isObsolete()) {
+        return;
+    }
+    bool update = false;
+    {
+        auto ctx = mModel.mModule.edit();
+        auto song = mModel.source();
+        for (auto const& edit : mEdits) {
+            auto &rowdata = song->getRow(static_cast<trackerboy::ChType>(edit.track), mPattern, edit.row);
+            update |= apply(rowdata, edit, edit.newData);
+            mModel.updateRowUsage(mPattern, edit.track, edit.row, rowdata);
+        }
+    }
+
+    invalidate(update);
+}
 
-    bool update;
+void TrackEditCmd::undo() {
+    TRACE_ZONE("TrackEditCmd::undo");
+    if (isObsolete()) {
+        return;
+    }
+    bool update = false;
     {
         auto ctx = mModel.mModule.edit();
-        update = edit(rowdata, data);
+        auto song = mModel.source();
+        // undo in reverse order, in case multiple edits were made to the same cell
+        for (auto iter = mEdits.crbegin(); iter != mEdits.crend(); ++iter) {
+            auto &rowdata = song->getRow(static_cast<trackerboy::ChType>(iter->track), mPattern, iter->row);
+            update |= apply(rowdata, *iter, iter->oldData);
+            mModel.updateRowUsage(mPattern, iter->track, iter->row, rowdata);
+        }
     }
 
-    mModel.invalidate(mPattern, update);
+    invalidate(update);
+}
+
+void TrackEditCmd::invalidate(bool update) {
+    if (mEdits.isEmpty()) {
+        return;
+    }
 
+    // bounds of all edited cells, merged commands may span multiple rows
+    int rowStart = 255, rowEnd = 0, trackStart = 3, trackEnd = 0;
+    for (auto const& edit : mEdits) {
+        rowStart = std::min(rowStart, (int)edit.row);
+        rowEnd = std::max(rowEnd, (int)edit.row);
+        trackStart = std::min(trackStart, (int)edit.track);
+        trackEnd = std::max(trackEnd, (int)edit.track);
+    }
+    mModel.invalidate(mPattern, update, rowStart, rowEnd, trackStart, trackEnd);
 }
 
-// ===
+size_t TrackEditCmd::storageSize() const {
+    // only merged commands have their edits on the heap
+    if (mEdits.capacity() > INLINE_EDITS) {
+        return (size_t)mEdits.capacity() * sizeof(Edit);
+    } else {
+        return 0;
+    }
+}
 
-bool NoteEditCmd::edit(trackerboy::TrackRow &rowdata, uint8_t data) {
-    rowdata.note = data;
+void TrackEditCmd::releaseStorage() {
+    mEdits.clear();
+    mEdits.squeeze();
+}
+
+bool TrackEditCmd::apply(trackerboy::TrackRow &rowdata, Edit const& edit, uint8_t data) {
+    switch (edit.column) {
+        case Column::note:
+            rowdata.note = data;
+            break;
+        case Column::instrument:
+            rowdata.instrumentId = data;
+            break;
+        case Column::effectType: {
+            auto &effect = rowdata.effects[edit.effectNo];
+            auto oldtype = effect.type;
+            auto type = static_cast<trackerboy::EffectType>(data);
+            effect.type = type;
+            return trackerboy::effectTypeShortensPattern(type) || trackerboy::effectTypeShortensPattern(oldtype);
+        }
+        case Column::effectParam:
+            rowdata.effects[edit.effectNo].param = data;
+            break;
+    }
     return false;
 }
 
 // ===
 
-bool InstrumentEditCmd::edit(trackerboy::TrackRow &rowdata, uint8_t data) {
-    rowdata.instrumentId = data;
-    return false;
+NoteEditCmd::NoteEditCmd(
+    PatternModel &model,
+    uint8_t dataNew,
+    uint8_t dataOld,
+    QUndoCommand *parent
+) :
+    TrackEditCmd(model, parent)
+{
+    addEdit(Column::note, dataNew, dataOld);
 }
 
 // ===
 
-EffectEditCmd::EffectEditCmd(
+InstrumentEditCmd::InstrumentEditCmd(
+    PatternModel &model,
+    uint8_t dataNew,
+    uint8_t dataOld,
+    QUndoCommand *parent
+) :
+    TrackEditCmd(model, parent)
+{
+    addEdit(Column::instrument, dataNew, dataOld);
+}
+
+// ===
+
+EffectTypeEditCmd::EffectTypeEditCmd(
     PatternModel &model,
     uint8_t effectNo,
     uint8_t newData,
     uint8_t oldData,
     QUndoCommand *parent
 ) :
-    TrackEditCmd(model, newData, oldData, parent),
-    mEffectNo(effectNo)
+    TrackEditCmd(model, parent)
 {
-}
-
-bool EffectTypeEditCmd::edit(trackerboy::TrackRow &rowdata, uint8_t data)  {
-    auto &effect = rowdata.effects[mEffectNo];
-    auto oldtype = effect.type;
-    auto type = static_cast<trackerboy::EffectType>(data);
-    effect.type = type;
-    return trackerboy::effectTypeShortensPattern(type) || trackerboy::effectTypeShortensPattern(oldtype);
+    addEdit(Column::effectType, newData, oldData, effectNo);
 }
 
 // ===
 
-bool EffectParamEditCmd::edit(trackerboy::TrackRow &rowdata, uint8_t data) {
-    rowdata.effects[mEffectNo].param = data;
-    return false;
+EffectParamEditCmd::EffectParamEditCmd(
+    PatternModel &model,
+    uint8_t effectNo,
+    uint8_t newData,
+    uint8_t oldData,
+    QUndoCommand *parent
+) :
+    TrackEditCmd(model, parent)
+{
+    addEdit(Column::effectParam, newData, oldData, effectNo);
 }
 
 TransposeCmd::TransposeCmd(PatternModel &model, int8_t transposeAmount) :
@@ -300,6 +497,11 @@ TransposeCmd::TransposeCmd(PatternModel &model, int8_t transposeAmount) :
 }
 
 void TransposeCmd::redo()  {
+    TRACE_ZONE("TransposeCmd::redo");
+    if (isObsolete() || !mClip.hasData()) {
+        return;
+    }
+
     {
         auto ctx = mModel.mModule.edit();
         auto iter = mClip.selection().iterator();
@@ -318,10 +520,14 @@ void TransposeCmd::redo()  {
         }
     }
 
-    mModel.invalidate(mPattern, false);
+    invalidate(false);
 }
 
 void TransposeCmd::undo() {
+    TRACE_ZONE("TransposeCmd::undo");
+    if (isObsolete()) {
+        return;
+    }
     restore(false);
 }
 
@@ -354,6 +560,10 @@ BackspaceCmd::BackspaceCmd(PatternModel &model, QUndoCommand *parent) :
 
 
 void BackspaceCmd::redo() {
+    TRACE_ZONE("BackspaceCmd::redo");
+    if (isObsolete()) {
+        return;
+    }
     {
         auto editor = mModel.mModule.edit();
         auto &dest = mModel.source()->patterns().getTrack(static_cast<trackerboy::ChType>(mTrack), mPattern);
@@ -364,10 +574,16 @@ void BackspaceCmd::redo() {
         dest[rows] = {};
 
     }
-    mModel.invalidate(mPattern, true);
+    mModel.updateUsage(mPattern, mTrack, mTrack);
+    // all rows after the deleted one have moved up
+    mModel.invalidate(mPattern, true, mRow - 1, mModel.source()->patterns().length() - 1, mTrack, mTrack);
 }
 
 void BackspaceCmd::undo() {
+    TRACE_ZONE("BackspaceCmd::undo");
+    if (isObsolete()) {
+        return;
+    }
 
     {
         auto editor = mModel.mModule.edit();
@@ -378,6 +594,69 @@ void BackspaceCmd::undo() {
         }
         dest[restoredRow] = mDeleted;
     }
-    mModel.invalidate(mPattern, true);
+    mModel.updateUsage(mPattern, mTrack, mTrack);
+    mModel.invalidate(mPattern, true, mRow - 1, mModel.source()->patterns().length() - 1, mTrack, mTrack);
+}
+
+BulkEditCmd::BulkEditCmd(PatternModel &model, BulkOperation const& operation) :
+    QUndoCommand(),
+    mModel(model),
+    mChanges()
+{
+    // Only the GUI thread edits the song, so it can be read without locking.
+    // The module is then only locked while the changes are applied, instead
+    // of blocking the renderer while the workers run.
+    mChanges = operation.changes(*mModel.source());
+}
+
+int BulkEditCmd::changeCount() const {
+    return (int)mChanges.size();
+}
+
+void BulkEditCmd::redo() {
+    TRACE_ZONE("BulkEditCmd::redo");
+    if (isObsolete()) {
+        return;
+    }
+    apply(false);
+}
+
+void BulkEditCmd::undo() {
+    TRACE_ZONE("BulkEditCmd::undo");
+    if (isObsolete()) {
+        return;
+    }
+    apply(true);
+}
+
+size_t BulkEditCmd::storageSize() const {
+    return mChanges.capacity() * sizeof(BulkOperation::Change);
+}
+
+void BulkEditCmd::releaseStorage() {
+    mChanges.clear();
+    mChanges.shrink_to_fit();
+}
+
+void BulkEditCmd::apply(bool undoing) {
+    if (mChanges.empty()) {
+        return;
+    }
+
+    {
+        auto ctx = mModel.mModule.edit();
+        auto &patterns = mModel.source()->patterns();
+        auto &usage = mModel.mModule.usageIndex();
+        for (auto const& change : mChanges) {
+            auto &track = patterns.getTrack(change.channel, change.trackId);
+            auto const& rowdata = undoing ? change.before : change.after;
+            track[change.row] = rowdata;
+            usage.updateRow(change.channel, change.trackId, change.row, rowdata);
+        }
+    }
+
+    // effects in the changed rows could shorten the current pattern
+    mModel.invalidate(mModel.mCursorPattern, true);
 }
 
+#undef TU
@@ -4,18 +4,29 @@
 class PatternModel;
 
 #include "clipboard/PatternClip.hpp"
+#include "core/BulkOperation.hpp"
+#include "core/UndoStorage.hpp"
 
 #include "trackerboy/data/TrackRow.hpp"
 
+#include <QElapsedTimer>
 #include <QUndoCommand>
+#include <QVarLengthArray>
 
 #include <cstdint>
+#include <vector>
 
 
 //
 // Base class for commands that operate on a PatternSelection
 //
-class SelectionCmd : public QUndoCommand {
+class SelectionCmd : public QUndoCommand, public IUndoStorage {
+
+public:
+
+    virtual size_t storageSize() const override;
+
+    virtual void releaseStorage() override;
 
 protected:
     PatternModel &mModel;
@@ -23,7 +34,8 @@ protected:
     PatternClip mClip;
 
     //
-    // initializes the command by saving a clip of the current selection
+    // initializes the command by saving a (compacted) clip of the current
+    // selection
     //
     explicit SelectionCmd(PatternModel &model);
 
@@ -32,6 +44,16 @@ protected:
     //
     void restore(bool update);
 
+    //
+    // Updates the usage index for the tracks in the saved selection
+    //
+    void updateUsage();
+
+    //
+    // Invalidates the rows and tracks of the saved selection
+    //
+    void invalidate(bool update);
+
 };
 
 //
@@ -52,7 +74,7 @@ public:
 //
 // Command for pasting pattern data
 //
-class PasteCmd : public QUndoCommand {
+class PasteCmd : public QUndoCommand, public IUndoStorage {
 
     PatternModel &mModel;
     PatternClip mSrc;
@@ -73,6 +95,16 @@ public:
 
     virtual void undo() override;
 
+    virtual size_t storageSize() const override;
+
+    virtual void releaseStorage() override;
+
+private:
+
+    void updateUsage();
+
+    void invalidate();
+
 };
 
 //
@@ -121,37 +153,82 @@ public:
 };
 
 //
-// Base command class for editing a column in a track row
+// Command for editing columns in the track rows of a pattern. Edits are added
+// via addEdit, or by using one of the subclasses below.
 //
-class TrackEditCmd : public QUndoCommand {
-
-protected:
-    PatternModel &mModel;
-    uint8_t const mTrack;
-    uint8_t const mPattern;
-    uint8_t const mRow;
-    uint8_t const mNewData;
-    uint8_t const mOldData;
+// Consecutive commands with the same text that edit the same pattern within
+// MERGE_INTERVAL milliseconds of each other are merged into a single command.
+// This keeps rapid note entry (ie recording from MIDI) from flooding the undo
+// stack with thousands of single cell edits, and lets the merged edits be
+// undone/redone with a single invalidation.
+//
+class TrackEditCmd : public QUndoCommand, public IUndoStorage {
 
 public:
-    explicit TrackEditCmd(
-        PatternModel &model,
-        uint8_t dataNew,
-        uint8_t dataOld,
-        QUndoCommand *parent = nullptr
-    );
+
+    enum class Column : uint8_t {
+        note,
+        instrument,
+        effectType,
+        effectParam
+    };
+
+    //
+    // Maximum time between two edits, in milliseconds, for them to be merged
+    //
+    static constexpr qint64 MERGE_INTERVAL = 500;
+
+    explicit TrackEditCmd(PatternModel &model, QUndoCommand *parent = nullptr);
+
+    //
+    // Adds an edit to the given column of the track row at the model's
+    // cursor. For effect columns, effectNo is the effect being edited.
+    //
+    void addEdit(Column column, uint8_t dataNew, uint8_t dataOld, uint8_t effectNo = 0);
+
+    virtual int id() const override;
+
+    virtual bool mergeWith(QUndoCommand const* other) override;
 
     virtual void redo() override;
 
     virtual void undo() override;
 
-protected:
-    trackerboy::TrackRow& getRow();
+    virtual size_t storageSize() const override;
 
-    virtual bool edit(trackerboy::TrackRow &rowdata, uint8_t data) = 0;
+    virtual void releaseStorage() override;
 
 private:
-    void setData(uint8_t data);
+
+    struct Edit {
+        uint8_t track;
+        uint8_t row;
+        Column column;
+        uint8_t effectNo;
+        uint8_t newData;
+        uint8_t oldData;
+    };
+
+    //
+    // Sets the edit's column in the given row to data. Returns true if the
+    // pattern's size may have changed as a result of the edit.
+    //
+    static bool apply(trackerboy::TrackRow &rowdata, Edit const& edit, uint8_t data);
+
+    //
+    // Invalidates the rows and tracks that were edited
+    //
+    void invalidate(bool update);
+
+    // most commands have 1 or 2 edits (note + instrument), so these are
+    // stored inline, only merged commands need heap storage
+    static constexpr int INLINE_EDITS = 2;
+
+    PatternModel &mModel;
+    uint8_t const mPattern;
+    QVarLengthArray<Edit, INLINE_EDITS> mEdits;
+    // time since the last edit was added or merged
+    QElapsedTimer mTimer;
 
 };
 
@@ -160,10 +237,14 @@ private:
 //
 class NoteEditCmd : public TrackEditCmd {
 
-    using TrackEditCmd::TrackEditCmd;
+public:
+    explicit NoteEditCmd(
+        PatternModel &model,
+        uint8_t dataNew,
+        uint8_t dataOld,
+        QUndoCommand *parent = nullptr
+    );
 
-protected:
-    virtual bool edit(trackerboy::TrackRow &rowdata, uint8_t data) override;
 };
 
 //
@@ -171,20 +252,23 @@ protected:
 //
 class InstrumentEditCmd : public TrackEditCmd {
 
-    using TrackEditCmd::TrackEditCmd;
-
-protected:
-    virtual bool edit(trackerboy::TrackRow &rowdata, uint8_t data);
+public:
+    explicit InstrumentEditCmd(
+        PatternModel &model,
+        uint8_t dataNew,
+        uint8_t dataOld,
+        QUndoCommand *parent = nullptr
+    );
 
 };
 
 //
-// Base command class for editing an effect column
+// Command class for editing an effect type in a TrackRow
 //
-class EffectEditCmd : public TrackEditCmd {
+class EffectTypeEditCmd : public TrackEditCmd {
 
 public:
-    explicit EffectEditCmd(
+    explicit EffectTypeEditCmd(
         PatternModel &model,
         uint8_t effectNo,
         uint8_t newData,
@@ -192,31 +276,21 @@ public:
         QUndoCommand *parent = nullptr
     );
 
-protected:
-    uint8_t const mEffectNo;
-};
-
-//
-// Command class for editing an effect type in a TrackRow
-//
-class EffectTypeEditCmd : public EffectEditCmd {
-
-    using EffectEditCmd::EffectEditCmd;
-
-protected:
-    virtual bool edit(trackerboy::TrackRow &rowdata, uint8_t data) override;
-
 };
 
 //
 // Command class for editing an effect parameter in a TrackRow
 //
-class EffectParamEditCmd : public EffectEditCmd {
-
-    using EffectEditCmd::EffectEditCmd;
+class EffectParamEditCmd : public TrackEditCmd {
 
-protected:
-    virtual bool edit(trackerboy::TrackRow &rowdata, uint8_t data) override;
+public:
+    explicit EffectParamEditCmd(
+        PatternModel &model,
+        uint8_t effectNo,
+        uint8_t newData,
+        uint8_t oldData,
+        QUndoCommand *parent = nullptr
+    );
 
 };
 
@@ -258,3 +332,35 @@ public:
     virtual void undo() override;
 
 };
+
+//
+// Command for applying a BulkOperation to the song. The changes are determined
+// when the command is constructed, and only the changed track rows are stored.
+//
+class BulkEditCmd : public QUndoCommand, public IUndoStorage {
+
+    PatternModel &mModel;
+    std::vector<BulkOperation::Change> mChanges;
+
+public:
+
+    explicit BulkEditCmd(PatternModel &model, BulkOperation const& operation);
+
+    //
+    // Number of track rows changed by this command
+    //
+    int changeCount() const;
+
+    virtual void redo() override;
+
+    virtual void undo() override;
+
+    virtual size_t storageSize() const override;
+
+    virtual void releaseStorage() override;
+
+private:
+
+    void apply(bool undoing);
+
+};
@@ -0,0 +1,39 @@
+
+#pragma once
+
+#include <QString>
+
+#include <cstdio>
+
+//
+// Benchmarks run by trackerboy_bench. Each benchmark runs its workload for the
+// given number of iterations, prints its results to stdout and returns true
+// on success.
+//
+namespace Bench {
+
+//
+// Paints a full screen (3840x2160) pattern offscreen with the glyph atlas
+// and with QPainter::drawText, for comparison.
+//
+bool painter(int iterations);
+
+//
+// Paints the same pattern with the glyph atlas, using the generic row kernel
+// and then the kernels specialised for the layout, for several layouts.
+//
+bool kernels(int iterations);
+
+//
+// Reads the visualizer buffer from 1 to 8 threads while another thread writes
+// to it, through Guarded (exclusive) and SharedGuarded (shared) access, to
+// show how reads scale with the number of readers.
+//
+bool locks(int iterations);
+
+//
+// Prints a timing result, in milliseconds per iteration.
+//
+void report(char const* name, qint64 nanoseconds, int iterations);
+
+}
@@ -0,0 +1,120 @@
+
+#include "tools/bench/bench.hpp"
+
+#include "audio/VisualizerBuffer.hpp"
+#include "utils/Guarded.hpp"
+#include "utils/SharedGuarded.hpp"
+
+#include <QElapsedTimer>
+#include <QThread>
+
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#define TU benchLocksTU
+namespace TU {
+
+// a frame of audio at 48000 Hz, 60 Hz
+constexpr size_t FRAME_SIZE = 800;
+// width of the scope in the sidebar, in pixels
+constexpr int COLUMNS = 512;
+// the renderer writes a frame every period
+constexpr unsigned long WRITE_PERIOD_US = 1000;
+// decimating is quick, each iteration is this many reads per reader
+constexpr int READS_PER_ITERATION = 100;
+
+static int const READER_COUNTS[] = { 1, 2, 4, 8 };
+
+//
+// Decimates the buffer from the given number of reader threads, each
+// reading the given number of times, while a writer thread writes a frame every
+// period like the renderer. Returns the time taken for all readers to
+// finish.
+//
+// read is called as read(guarded) -> handle, and write as
+// write(guarded) -> handle.
+//
+template <class Guard, class Read, class Write>
+static qint64 run(int readers, int reads, Read read, Write write) {
+    Guard guard;
+    write(guard)->resize(FRAME_SIZE);
+
+    std::vector<float> samples(FRAME_SIZE * 2);
+    for (size_t i = 0; i < FRAME_SIZE; ++i) {
+        auto const sample = std::sin(i * 0.05f);
+        samples[i * 2] = sample;
+        samples[i * 2 + 1] = -sample;
+    }
+
+    std::atomic_bool stop(false);
+    std::unique_ptr<QThread> writer(QThread::create([&]() {
+        while (!stop.load(std::memory_order_relaxed)) {
+            {
+                auto handle = write(guard);
+                handle->beginWrite(FRAME_SIZE);
+                handle->write(samples.data(), FRAME_SIZE);
+            }
+            QThread::usleep(WRITE_PERIOD_US);
+        }
+    }));
+    writer->start(QThread::HighPriority);
+
+    std::vector<std::unique_ptr<QThread>> threads;
+    for (int i = 0; i < readers; ++i) {
+        threads.emplace_back(QThread::create([&]() {
+            std::vector<VisualizerBuffer::Column> left(COLUMNS);
+            std::vector<VisualizerBuffer::Column> right(COLUMNS);
+            for (int n = 0; n < reads; ++n) {
+                auto handle = read(guard);
+                // a zoomed out scope, the most expensive decimation
+                handle->decimate(handle->maxWindow(), COLUMNS, left.data(), right.data());
+            }
+        }));
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    for (auto &thread : threads) {
+        thread->start();
+    }
+    for (auto &thread : threads) {
+        thread->wait();
+    }
+    auto const elapsed = timer.nsecsElapsed();
+
+    stop = true;
+    writer->wait();
+    return elapsed;
+}
+
+}
+
+namespace Bench {
+
+bool locks(int iterations) {
+    auto const reads = iterations * TU::READS_PER_ITERATION;
+
+    for (auto readers : TU::READER_COUNTS) {
+        auto const exclusive = TU::run<Guarded<VisualizerBuffer>>(readers, reads,
+            [](auto &guard) { return guard.access(); },
+            [](auto &guard) { return guard.access(); }
+        );
+        auto const shared = TU::run<SharedGuarded<VisualizerBuffer>>(readers, reads,
+            [](auto &guard) { return guard.read(); },
+            [](auto &guard) { return guard.access(); }
+        );
+
+        auto const exclusiveName = QStringLiteral("Guarded, %1 readers").arg(readers).toLatin1();
+        auto const sharedName = QStringLiteral("SharedGuarded, %1 readers").arg(readers).toLatin1();
+        report(exclusiveName.constData(), exclusive, iterations);
+        report(sharedName.constData(), shared, iterations);
+    }
+
+    return true;
+}
+
+}
+
+#undef TU
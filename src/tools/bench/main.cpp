@@ -0,0 +1,99 @@
+//
+// trackerboy_bench - offscreen benchmarks for the ui's hot paths
+//
+// Usage:
+//  trackerboy_bench [-n iterations] [benchmark...]
+//
+// Runs the given benchmarks, or all of them if none are given. Widgets are
+// not shown, the offscreen platform is used unless QT_QPA_PLATFORM is set.
+//
+
+#include "tools/bench/bench.hpp"
+#include "version.hpp"
+
+#include <QApplication>
+#include <QCommandLineParser>
+
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+
+#define TU benchTU
+namespace TU {
+
+struct Benchmark {
+    char const *name;
+    bool (*run)(int iterations);
+};
+
+static Benchmark const BENCHMARKS[] = {
+    { "painter", Bench::painter },
+    { "kernels", Bench::kernels },
+    { "locks", Bench::locks }
+};
+
+}
+
+namespace Bench {
+
+void report(char const* name, qint64 nanoseconds, int iterations) {
+    std::printf("  %-24s %10.3f ms/iteration\n", name, nanoseconds / 1e6 / iterations);
+}
+
+}
+
+int main(int argc, char *argv[]) {
+
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication app(argc, argv);
+    QApplication::setApplicationName(QStringLiteral("trackerboy_bench"));
+    QApplication::setApplicationVersion(QString::fromLatin1(VERSION_STR));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Runs offscreen benchmarks of the trackerboy ui"));
+    parser.addHelpOption();
+    parser.addVersionOption();
+    QCommandLineOption iterationsOption(
+        { QStringLiteral("n"), QStringLiteral("iterations") },
+        QStringLiteral("Number of iterations for each benchmark (default 100)."),
+        QStringLiteral("count"),
+        QStringLiteral("100")
+    );
+    parser.addOption(iterationsOption);
+    parser.addPositionalArgument(QStringLiteral("benchmark"), QStringLiteral("Benchmarks to run, all if omitted."), QStringLiteral("[benchmark...]"));
+    parser.process(app);
+
+    bool ok;
+    auto const iterations = parser.value(iterationsOption).toInt(&ok);
+    if (!ok || iterations <= 0) {
+        std::fprintf(stderr, "invalid iteration count\n");
+        return 2;
+    }
+
+    auto names = parser.positionalArguments();
+    for (auto const& name : names) {
+        auto const found = std::any_of(std::begin(TU::BENCHMARKS), std::end(TU::BENCHMARKS),
+            [&name](TU::Benchmark const& bench) {
+                return name == QLatin1String(bench.name);
+            });
+        if (!found) {
+            std::fprintf(stderr, "unknown benchmark: %s\n", qPrintable(name));
+            return 2;
+        }
+    }
+
+    bool success = true;
+    for (auto const& bench : TU::BENCHMARKS) {
+        if (names.isEmpty() || names.contains(QLatin1String(bench.name))) {
+            std::printf("%s (%d iterations)\n", bench.name, iterations);
+            success &= bench.run(iterations);
+        }
+    }
+
+    return success ? 0 : 1;
+}
+
+#undef TU
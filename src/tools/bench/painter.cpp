@@ -0,0 +1,175 @@
+
+#include "tools/bench/bench.hpp"
+
+#include "config/data/Palette.hpp"
+#include "graphics/PatternLayout.hpp"
+#include "graphics/PatternPainter.hpp"
+
+#include "trackerboy/data/Pattern.hpp"
+#include <QElapsedTimer>
+#include <QFontDatabase>
+#include <QImage>
+#include <QPainter>
+
+#include <algorithm>
+#include <array>
+#include <random>
+
+#define TU benchPainterTU
+namespace TU {
+
+constexpr int SCREEN_WIDTH = 3840;
+constexpr int SCREEN_HEIGHT = 2160;
+constexpr int PATTERN_ROWS = 256;
+
+//
+// Fills a track with dense, random data: a note and instrument on most rows
+// and an effect on some.
+//
+static void fillTrack(trackerboy::Track &track, std::mt19937 &rng) {
+    std::uniform_int_distribution<int> chance(0, 3);
+    // C-2 to B-7
+    std::uniform_int_distribution<int> note(0, 12 * 6 - 1);
+    std::uniform_int_distribution<int> byte(0, 0xFF);
+    for (int row = 0; row < PATTERN_ROWS; ++row) {
+        if (chance(rng)) {
+            track.setNote((uint16_t)row, (uint8_t)note(rng));
+            track.setInstrument((uint16_t)row, (uint8_t)(byte(rng) & 0x3F));
+        }
+        if (chance(rng) == 0) {
+            track.setEffect((uint16_t)row, 0, trackerboy::EffectType::arpeggio, (uint8_t)byte(rng));
+        }
+    }
+}
+
+//
+// Paints one frame the way PatternGrid does: backgrounds, then the rows of
+// the pattern.
+//
+static qint64 paintFrames(PatternPainter &painter, PatternLayout const& layout, trackerboy::Pattern const& pattern, QImage &image, int iterations) {
+    auto const rows = std::min(painter.calculateRowsAvailable(image.height()), PATTERN_ROWS);
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        QPainter p(&image);
+        // vary the starting row like scrolling during playback
+        auto const rowStart = i % (PATTERN_ROWS - rows + 1);
+        painter.drawBackground(p, layout, 0, rowStart, rows);
+        painter.drawPattern(p, layout, pattern, rowStart, rowStart + rows - 1, 0);
+        painter.drawLines(p, layout, image.height());
+    }
+    return timer.nsecsElapsed();
+}
+
+//
+// Painter, layout and a random pattern shared by the benchmarks
+//
+struct Fixture {
+    PatternPainter painter;
+    PatternLayout layout;
+    std::array<trackerboy::Track, 4> tracks;
+    trackerboy::Pattern pattern;
+    QImage image;
+
+    Fixture() :
+        painter(font()),
+        layout(),
+        tracks{
+            trackerboy::Track(PATTERN_ROWS),
+            trackerboy::Track(PATTERN_ROWS),
+            trackerboy::Track(PATTERN_ROWS),
+            trackerboy::Track(PATTERN_ROWS)
+        },
+        pattern(tracks[0], tracks[1], tracks[2], tracks[3]),
+        image(SCREEN_WIDTH, SCREEN_HEIGHT, QImage::Format_ARGB32_Premultiplied)
+    {
+        painter.setColors(Palette());
+        painter.setFirstHighlight(4);
+        painter.setSecondHighlight(16);
+        layout.setCellSize(painter.cellWidth(), painter.cellHeight());
+
+        std::mt19937 rng(0x7B);
+        for (auto &track : tracks) {
+            fillTrack(track, rng);
+        }
+    }
+
+    qint64 paint(int iterations) {
+        return paintFrames(painter, layout, pattern, image, iterations);
+    }
+
+    static QFont font() {
+        auto font = QFontDatabase::systemFont(QFontDatabase::FixedFont);
+        font.setPointSize(12);
+        return font;
+    }
+};
+
+}
+
+namespace Bench {
+
+bool painter(int iterations) {
+
+    TU::Fixture fixture;
+    auto &painter = fixture.painter;
+    for (int track = 0; track < 4; ++track) {
+        fixture.layout.setEffectsVisible(track, 3);
+    }
+
+    // warm up both paths (builds the atlas and the font cache)
+    painter.setUseGlyphAtlas(false);
+    fixture.paint(1);
+    painter.setUseGlyphAtlas(true);
+    fixture.paint(1);
+
+    painter.setUseGlyphAtlas(false);
+    auto const textTime = fixture.paint(iterations);
+    report("drawText", textTime, iterations);
+
+    painter.setUseGlyphAtlas(true);
+    auto const atlasTime = fixture.paint(iterations);
+    report("glyph atlas", atlasTime, iterations);
+
+    std::printf("  %-24s %10.2fx\n", "speedup", (double)textTime / (double)atlasTime);
+    return true;
+}
+
+bool kernels(int iterations) {
+
+    TU::Fixture fixture;
+    auto &painter = fixture.painter;
+    painter.setUseGlyphAtlas(true);
+
+    // a mix of layouts, so that each track uses a different kernel
+    static constexpr int LAYOUTS[][4] = {
+        { 1, 1, 1, 1 },
+        { 3, 3, 3, 3 },
+        { 1, 2, 3, 2 }
+    };
+
+    for (auto const& effects : LAYOUTS) {
+        for (int track = 0; track < 4; ++track) {
+            fixture.layout.setEffectsVisible(track, effects[track]);
+        }
+        std::printf(" effects %d %d %d %d\n", effects[0], effects[1], effects[2], effects[3]);
+
+        painter.setUseRowKernels(false);
+        fixture.paint(1);
+        auto const genericTime = fixture.paint(iterations);
+        report("generic kernel", genericTime, iterations);
+
+        painter.setUseRowKernels(true);
+        fixture.paint(1);
+        auto const specialisedTime = fixture.paint(iterations);
+        report("specialised kernels", specialisedTime, iterations);
+
+        std::printf("  %-24s %10.2fx\n", "speedup", (double)genericTime / (double)specialisedTime);
+    }
+    return true;
+}
+
+}
+
+#undef TU
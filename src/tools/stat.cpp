@@ -0,0 +1,480 @@
+
+//
+// trackerboy_stat - headless module validator and statistics tool
+//
+// Deserializes every module (*.tbm) found in the given files/directories,
+// reporting the trackerboy::FormatError for each file and aggregate usage
+// statistics as JSON. Modules are loaded in parallel, one worker thread per
+// core by default.
+//
+// Usage:
+//  trackerboy_stat [-j jobs] [-o output.json] [--files] <path>...
+//
+// The exit code is 0 if all modules loaded successfully, 1 if one or more
+// modules failed to load, and 2 for bad arguments.
+//
+
+#include "core/EffectStrings.hpp"
+#include "version.hpp"
+
+#include "trackerboy/data/Module.hpp"
+#include "trackerboy/trackerboy.hpp"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThread>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#define TU statTU
+namespace TU {
+
+constexpr int EXIT_OK = 0;
+constexpr int EXIT_INVALID_MODULES = 1;
+constexpr int EXIT_BAD_ARGUMENTS = 2;
+
+constexpr int EFFECT_TYPES = 256;
+
+static char const* formatErrorToString(trackerboy::FormatError err) {
+    switch (err) {
+        case trackerboy::FormatError::none:
+            return "none";
+        case trackerboy::FormatError::invalidSignature:
+            return "invalidSignature";
+        case trackerboy::FormatError::invalidRevision:
+            return "invalidRevision";
+        case trackerboy::FormatError::cannotUpgrade:
+            return "cannotUpgrade";
+        case trackerboy::FormatError::duplicateId:
+            return "duplicateId";
+        case trackerboy::FormatError::invalid:
+            return "invalid";
+        case trackerboy::FormatError::unknownChannel:
+            return "unknownChannel";
+        default:
+            return "unknown";
+    }
+}
+
+//
+// Result of loading a single module file
+//
+struct FileResult {
+    qint64 size;
+    trackerboy::FormatError error;
+    bool ioError;
+};
+
+//
+// Aggregate statistics, each worker keeps its own copy which are merged
+// after all workers have finished. Song lengths are in rows (the playable
+// length of each pattern is used, so Bxx/Cxx/Dxx are taken into account).
+//
+struct Stats {
+    qint64 bytes;
+    int modulesLoaded;
+    int songs;
+    int instruments;
+    int waveforms;
+    int maxInstruments;
+    int maxWaveforms;
+    qint64 orderRows;
+    qint64 tracksUsed;
+    qint64 rows;
+    qint64 notes;
+    qint64 noteCuts;
+    qint64 instrumentColumns;
+    qint64 effects;
+    std::array<qint64, EFFECT_TYPES> effectCounts;
+
+    int minSongRows;
+    int maxSongRows;
+    double totalSongSeconds;
+    double minSongSeconds;
+    double maxSongSeconds;
+
+    Stats() :
+        bytes(0),
+        modulesLoaded(0),
+        songs(0),
+        instruments(0),
+        waveforms(0),
+        maxInstruments(0),
+        maxWaveforms(0),
+        orderRows(0),
+        tracksUsed(0),
+        rows(0),
+        notes(0),
+        noteCuts(0),
+        instrumentColumns(0),
+        effects(0),
+        effectCounts(),
+        minSongRows(std::numeric_limits<int>::max()),
+        maxSongRows(0),
+        totalSongSeconds(0.0),
+        minSongSeconds(std::numeric_limits<double>::max()),
+        maxSongSeconds(0.0)
+    {
+    }
+
+    void merge(Stats const& other) {
+        bytes += other.bytes;
+        modulesLoaded += other.modulesLoaded;
+        songs += other.songs;
+        instruments += other.instruments;
+        waveforms += other.waveforms;
+        maxInstruments = std::max(maxInstruments, other.maxInstruments);
+        maxWaveforms = std::max(maxWaveforms, other.maxWaveforms);
+        orderRows += other.orderRows;
+        tracksUsed += other.tracksUsed;
+        rows += other.rows;
+        notes += other.notes;
+        noteCuts += other.noteCuts;
+        instrumentColumns += other.instrumentColumns;
+        effects += other.effects;
+        for (size_t i = 0; i < effectCounts.size(); ++i) {
+            effectCounts[i] += other.effectCounts[i];
+        }
+        minSongRows = std::min(minSongRows, other.minSongRows);
+        maxSongRows = std::max(maxSongRows, other.maxSongRows);
+        totalSongSeconds += other.totalSongSeconds;
+        minSongSeconds = std::min(minSongSeconds, other.minSongSeconds);
+        maxSongSeconds = std::max(maxSongSeconds, other.maxSongSeconds);
+    }
+
+};
+
+//
+// Accumulate statistics for a successfully loaded module
+//
+static void gatherStats(trackerboy::Module &mod, Stats &stats) {
+    ++stats.modulesLoaded;
+
+    auto const instruments = (int)mod.instrumentTable().size();
+    auto const waveforms = (int)mod.waveformTable().size();
+    stats.instruments += instruments;
+    stats.waveforms += waveforms;
+    stats.maxInstruments = std::max(stats.maxInstruments, instruments);
+    stats.maxWaveforms = std::max(stats.maxWaveforms, waveforms);
+
+    auto const framerate = mod.framerate();
+    auto &songs = mod.songs();
+    auto const songCount = songs.size();
+    stats.songs += (int)songCount;
+
+    for (int i = 0; i < (int)songCount; ++i) {
+        auto song = songs.get(i);
+        auto const& order = song->order();
+        auto const orderSize = order.size();
+        stats.orderRows += orderSize;
+
+        // unique track ids used by the order, per channel
+        std::array<std::array<bool, trackerboy::MAX_PATTERNS>, 4> used{};
+
+        int songRows = 0;
+        for (int o = 0; o < (int)orderSize; ++o) {
+            auto const& orderRow = order[o];
+            for (int ch = 0; ch < 4; ++ch) {
+                auto &flag = used[ch][orderRow[ch]];
+                if (!flag) {
+                    flag = true;
+                    ++stats.tracksUsed;
+                }
+            }
+
+            auto pattern = song->getPattern(o);
+            auto const totalRows = (int)pattern.totalRows();
+            songRows += totalRows;
+            for (int ch = 0; ch < 4; ++ch) {
+                for (int row = 0; row < totalRows; ++row) {
+                    auto const& rowdata = pattern.getTrackRow(static_cast<trackerboy::ChType>(ch), (uint16_t)row);
+                    auto note = rowdata.queryNote();
+                    if (note) {
+                        if (*note == trackerboy::NOTE_CUT) {
+                            ++stats.noteCuts;
+                        } else {
+                            ++stats.notes;
+                        }
+                    }
+                    if (rowdata.queryInstrument()) {
+                        ++stats.instrumentColumns;
+                    }
+                    for (auto const& effect : rowdata.effects) {
+                        if (effect.type != trackerboy::EffectType::noEffect) {
+                            ++stats.effects;
+                            ++stats.effectCounts[static_cast<uint8_t>(effect.type)];
+                        }
+                    }
+                }
+            }
+        }
+
+        stats.rows += songRows;
+        stats.minSongRows = std::min(stats.minSongRows, songRows);
+        stats.maxSongRows = std::max(stats.maxSongRows, songRows);
+
+        // estimated play time, one pass through the order
+        auto const seconds = songRows * trackerboy::speedToFloat(song->speed()) / framerate;
+        stats.totalSongSeconds += seconds;
+        stats.minSongSeconds = std::min(stats.minSongSeconds, (double)seconds);
+        stats.maxSongSeconds = std::max(stats.maxSongSeconds, (double)seconds);
+    }
+}
+
+//
+// Loads the module at the given path, gathering statistics if the load
+// was successful
+//
+static FileResult loadModule(QString const& path, qint64 size, Stats &stats) {
+    FileResult result{ size, trackerboy::FormatError::none, false };
+
+    std::ifstream in(path.toStdString(), std::ios::binary | std::ios::in);
+    result.ioError = in.fail();
+    if (!result.ioError) {
+        trackerboy::Module mod;
+        result.error = mod.deserialize(in);
+        result.ioError = in.bad();
+        if (result.error == trackerboy::FormatError::none && !result.ioError) {
+            // only loaded modules count toward the throughput
+            stats.bytes += size;
+            gatherStats(mod, stats);
+        }
+    }
+
+    return result;
+}
+
+static QJsonObject statsToJson(Stats const& stats) {
+    QJsonObject effects;
+    for (int i = 0; i < EFFECT_TYPES; ++i) {
+        auto count = stats.effectCounts[i];
+        if (count) {
+            auto ch = EffectStrings::toChar(static_cast<trackerboy::EffectType>(i));
+            effects.insert(QString(QChar(ch)), count);
+        }
+    }
+
+    auto const modules = std::max(1, stats.modulesLoaded);
+    auto const songs = std::max(1, stats.songs);
+    auto const hasSongs = stats.songs > 0;
+
+    return {
+        { QStringLiteral("modules"), stats.modulesLoaded },
+        { QStringLiteral("songs"), stats.songs },
+        { QStringLiteral("instruments"), QJsonObject{
+            { QStringLiteral("total"), stats.instruments },
+            { QStringLiteral("max"), stats.maxInstruments },
+            { QStringLiteral("mean"), (double)stats.instruments / modules }
+        }},
+        { QStringLiteral("waveforms"), QJsonObject{
+            { QStringLiteral("total"), stats.waveforms },
+            { QStringLiteral("max"), stats.maxWaveforms },
+            { QStringLiteral("mean"), (double)stats.waveforms / modules }
+        }},
+        { QStringLiteral("patterns"), QJsonObject{
+            { QStringLiteral("orderRows"), stats.orderRows },
+            { QStringLiteral("tracksUsed"), stats.tracksUsed },
+            { QStringLiteral("rows"), stats.rows }
+        }},
+        { QStringLiteral("notes"), stats.notes },
+        { QStringLiteral("noteCuts"), stats.noteCuts },
+        { QStringLiteral("instrumentColumns"), stats.instrumentColumns },
+        { QStringLiteral("effects"), QJsonObject{
+            { QStringLiteral("total"), stats.effects },
+            { QStringLiteral("byType"), effects }
+        }},
+        { QStringLiteral("songLength"), QJsonObject{
+            { QStringLiteral("minRows"), hasSongs ? stats.minSongRows : 0 },
+            { QStringLiteral("maxRows"), stats.maxSongRows },
+            { QStringLiteral("meanRows"), (double)stats.rows / songs },
+            { QStringLiteral("minSeconds"), hasSongs ? stats.minSongSeconds : 0.0 },
+            { QStringLiteral("maxSeconds"), stats.maxSongSeconds },
+            { QStringLiteral("meanSeconds"), stats.totalSongSeconds / songs }
+        }}
+    };
+}
+
+}
+
+int main(int argc, char *argv[]) {
+
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("trackerboy_stat");
+    QCoreApplication::setApplicationVersion(VERSION_STR);
+
+#define stat_tr(str) QCoreApplication::translate("stat", str)
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(stat_tr("Validates trackerboy modules and reports usage statistics as JSON"));
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addPositionalArgument("path", stat_tr("Module files or directories to search (recursively) for *.tbm files"), "<path>...");
+    QCommandLineOption jobsOption({ "j", "jobs" }, stat_tr("Number of worker threads (default: number of cores)"), "jobs");
+    QCommandLineOption outputOption({ "o", "output" }, stat_tr("Write the JSON report to this file instead of stdout"), "file");
+    QCommandLineOption filesOption("files", stat_tr("Include a result entry for every file, not just failures"));
+    parser.addOption(jobsOption);
+    parser.addOption(outputOption);
+    parser.addOption(filesOption);
+
+    parser.process(app);
+
+    auto const positionals = parser.positionalArguments();
+    if (positionals.isEmpty()) {
+        fputs("no paths given\n", stderr);
+        fputs(qPrintable(parser.helpText()), stderr);
+        return TU::EXIT_BAD_ARGUMENTS;
+    }
+
+    int jobs = QThread::idealThreadCount();
+    if (parser.isSet(jobsOption)) {
+        bool ok;
+        jobs = parser.value(jobsOption).toInt(&ok);
+        if (!ok || jobs < 1) {
+            fputs("invalid number of jobs\n", stderr);
+            return TU::EXIT_BAD_ARGUMENTS;
+        }
+    }
+    jobs = std::max(1, jobs);
+
+    // collect the list of files to load
+    QStringList paths;
+    std::vector<qint64> sizes;
+    for (auto const& arg : positionals) {
+        QFileInfo info(arg);
+        if (info.isDir()) {
+            QDirIterator iter(arg, { QStringLiteral("*.tbm") }, QDir::Files, QDirIterator::Subdirectories);
+            while (iter.hasNext()) {
+                iter.next();
+                paths.append(iter.filePath());
+                sizes.push_back(iter.fileInfo().size());
+            }
+        } else if (info.exists()) {
+            paths.append(arg);
+            sizes.push_back(info.size());
+        } else {
+            fprintf(stderr, "path does not exist: %s\n", qPrintable(arg));
+            return TU::EXIT_BAD_ARGUMENTS;
+        }
+    }
+
+    auto const fileCount = (int)paths.size();
+    jobs = std::min(jobs, std::max(1, fileCount));
+
+    std::vector<TU::FileResult> results((size_t)fileCount);
+    std::vector<TU::Stats> workerStats((size_t)jobs);
+    std::atomic_int nextFile(0);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // each worker takes the next unclaimed file, so large modules do not
+    // leave the other workers idle. Results are written to the file's slot
+    // and statistics to the worker's own Stats, so no locking is needed.
+    auto worker = [&](int index) {
+        auto &stats = workerStats[index];
+        for (;;) {
+            auto const fileIndex = nextFile.fetch_add(1, std::memory_order_relaxed);
+            if (fileIndex >= fileCount) {
+                break;
+            }
+            results[fileIndex] = TU::loadModule(paths[fileIndex], sizes[fileIndex], stats);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve((size_t)jobs - 1);
+    for (int i = 1; i < jobs; ++i) {
+        threads.emplace_back(worker, i);
+    }
+    // main thread is worker 0
+    worker(0);
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    auto const elapsed = timer.nsecsElapsed();
+
+    TU::Stats total;
+    for (auto const& stats : workerStats) {
+        total.merge(stats);
+    }
+
+    // per-file results and error counts
+    QJsonArray files;
+    QJsonObject errorCounts;
+    int failed = 0;
+    for (int i = 0; i < fileCount; ++i) {
+        auto const& result = results[i];
+        auto const ok = result.error == trackerboy::FormatError::none && !result.ioError;
+        if (!ok) {
+            ++failed;
+            QString key = result.ioError ? QStringLiteral("ioError") : QString::fromLatin1(TU::formatErrorToString(result.error));
+            errorCounts.insert(key, errorCounts.value(key).toInt() + 1);
+        }
+        if (!ok || parser.isSet(filesOption)) {
+            files.append(QJsonObject{
+                { QStringLiteral("path"), paths[i] },
+                { QStringLiteral("size"), result.size },
+                { QStringLiteral("error"), QString::fromLatin1(TU::formatErrorToString(result.error)) },
+                { QStringLiteral("ioError"), result.ioError }
+            });
+        }
+    }
+
+    auto const seconds = std::max(elapsed, (qint64)1) / 1e9;
+
+    QJsonObject report {
+        { QStringLiteral("version"), QString::fromLatin1(VERSION_STR) },
+        { QStringLiteral("files"), fileCount },
+        { QStringLiteral("failed"), failed },
+        { QStringLiteral("errors"), errorCounts },
+        { QStringLiteral("results"), files },
+        { QStringLiteral("statistics"), TU::statsToJson(total) },
+        { QStringLiteral("throughput"), QJsonObject{
+            { QStringLiteral("threads"), jobs },
+            { QStringLiteral("seconds"), seconds },
+            { QStringLiteral("bytes"), total.bytes },
+            { QStringLiteral("filesPerSecond"), fileCount / seconds },
+            { QStringLiteral("megabytesPerSecond"), total.bytes / (1024.0 * 1024.0) / seconds }
+        }}
+    };
+
+    auto const json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+    if (parser.isSet(outputOption)) {
+        QFile file(parser.value(outputOption));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            fprintf(stderr, "could not open output file: %s\n", qPrintable(file.fileName()));
+            return TU::EXIT_BAD_ARGUMENTS;
+        }
+        file.write(json);
+    } else {
+        fwrite(json.constData(), 1, (size_t)json.size(), stdout);
+    }
+
+    fprintf(stderr, "%d files (%d failed) in %.3f s using %d threads: %.1f files/s, %.2f MB/s\n",
+        fileCount,
+        failed,
+        seconds,
+        jobs,
+        fileCount / seconds,
+        total.bytes / (1024.0 * 1024.0) / seconds
+    );
+
+    return failed ? TU::EXIT_INVALID_MODULES : TU::EXIT_OK;
+}
+
+#undef TU
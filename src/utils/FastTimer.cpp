@@ -50,19 +50,35 @@ void FastTimer::setInterval(int ms, Qt::TimerType type) {
 }
 
 void FastTimer::timerEvent(QTimerEvent *evt) {
+    invokeCallback(evt->timerId());
+}
+
+void FastTimer::invokeCallback(int timerId) {
     mMutex.lock();
-    auto const timerId = mTimerId;
+    auto const currentTimerId = mTimerId;
     auto const callback = mCallback;
     auto const data = mCallbackData;
     mMutex.unlock();
 
 
-    if (evt->timerId() == timerId && callback) {
+    if (timerId == currentTimerId && callback) {
         callback(data);
     }
 
 }
 
+void FastTimer::fire() {
+    mMutex.lock();
+    auto const timerId = mTimerId;
+    mMutex.unlock();
+
+    if (timerId != TU::NO_TIMER) {
+        // queued, so that the callback is invoked from the timer's thread. The
+        // timer id is checked again in case it was stopped in the meantime.
+        QMetaObject::invokeMethod(this, [this, timerId]() { invokeCallback(timerId); }, Qt::QueuedConnection);
+    }
+}
+
 
 void FastTimer::start() {
     if (objectInCurrentThread(*this)) {
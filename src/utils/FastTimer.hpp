@@ -35,6 +35,13 @@ public:
 
     void stop();
 
+    //
+    // Invokes the callback as soon as possible from the timer's thread, in
+    // addition to the regular interval. Does nothing if the timer is not
+    // running by then. Does not block.
+    //
+    void fire();
+
 protected:
 
     virtual void timerEvent(QTimerEvent *evt) override;
@@ -45,6 +52,8 @@ private:
 
     void _stopTimer();
 
+    void invokeCallback(int timerId);
+
 
     QMutex mMutex;
     CallbackFn mCallback;
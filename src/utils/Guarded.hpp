@@ -3,6 +3,7 @@
 
 #include "utils/Locked.hpp"
 
+#include <typeinfo>
 #include <utility>
 
 //
@@ -24,7 +25,8 @@ public:
     template <typename... Ts>
     Guarded(Ts&&... args) :
         mHandle(std::forward<Ts>(args)...),
-        mMutex()
+        mMutex(),
+        mStats(typeid(T).name(), mMutex)
     {
     }
 
@@ -32,13 +34,14 @@ public:
     // Returns a handle to the contained object that holds the mutex
     // for the lifetime of the handle.
     //
-    Locked<T> access() {
-        return { mHandle, mMutex };
+    Locked<T> access(LockSite site = LockSite::current()) {
+        return { mHandle, mMutex, mStats, site };
     }
 
 private:
     T mHandle;
     QMutex mMutex;
+    LockStats mStats;
 };
 
 
@@ -0,0 +1,292 @@
+
+#include "utils/LockProfiler.hpp"
+
+#ifdef TRACKERBOY_LOCK_PROFILING
+
+#include <QMutexLocker>
+#include <QStringBuilder>
+#include <QtDebug>
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#ifdef __GNUG__
+#include <cstdlib>
+#include <cxxabi.h>
+#endif
+
+#define TU LockProfilerTU
+namespace TU {
+
+// number of call sites listed in the report, for each lock
+constexpr size_t TOP_SITES = 8;
+
+//
+// All LockStats that exist
+//
+struct Registry {
+    std::mutex mutex;
+    std::vector<LockStats*> locks;
+};
+
+Registry& registry() {
+    static Registry reg;
+    return reg;
+}
+
+QString demangle(char const* name) {
+#ifdef __GNUG__
+    int status = -1;
+    std::unique_ptr<char, void(*)(void*)> demangled {
+        abi::__cxa_demangle(name, nullptr, nullptr, &status),
+        std::free
+    };
+    if (status == 0) {
+        return QString::fromLatin1(demangled.get());
+    }
+#endif
+    return QString::fromLatin1(name);
+}
+
+QString formatDuration(LockStats::Clock::duration duration) {
+    auto const us = std::chrono::duration<double, std::micro>(duration).count();
+    if (us >= 1000.0) {
+        return QStringLiteral("%1 ms").arg(us / 1000.0, 0, 'f', 2);
+    } else {
+        return QStringLiteral("%1 us").arg(us, 0, 'f', 1);
+    }
+}
+
+QString formatSite(LockSite const& site) {
+    auto file = QString::fromLatin1(site.file);
+    auto const slash = std::max(file.lastIndexOf('/'), file.lastIndexOf('\\'));
+    return QStringLiteral("%1:%2 (%3)").arg(file.mid(slash + 1)).arg(site.line).arg(QString::fromLatin1(site.function));
+}
+
+QString formatHistogram(char const* title, LockStats::Histogram const& histogram) {
+    QString str = QStringLiteral("  %1:\n").arg(QString::fromLatin1(title));
+    for (size_t i = 0; i < histogram.size(); ++i) {
+        if (histogram[i] == 0) {
+            continue;
+        }
+        QString range;
+        if (i == 0) {
+            range = QStringLiteral("< 1 us");
+        } else if (i == histogram.size() - 1) {
+            range = QStringLiteral(">= %1 us").arg(1ull << (i - 1));
+        } else {
+            range = QStringLiteral("%1-%2 us").arg(1ull << (i - 1)).arg(1ull << i);
+        }
+        str += QStringLiteral("    %1 %2\n").arg(range, -18).arg(histogram[i]);
+    }
+    return str;
+}
+
+}
+
+LockStats::LockStats(char const* name, QMutex &mutex) :
+    mName(name),
+    mMutex(mutex),
+    mHolder(nullptr),
+    mAcquisitions(0),
+    mContended(0),
+    mWaitHistogram(),
+    mHoldHistogram(),
+    mSites()
+{
+    auto &reg = TU::registry();
+    std::scoped_lock lock(reg.mutex);
+    reg.locks.push_back(this);
+}
+
+LockStats::~LockStats() {
+    auto &reg = TU::registry();
+    std::scoped_lock lock(reg.mutex);
+    reg.locks.erase(std::find(reg.locks.begin(), reg.locks.end(), this));
+}
+
+LockStats::Site* LockStats::acquired(LockSite const& location, Clock::duration wait, bool contended, Site *holder) {
+    // new call sites allocate, which is the profiler's doing
+    Realtime::Allow allow;
+
+    auto iter = mSites.try_emplace({ location.file, location.line, location.function }).first;
+    auto &site = iter->second;
+    site.location = location;
+
+    ++mAcquisitions;
+    ++site.acquisitions;
+    if (contended) {
+        ++mContended;
+        ++site.contended;
+        ++mWaitHistogram[bucket(wait)];
+        site.waitTotal += wait;
+        site.waitMax = std::max(site.waitMax, wait);
+        if (holder) {
+            holder->blocking += wait;
+            site.blockedBy[holder] += wait;
+        }
+    }
+
+    mHolder.store(&site, std::memory_order_relaxed);
+    return &site;
+}
+
+void LockStats::releasing(Site *site, Clock::duration hold) {
+    ++mHoldHistogram[bucket(hold)];
+    site->holdTotal += hold;
+    site->holdMax = std::max(site->holdMax, hold);
+    mHolder.store(nullptr, std::memory_order_relaxed);
+}
+
+LockStats::Site* LockStats::holder() const {
+    return mHolder.load(std::memory_order_relaxed);
+}
+
+size_t LockStats::bucket(Clock::duration duration) {
+    auto us = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    size_t index = 0;
+    while (us && index < BUCKETS - 1) {
+        us >>= 1;
+        ++index;
+    }
+    return index;
+}
+
+QString LockStats::report() {
+    auto &reg = TU::registry();
+    std::scoped_lock lock(reg.mutex);
+    QString str;
+    for (auto stats : reg.locks) {
+        QMutexLocker locker(&stats->mMutex);
+        str += stats->reportLocked();
+    }
+    return str;
+}
+
+void LockStats::resetAll() {
+    auto &reg = TU::registry();
+    std::scoped_lock lock(reg.mutex);
+    for (auto stats : reg.locks) {
+        QMutexLocker locker(&stats->mMutex);
+        stats->reset();
+    }
+}
+
+QString LockStats::reportLocked() const {
+    QString str = QStringLiteral("%1: %2 acquisitions, %3 contended\n")
+        .arg(TU::demangle(mName))
+        .arg(mAcquisitions)
+        .arg(mContended);
+    if (mAcquisitions == 0) {
+        return str;
+    }
+
+    str += TU::formatHistogram("wait time (contended)", mWaitHistogram);
+    str += TU::formatHistogram("hold time", mHoldHistogram);
+
+    std::vector<Site const*> sites;
+    for (auto const& pair : mSites) {
+        sites.push_back(&pair.second);
+    }
+
+    // sites that waited the longest
+    std::sort(sites.begin(), sites.end(), [](Site const* a, Site const* b) {
+        return a->waitTotal > b->waitTotal;
+    });
+    str += QStringLiteral("  top waiting sites:\n");
+    for (size_t i = 0; i < std::min(sites.size(), TU::TOP_SITES) && sites[i]->contended; ++i) {
+        auto const site = sites[i];
+        str += QStringLiteral("    %1: waited %2 total, %3 max, %4 of %5 acquisitions contended\n")
+            .arg(TU::formatSite(site->location), TU::formatDuration(site->waitTotal), TU::formatDuration(site->waitMax))
+            .arg(site->contended)
+            .arg(site->acquisitions);
+
+        std::vector<std::pair<Site const*, Clock::duration>> blockers(site->blockedBy.begin(), site->blockedBy.end());
+        std::sort(blockers.begin(), blockers.end(), [](auto const& a, auto const& b) {
+            return a.second > b.second;
+        });
+        for (size_t j = 0; j < std::min(blockers.size(), TU::TOP_SITES); ++j) {
+            str += QStringLiteral("      blocked by %1: %2\n")
+                .arg(TU::formatSite(blockers[j].first->location), TU::formatDuration(blockers[j].second));
+        }
+    }
+
+    // sites that made others wait the longest
+    std::sort(sites.begin(), sites.end(), [](Site const* a, Site const* b) {
+        return a->blocking > b->blocking;
+    });
+    str += QStringLiteral("  top blocking sites:\n");
+    for (size_t i = 0; i < std::min(sites.size(), TU::TOP_SITES) && sites[i]->blocking.count(); ++i) {
+        auto const site = sites[i];
+        str += QStringLiteral("    %1: blocked others %2 total, held %3 total, %4 max\n")
+            .arg(TU::formatSite(site->location), TU::formatDuration(site->blocking),
+                 TU::formatDuration(site->holdTotal), TU::formatDuration(site->holdMax));
+    }
+
+    return str;
+}
+
+void LockStats::reset() {
+    mAcquisitions = 0;
+    mContended = 0;
+    mWaitHistogram.fill(0);
+    mHoldHistogram.fill(0);
+    for (auto &pair : mSites) {
+        auto &site = pair.second;
+        site = { site.location, 0, 0, {}, {}, {}, {}, {}, {} };
+    }
+}
+
+ProfiledLocker::ProfiledLocker(QMutex &mutex, LockStats &stats, LockSite site) :
+    mMutex(mutex),
+    mStats(stats),
+    mSite(site),
+    mSiteStats(nullptr),
+    mAcquired(),
+    mLocked(false)
+{
+    relock();
+}
+
+ProfiledLocker::~ProfiledLocker() {
+    unlock();
+}
+
+void ProfiledLocker::unlock() {
+    if (mLocked) {
+        mStats.releasing(mSiteStats, LockStats::Clock::now() - mAcquired);
+        mLocked = false;
+        mMutex.unlock();
+    }
+}
+
+void ProfiledLocker::relock() {
+    if (mLocked) {
+        return;
+    }
+
+    LockStats::Clock::duration wait{};
+    bool contended = false;
+    LockStats::Site *holder = nullptr;
+    if (!mMutex.tryLock()) {
+        contended = true;
+        holder = mStats.holder();
+        Realtime::blocked(mSite);
+        auto const start = LockStats::Clock::now();
+        mMutex.lock();
+        wait = LockStats::Clock::now() - start;
+    }
+    mSiteStats = mStats.acquired(mSite, wait, contended, holder);
+    mLocked = true;
+    mAcquired = LockStats::Clock::now();
+}
+
+QMutex* ProfiledLocker::mutex() const {
+    return &mMutex;
+}
+
+#undef TU
+
+#endif
@@ -0,0 +1,224 @@
+
+#pragma once
+
+#include "utils/Realtime.hpp"
+
+#include <QMutex>
+
+#ifdef TRACKERBOY_LOCK_PROFILING
+#include <QString>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <tuple>
+#endif
+
+//
+// Location in the source that acquired a lock. Functions that lock take a
+// LockSite defaulted to LockSite::current(), so that the caller's location
+// is recorded without having to pass it.
+//
+struct LockSite {
+    char const* file;
+    int line;
+    char const* function;
+
+    static constexpr LockSite current(
+        char const* file = __builtin_FILE(),
+        int line = __builtin_LINE(),
+        char const* function = __builtin_FUNCTION()
+    ) {
+        return { file, line, function };
+    }
+};
+
+#ifdef TRACKERBOY_LOCK_PROFILING
+
+//
+// Contention statistics for a mutex, enabled with the ENABLE_LOCK_PROFILING
+// CMake option.
+//
+// Every acquisition through a ProfiledLocker records the time spent waiting
+// for the mutex and the time it was held, for the lock and for the call site
+// that acquired it. When a call site has to wait, the call site holding the
+// mutex at that moment is blamed. All statistics are only modified while
+// the mutex is held, so they need no synchronization of their own.
+//
+class LockStats {
+
+public:
+    using Clock = std::chrono::steady_clock;
+
+    //
+    // Log2 buckets of microseconds, the first bucket is < 1 us and the last
+    // one is everything over ~4 s.
+    //
+    static constexpr size_t BUCKETS = 24;
+    using Histogram = std::array<uint64_t, BUCKETS>;
+
+    //
+    // Statistics for a call site
+    //
+    struct Site {
+        LockSite location;
+        uint64_t acquisitions;
+        uint64_t contended;
+        Clock::duration waitTotal;
+        Clock::duration waitMax;
+        Clock::duration holdTotal;
+        Clock::duration holdMax;
+        // time other call sites spent waiting while this site held the lock
+        Clock::duration blocking;
+        // time spent waiting, by the call site holding the lock
+        std::map<Site const*, Clock::duration> blockedBy;
+    };
+
+    //
+    // Profiles the given mutex, under the given name (for Guarded, the
+    // mangled name of the guarded type). The name must outlive this object.
+    //
+    LockStats(char const* name, QMutex &mutex);
+    ~LockStats();
+
+    //
+    // Called by ProfiledLocker once the mutex has been acquired. holder is
+    // the site that held the mutex when waiting began, if it was contended.
+    //
+    Site* acquired(LockSite const& location, Clock::duration wait, bool contended, Site *holder);
+
+    //
+    // Called by ProfiledLocker before the mutex is released.
+    //
+    void releasing(Site *site, Clock::duration hold);
+
+    //
+    // Gets the site currently holding the mutex, may be nullptr.
+    //
+    Site* holder() const;
+
+    //
+    // Formats a report of all profiled locks, with wait and hold time
+    // histograms and the most contended call sites.
+    //
+    static QString report();
+
+    //
+    // Clears the statistics of all profiled locks.
+    //
+    static void resetAll();
+
+private:
+    Q_DISABLE_COPY(LockStats)
+
+    using SiteKey = std::tuple<char const*, int, char const*>;
+
+    static size_t bucket(Clock::duration duration);
+
+    QString reportLocked() const;
+
+    void reset();
+
+    char const* mName;
+    QMutex &mMutex;
+    std::atomic<Site*> mHolder;
+
+    uint64_t mAcquisitions;
+    uint64_t mContended;
+    Histogram mWaitHistogram;
+    Histogram mHoldHistogram;
+    // call sites are never erased, so that pointers to them stay valid
+    std::map<SiteKey, Site> mSites;
+
+};
+
+//
+// QMutexLocker replacement that records statistics into a LockStats.
+//
+class ProfiledLocker {
+
+public:
+    ProfiledLocker(QMutex &mutex, LockStats &stats, LockSite site);
+    ~ProfiledLocker();
+
+    void unlock();
+
+    void relock();
+
+    QMutex* mutex() const;
+
+private:
+    Q_DISABLE_COPY(ProfiledLocker)
+
+    QMutex &mMutex;
+    LockStats &mStats;
+    LockSite mSite;
+    LockStats::Site *mSiteStats;
+    LockStats::Clock::time_point mAcquired;
+    bool mLocked;
+
+};
+
+#else
+
+//
+// Lock profiling is disabled, LockStats does nothing and ProfiledLocker is
+// the same as a QMutexLocker (besides the real-time checks, if enabled).
+//
+
+class LockStats {
+
+public:
+    LockStats(char const* name, QMutex &mutex) {
+        Q_UNUSED(name)
+        Q_UNUSED(mutex)
+    }
+
+};
+
+class ProfiledLocker {
+
+public:
+    ProfiledLocker(QMutex &mutex, LockStats &stats, LockSite site) :
+        mMutex(mutex),
+        mSite(site),
+        mLocked(false)
+    {
+        Q_UNUSED(stats)
+        relock();
+    }
+
+    ~ProfiledLocker() {
+        unlock();
+    }
+
+    void unlock() {
+        if (mLocked) {
+            mLocked = false;
+            mMutex.unlock();
+        }
+    }
+
+    void relock() {
+        if (!mLocked) {
+            Realtime::lock(mMutex, mSite);
+            mLocked = true;
+        }
+    }
+
+    QMutex* mutex() const {
+        return &mMutex;
+    }
+
+private:
+    Q_DISABLE_COPY(ProfiledLocker)
+
+    QMutex &mMutex;
+    LockSite mSite;
+    bool mLocked;
+
+};
+
+#endif
@@ -1,19 +1,20 @@
 #pragma once
 
-#include <QMutex>
-#include <QMutexLocker>
+#include "utils/LockProfiler.hpp"
 
 //
-// QMutexLocker subclass holding a reference to a locked object.
+// QMutexLocker replacement holding a reference to a locked object. The lock
+// is profiled when lock profiling is enabled, see LockProfiler.hpp, and
+// checked when real-time checks are enabled, see Realtime.hpp
 //
 template <class T>
-class Locked : public QMutexLocker<QMutex> {
+class Locked : public ProfiledLocker {
 
     T &mRef;
 
 public:
-    constexpr Locked(T &ref, QMutex &mutex) :
-        QMutexLocker(&mutex),
+    Locked(T &ref, QMutex &mutex, LockStats &stats, LockSite site) :
+        ProfiledLocker(mutex, stats, site),
         mRef(ref)
     {
     }
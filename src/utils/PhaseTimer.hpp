@@ -0,0 +1,50 @@
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QtDebug>
+
+//
+// Logs the time taken by each phase of a sequence of work, such as startup.
+// Each call to phase() logs the time since the previous phase (or since
+// construction).
+//
+// Ex:
+// PhaseTimer timer("[Startup]");
+// loadSomething();
+// timer.phase("load");     // [Startup] load: 12 ms
+//
+class PhaseTimer {
+
+public:
+
+    explicit PhaseTimer(char const* prefix) :
+        mPrefix(prefix),
+        mTotal(),
+        mPhase()
+    {
+        mTotal.start();
+        mPhase.start();
+    }
+
+    //
+    // Logs the time since the last phase ended, and starts the next phase.
+    //
+    void phase(char const* name) {
+        qInfo().nospace().noquote() << mPrefix << ' ' << name << ": " << mPhase.restart() << " ms";
+    }
+
+    //
+    // Gets the time since construction, in milliseconds.
+    //
+    qint64 elapsed() const {
+        return mTotal.elapsed();
+    }
+
+private:
+
+    char const* mPrefix;
+    QElapsedTimer mTotal;
+    QElapsedTimer mPhase;
+
+};
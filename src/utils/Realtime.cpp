@@ -0,0 +1,224 @@
+
+#include "utils/Realtime.hpp"
+
+#ifdef TRACKERBOY_REALTIME_CHECKS
+
+#include "utils/LockProfiler.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#if __has_include(<execinfo.h>)
+#include <execinfo.h>
+#include <unistd.h>
+#define REALTIME_BACKTRACE
+#endif
+
+#ifdef __GLIBC__
+//
+// glibc's allocator, so that malloc can be replaced below
+//
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void *ptr, size_t size);
+void __libc_free(void *ptr);
+}
+#endif
+
+#define TU RealtimeTU
+namespace TU {
+
+// maximum number of frames in a violation's backtrace
+constexpr int BACKTRACE_FRAMES = 32;
+
+//
+// Trivially constructed and destroyed, so that it can be used from the
+// allocator without allocating.
+//
+struct ThreadState {
+    int realtime;   // depth of Realtime::Scope
+    int allowed;    // depth of Realtime::Allow
+    bool reporting; // a violation is being reported
+};
+
+thread_local ThreadState state;
+
+std::atomic<uint64_t> violations;
+
+bool isActive() noexcept {
+    return state.realtime > 0 && state.allowed == 0 && !state.reporting;
+}
+
+void report(char const* what, LockSite const* site) noexcept {
+    // printing and backtrace() may allocate, which must not be reported
+    state.reporting = true;
+
+    auto const count = violations.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (site) {
+        std::fprintf(stderr, "[Realtime] violation #%llu: %s at %s:%d (%s)\n",
+                     (unsigned long long)count, what, site->file, site->line, site->function);
+    } else {
+        std::fprintf(stderr, "[Realtime] violation #%llu: %s\n", (unsigned long long)count, what);
+    }
+
+#ifdef REALTIME_BACKTRACE
+    void* frames[BACKTRACE_FRAMES];
+    auto const depth = backtrace(frames, BACKTRACE_FRAMES);
+    // skip this function
+    backtrace_symbols_fd(frames + 1, depth - 1, STDERR_FILENO);
+#endif
+
+    state.reporting = false;
+}
+
+void* allocate(size_t size, char const* what) noexcept {
+    if (isActive()) {
+        report(what, nullptr);
+    }
+#ifdef __GLIBC__
+    return __libc_malloc(size ? size : 1);
+#else
+    return std::malloc(size ? size : 1);
+#endif
+}
+
+void release(void *ptr) noexcept {
+#ifdef __GLIBC__
+    __libc_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+
+}
+
+namespace Realtime {
+
+Scope::Scope() noexcept {
+    ++TU::state.realtime;
+}
+
+Scope::~Scope() {
+    --TU::state.realtime;
+}
+
+Allow::Allow() noexcept {
+    ++TU::state.allowed;
+}
+
+Allow::~Allow() {
+    --TU::state.allowed;
+}
+
+uint64_t violations() noexcept {
+    return TU::violations.load(std::memory_order_relaxed);
+}
+
+void resetViolations() noexcept {
+    TU::violations.store(0, std::memory_order_relaxed);
+}
+
+void blocked(LockSite const& site) noexcept {
+    if (TU::isActive()) {
+        TU::report("waiting for a lock", &site);
+    }
+}
+
+}
+
+#ifndef TRACKERBOY_SANITIZER
+
+//
+// Replacements for the global allocation functions. The aligned forms are
+// not replaced, and are not checked.
+//
+
+void* operator new(std::size_t size) {
+    if (auto ptr = TU::allocate(size, "operator new")) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    if (auto ptr = TU::allocate(size, "operator new[]")) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::nothrow_t const&) noexcept {
+    return TU::allocate(size, "operator new");
+}
+
+void* operator new[](std::size_t size, std::nothrow_t const&) noexcept {
+    return TU::allocate(size, "operator new[]");
+}
+
+void operator delete(void *ptr) noexcept {
+    TU::release(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    TU::release(ptr);
+}
+
+void operator delete(void *ptr, std::size_t size) noexcept {
+    Q_UNUSED(size)
+    TU::release(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t size) noexcept {
+    Q_UNUSED(size)
+    TU::release(ptr);
+}
+
+void operator delete(void *ptr, std::nothrow_t const&) noexcept {
+    TU::release(ptr);
+}
+
+void operator delete[](void *ptr, std::nothrow_t const&) noexcept {
+    TU::release(ptr);
+}
+
+#ifdef __GLIBC__
+
+//
+// Allocations made by C code and by Qt's containers (which use malloc) are
+// only checked on glibc, where malloc can be replaced by defining it.
+//
+extern "C" {
+
+void* malloc(size_t size) noexcept {
+    if (TU::isActive()) {
+        TU::report("malloc", nullptr);
+    }
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) noexcept {
+    if (TU::isActive()) {
+        TU::report("calloc", nullptr);
+    }
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void *ptr, size_t size) noexcept {
+    if (TU::isActive()) {
+        TU::report("realloc", nullptr);
+    }
+    return __libc_realloc(ptr, size);
+}
+
+}
+
+#endif
+
+#endif
+
+#undef TU
+
+#endif
@@ -0,0 +1,176 @@
+
+#pragma once
+
+#include <QtGlobal>
+
+#include <cstdint>
+
+struct LockSite;
+
+#if defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__)
+#define TRACKERBOY_SANITIZER
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer) || __has_feature(thread_sanitizer) || __has_feature(memory_sanitizer)
+#define TRACKERBOY_SANITIZER
+#endif
+#endif
+
+//
+// Real-time safety checks, enabled with the ENABLE_REALTIME_CHECKS CMake
+// option.
+//
+// Code that must never wait, such as the render thread and the audio
+// callback, marks itself as real-time with a Realtime::Scope. While a thread
+// is real-time, the following are violations:
+//  - heap allocations via operator new (and malloc, calloc and realloc on
+//    glibc)
+//  - waiting for a lock held by another thread
+//
+// Each violation is counted and logged to stderr with a backtrace of the
+// offending call. Only locks taken through Guarded, SharedGuarded and
+// Module are checked, Qt's mutexes cannot be intercepted as they do not go
+// through pthreads. Taking a lock that is free does not wait, and is not a
+// violation. Allocations are not checked in sanitizer builds, as sanitizers
+// replace the allocator themselves.
+//
+// When disabled, Scope and Allow do nothing and violations() is always 0.
+//
+// Ex:
+// void Foo::callback() {
+//     Realtime::Scope realtime;
+//     mItems.push_back(item); // violation, if push_back has to grow
+// }
+//
+namespace Realtime {
+
+#ifdef TRACKERBOY_REALTIME_CHECKS
+
+#ifdef TRACKERBOY_SANITIZER
+constexpr bool CHECKS_ALLOCATIONS = false;
+#else
+constexpr bool CHECKS_ALLOCATIONS = true;
+#endif
+
+//
+// Marks the calling thread as real-time for the lifetime of the scope.
+// Scopes can be nested.
+//
+class Scope {
+
+public:
+    Scope() noexcept;
+    ~Scope();
+
+private:
+    Q_DISABLE_COPY(Scope)
+
+};
+
+//
+// Suspends the checks on the calling thread for the lifetime of the object,
+// for deliberate exceptions (ie stopping the render once the buffer has
+// drained).
+//
+class Allow {
+
+public:
+    Allow() noexcept;
+    ~Allow();
+
+private:
+    Q_DISABLE_COPY(Allow)
+
+};
+
+//
+// Gets the total count of violations from all threads, since startup or the
+// last call to resetViolations().
+//
+uint64_t violations() noexcept;
+
+void resetViolations() noexcept;
+
+//
+// Reports a violation if the calling thread is real-time. Called by the lock
+// wrappers when a lock is held by another thread, before waiting for it.
+//
+void blocked(LockSite const& site) noexcept;
+
+#else
+
+constexpr bool CHECKS_ALLOCATIONS = false;
+
+class Scope {
+
+public:
+    Scope() noexcept {}
+
+};
+
+class Allow {
+
+public:
+    Allow() noexcept {}
+
+};
+
+inline uint64_t violations() noexcept {
+    return 0;
+}
+
+inline void resetViolations() noexcept {
+}
+
+inline void blocked(LockSite const& site) noexcept {
+    Q_UNUSED(site)
+}
+
+#endif
+
+//
+// Locks the mutex, reporting a violation if it has to wait on a real-time
+// thread. Mutex is QMutex or anything with tryLock() and lock().
+//
+template <class Mutex>
+void lock(Mutex &mutex, LockSite const& site) {
+#ifdef TRACKERBOY_REALTIME_CHECKS
+    if (mutex.tryLock()) {
+        return;
+    }
+    blocked(site);
+#else
+    Q_UNUSED(site)
+#endif
+    mutex.lock();
+}
+
+//
+// Same as lock(), for the read and write locks of a QReadWriteLock
+//
+template <class ReadWriteLock>
+void lockForRead(ReadWriteLock &rwlock, LockSite const& site) {
+#ifdef TRACKERBOY_REALTIME_CHECKS
+    if (rwlock.tryLockForRead()) {
+        return;
+    }
+    blocked(site);
+#else
+    Q_UNUSED(site)
+#endif
+    rwlock.lockForRead();
+}
+
+template <class ReadWriteLock>
+void lockForWrite(ReadWriteLock &rwlock, LockSite const& site) {
+#ifdef TRACKERBOY_REALTIME_CHECKS
+    if (rwlock.tryLockForWrite()) {
+        return;
+    }
+    blocked(site);
+#else
+    Q_UNUSED(site)
+#endif
+    rwlock.lockForWrite();
+}
+
+}
@@ -0,0 +1,105 @@
+
+#pragma once
+
+#include <QThread>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+//
+// Publishes a copy of a trivially copyable type from a single writer thread to
+// any number of reader threads, without locking.
+//
+// The writer never waits on readers. A reader that overlaps a write retries
+// its copy, so readers only wait for the duration of a write (a few stores).
+// The value is stored as atomic words so that the overlapping accesses are
+// not data races.
+//
+// Ex:
+// Seqlock<trackerboy::Frame> frame;
+// frame.store(newFrame);    // writer thread
+// auto copy = frame.load(); // any thread
+//
+template <class T>
+class Seqlock {
+
+    static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable");
+
+    using Word = uint32_t;
+    static constexpr size_t WORDS = (sizeof(T) + sizeof(Word) - 1) / sizeof(Word);
+
+public:
+
+    Seqlock() :
+        Seqlock(T{})
+    {
+    }
+
+    explicit Seqlock(T const& value) :
+        mSequence(0),
+        mWords()
+    {
+        store(value);
+    }
+
+    //
+    // Publishes a new value. Only one thread may store at a time.
+    //
+    void store(T const& value) {
+        std::array<Word, WORDS> words{};
+        std::memcpy(words.data(), &value, sizeof(T));
+
+        auto const seq = mSequence.load(std::memory_order_relaxed);
+        // odd sequence: write in progress
+        mSequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; ++i) {
+            mWords[i].store(words[i], std::memory_order_relaxed);
+        }
+        mSequence.store(seq + 2, std::memory_order_release);
+    }
+
+    //
+    // Gets a copy of the last published value.
+    //
+    T load() const {
+        std::array<Word, WORDS> words;
+        for (;;) {
+            auto const seq = mSequence.load(std::memory_order_acquire);
+            if (seq & 1) {
+                // the writer is in the middle of a store
+                QThread::yieldCurrentThread();
+                continue;
+            }
+            for (size_t i = 0; i < WORDS; ++i) {
+                words[i] = mWords[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (mSequence.load(std::memory_order_relaxed) == seq) {
+                break;
+            }
+        }
+
+        T value;
+        std::memcpy(&value, words.data(), sizeof(T));
+        return value;
+    }
+
+    //
+    // Gets the sequence number, which changes with every store. Can be used
+    // to check if a new value was published since the last load.
+    //
+    unsigned sequence() const {
+        return mSequence.load(std::memory_order_acquire);
+    }
+
+private:
+    Q_DISABLE_COPY(Seqlock)
+
+    std::atomic<unsigned> mSequence;
+    std::array<std::atomic<Word>, WORDS> mWords;
+
+};
@@ -0,0 +1,157 @@
+
+#pragma once
+
+#include "utils/LockProfiler.hpp"
+#include "utils/Realtime.hpp"
+
+#include <QReadWriteLock>
+
+#include <utility>
+
+//
+// QReadLocker replacement holding a const reference to a read-locked object.
+// The lock is checked when real-time checks are enabled, see Realtime.hpp
+//
+template <class T>
+class SharedLocked {
+
+    T const &mRef;
+    QReadWriteLock &mLock;
+    LockSite mSite;
+    bool mLocked;
+
+public:
+    SharedLocked(T const &ref, QReadWriteLock &lock, LockSite site) :
+        mRef(ref),
+        mLock(lock),
+        mSite(site),
+        mLocked(false)
+    {
+        relock();
+    }
+
+    ~SharedLocked() {
+        unlock();
+    }
+
+    void unlock() {
+        if (mLocked) {
+            mLocked = false;
+            mLock.unlock();
+        }
+    }
+
+    void relock() {
+        if (!mLocked) {
+            Realtime::lockForRead(mLock, mSite);
+            mLocked = true;
+        }
+    }
+
+    T const* operator->() const {
+        return &mRef;
+    }
+
+private:
+    Q_DISABLE_COPY(SharedLocked)
+
+};
+
+//
+// QWriteLocker replacement holding a reference to a write-locked object.
+// The lock is checked when real-time checks are enabled, see Realtime.hpp
+//
+template <class T>
+class ExclusiveLocked {
+
+    T &mRef;
+    QReadWriteLock &mLock;
+    LockSite mSite;
+    bool mLocked;
+
+public:
+    ExclusiveLocked(T &ref, QReadWriteLock &lock, LockSite site) :
+        mRef(ref),
+        mLock(lock),
+        mSite(site),
+        mLocked(false)
+    {
+        relock();
+    }
+
+    ~ExclusiveLocked() {
+        unlock();
+    }
+
+    void unlock() {
+        if (mLocked) {
+            mLocked = false;
+            mLock.unlock();
+        }
+    }
+
+    void relock() {
+        if (!mLocked) {
+            Realtime::lockForWrite(mLock, mSite);
+            mLocked = true;
+        }
+    }
+
+    T* operator->() const {
+        return &mRef;
+    }
+
+private:
+    Q_DISABLE_COPY(ExclusiveLocked)
+
+};
+
+//
+// Reader/writer variant of Guarded, for read-mostly objects shared between
+// threads. Any number of threads can read the object at the same time, while
+// writers have exclusive access.
+//
+// Ex: VisualizerBuffer
+// SharedGuarded<VisualizerBuffer> buffer;
+// buffer.access()->write(samples, count);        // writer thread
+// buffer.read()->decimate(columns, left, right); // any number of readers
+//
+// Only const member functions of T may be called through read(), and they
+// must not modify the object (ie no mutable caches).
+//
+// A QReadWriteLock costs more to take than a QMutex, and is not seen by
+// LockProfiler, so only use this over Guarded when readers on different
+// threads contend and the "locks" benchmark shows a gain.
+//
+template <class T>
+class SharedGuarded {
+
+public:
+
+    template <typename... Ts>
+    SharedGuarded(Ts&&... args) :
+        mHandle(std::forward<Ts>(args)...),
+        mLock()
+    {
+    }
+
+    //
+    // Returns a handle with shared, read-only access to the contained object
+    // for the lifetime of the handle. Waits for a writer holding access().
+    //
+    SharedLocked<T> read(LockSite site = LockSite::current()) {
+        return { mHandle, mLock, site };
+    }
+
+    //
+    // Returns a handle with exclusive access to the contained object for the
+    // lifetime of the handle. Waits for all readers and writers.
+    //
+    ExclusiveLocked<T> access(LockSite site = LockSite::current()) {
+        return { mHandle, mLock, site };
+    }
+
+private:
+    T mHandle;
+    QReadWriteLock mLock;
+};
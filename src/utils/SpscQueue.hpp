@@ -0,0 +1,79 @@
+
+#pragma once
+
+#include <QtGlobal>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+//
+// Fixed capacity, lock-free queue for passing values from a single producer
+// thread to a single consumer thread. Neither side ever blocks, push fails
+// when the queue is full.
+//
+// Ex:
+// SpscQueue<int, 64> queue;
+// queue.push(1);           // producer thread
+// int value;
+// while (queue.pop(value)) // consumer thread
+//
+template <class T, size_t N>
+class SpscQueue {
+
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "capacity must be a power of two");
+
+public:
+
+    SpscQueue() :
+        mItems(),
+        mHead(0),
+        mTail(0)
+    {
+    }
+
+    //
+    // Adds a value to the back of the queue, returns false if the queue is
+    // full. Producer only.
+    //
+    bool push(T const& value) {
+        auto const tail = mTail.load(std::memory_order_relaxed);
+        if (tail - mHead.load(std::memory_order_acquire) == N) {
+            return false;
+        }
+        mItems[tail & (N - 1)] = value;
+        mTail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    //
+    // Removes the value at the front of the queue, returns false if the
+    // queue is empty. Consumer only.
+    //
+    bool pop(T &value) {
+        auto const head = mHead.load(std::memory_order_relaxed);
+        if (head == mTail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = mItems[head & (N - 1)];
+        mHead.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    //
+    // Determines if the queue is empty. The result is only a snapshot when
+    // called from the producer.
+    //
+    bool isEmpty() const {
+        return mHead.load(std::memory_order_acquire) == mTail.load(std::memory_order_acquire);
+    }
+
+private:
+    Q_DISABLE_COPY(SpscQueue)
+
+    std::array<T, N> mItems;
+    // indices only ever increase, the slot is the index modulo N
+    alignas(64) std::atomic<size_t> mHead;
+    alignas(64) std::atomic<size_t> mTail;
+
+};
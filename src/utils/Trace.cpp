@@ -0,0 +1,337 @@
+
+#include "utils/Trace.hpp"
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#define TU TraceTU
+namespace TU {
+
+using Clock = Trace::Clock;
+
+// events kept per thread, older events are overwritten
+constexpr size_t BUFFER_EVENTS = 1 << 15;
+
+enum class Kind : uint8_t {
+    complete,
+    counter,
+    instant
+};
+
+//
+// An event in a thread's ring buffer. The fields are atomic so that write()
+// can read a slot while the owning thread overwrites it. The slot's sequence
+// is odd while the slot is being written, and is 2 * (index + 1) when it
+// holds the event with the given index.
+//
+struct Slot {
+    std::atomic<uint64_t> sequence;
+    std::atomic<char const*> name;
+    std::atomic<Clock::rep> time;
+    std::atomic<Clock::rep> duration;
+    std::atomic<double> value;
+    std::atomic<Kind> kind;
+};
+
+//
+// A thread that recorded into a buffer before it was reused. Events before
+// end were recorded by this thread.
+//
+struct Owner {
+    int tid;
+    char const* name;
+    uint64_t end;
+};
+
+struct ThreadBuffer {
+
+    ThreadBuffer(int tid) :
+        tid(tid),
+        name(nullptr),
+        inUse(true),
+        previous(),
+        count(0),
+        slots(new Slot[BUFFER_EVENTS]())
+    {
+    }
+
+    void record(Kind kind, char const* eventName, Clock::rep time, Clock::rep duration, double value) {
+        // only the owning thread writes, so count can be read relaxed
+        auto const index = count.load(std::memory_order_relaxed);
+        auto &slot = slots[index % BUFFER_EVENTS];
+        slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.name.store(eventName, std::memory_order_relaxed);
+        slot.time.store(time, std::memory_order_relaxed);
+        slot.duration.store(duration, std::memory_order_relaxed);
+        slot.value.store(value, std::memory_order_relaxed);
+        slot.kind.store(kind, std::memory_order_relaxed);
+        slot.sequence.store(2 * (index + 1), std::memory_order_release);
+        count.store(index + 1, std::memory_order_release);
+    }
+
+    // tid, inUse and previous are guarded by the registry's mutex
+    int tid;
+    std::atomic<char const*> name;
+    // false once the owning thread has exited, the buffer can then be reused
+    bool inUse;
+    // threads that used this buffer before, oldest first, whose events have
+    // not all been overwritten yet
+    std::vector<Owner> previous;
+    std::atomic<uint64_t> count;
+    std::unique_ptr<Slot[]> slots;
+};
+
+//
+// All buffers ever registered. Buffers are never freed so that events from
+// exited threads can still be written.
+//
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    // every thread gets its own tid, even when reusing a buffer
+    int nextTid{1};
+    std::atomic<Clock::rep> startTime{0};
+};
+
+Registry& registry() {
+    static Registry reg;
+    return reg;
+}
+
+//
+// Holds the calling thread's buffer, and releases it for reuse when the
+// thread exits.
+//
+class ThreadBufferRef {
+
+public:
+    ThreadBufferRef() :
+        mBuffer(nullptr)
+    {
+    }
+
+    ~ThreadBufferRef() {
+        if (mBuffer) {
+            auto &reg = registry();
+            std::scoped_lock lock(reg.mutex);
+            mBuffer->inUse = false;
+        }
+    }
+
+    ThreadBuffer& get() {
+        if (mBuffer == nullptr) {
+            auto &reg = registry();
+            std::scoped_lock lock(reg.mutex);
+            auto iter = std::find_if(reg.buffers.begin(), reg.buffers.end(),
+                [](auto const& buffer) { return !buffer->inUse; });
+            if (iter == reg.buffers.end()) {
+                reg.buffers.push_back(std::make_unique<ThreadBuffer>(reg.nextTid++));
+                mBuffer = reg.buffers.back().get();
+            } else {
+                mBuffer = iter->get();
+                reuse(*mBuffer, reg.nextTid++);
+            }
+        }
+        return *mBuffer;
+    }
+
+private:
+
+    //
+    // Takes over a buffer from an exited thread. Its events are kept under
+    // the exited thread's tid and name, so that write() does not show them
+    // as ours.
+    //
+    static void reuse(ThreadBuffer &buffer, int tid) {
+        // the previous owner has exited, so nothing else writes to the buffer
+        auto const count = buffer.count.load(std::memory_order_relaxed);
+        auto &previous = buffer.previous;
+        previous.erase(
+            std::remove_if(previous.begin(), previous.end(),
+                [count](Owner const& owner) { return owner.end + BUFFER_EVENTS <= count; }),
+            previous.end()
+        );
+        if (count > 0 && (previous.empty() || previous.back().end != count)) {
+            previous.push_back({ buffer.tid, buffer.name.load(std::memory_order_relaxed), count });
+        }
+
+        buffer.tid = tid;
+        buffer.inUse = true;
+        buffer.name.store(nullptr, std::memory_order_relaxed);
+    }
+
+    ThreadBuffer *mBuffer;
+
+};
+
+thread_local ThreadBufferRef threadBuffer;
+
+Clock::rep timeOf(Clock::time_point time) {
+    return time.time_since_epoch().count();
+}
+
+// Chrome trace timestamps are in microseconds
+double toMicroseconds(Clock::rep ticks) {
+    return std::chrono::duration<double, std::micro>(Clock::duration(ticks)).count();
+}
+
+QJsonObject makeEvent(char const* phase, int tid, QString const& name) {
+    return {
+        { QStringLiteral("ph"), QString::fromLatin1(phase) },
+        { QStringLiteral("pid"), 1 },
+        { QStringLiteral("tid"), tid },
+        { QStringLiteral("name"), name }
+    };
+}
+
+}
+
+namespace Trace {
+
+namespace detail {
+
+std::atomic_bool enabled{false};
+
+}
+
+void start() {
+    auto &reg = TU::registry();
+    reg.startTime.store(TU::timeOf(Clock::now()), std::memory_order_relaxed);
+    detail::enabled.store(true, std::memory_order_release);
+}
+
+void stop() {
+    detail::enabled.store(false, std::memory_order_release);
+}
+
+bool write(QString const& filename) {
+    auto &reg = TU::registry();
+    auto const startTime = reg.startTime.load(std::memory_order_relaxed);
+
+    // buffers are never freed, so only their owners need to be copied under
+    // the lock. Events recorded after the copy are not written, as they may
+    // belong to a thread that reused the buffer since.
+    struct Snapshot {
+        TU::ThreadBuffer *buffer;
+        uint64_t count;
+        std::vector<TU::Owner> owners;
+    };
+    std::vector<Snapshot> snapshots;
+    {
+        std::scoped_lock lock(reg.mutex);
+        for (auto const& buffer : reg.buffers) {
+            auto const count = buffer->count.load(std::memory_order_acquire);
+            if (count == 0) {
+                continue;
+            }
+            auto owners = buffer->previous;
+            owners.push_back({ buffer->tid, buffer->name.load(std::memory_order_relaxed), count });
+            snapshots.push_back({ buffer.get(), count, std::move(owners) });
+        }
+    }
+
+    QJsonArray events;
+    for (auto const& snapshot : snapshots) {
+        auto const buffer = snapshot.buffer;
+        auto const count = snapshot.count;
+        auto const first = count > TU::BUFFER_EVENTS ? count - TU::BUFFER_EVENTS : 0;
+
+        for (auto const& owner : snapshot.owners) {
+            if (owner.end <= first) {
+                // all of this thread's events were overwritten
+                continue;
+            }
+            auto threadEvent = TU::makeEvent("M", owner.tid, QStringLiteral("thread_name"));
+            threadEvent[QStringLiteral("args")] = QJsonObject{
+                { QStringLiteral("name"), owner.name ? QString::fromUtf8(owner.name) : QStringLiteral("Thread %1").arg(owner.tid) }
+            };
+            events.append(threadEvent);
+        }
+
+        auto owner = snapshot.owners.cbegin();
+        for (auto index = first; index < count; ++index) {
+            while (owner->end <= index) {
+                ++owner;
+            }
+            auto const tid = owner->tid;
+            auto const &slot = buffer->slots[index % TU::BUFFER_EVENTS];
+            auto const sequence = slot.sequence.load(std::memory_order_acquire);
+            if (sequence != 2 * (index + 1)) {
+                // overwritten since count was read
+                continue;
+            }
+            auto const name = slot.name.load(std::memory_order_relaxed);
+            auto const time = slot.time.load(std::memory_order_relaxed);
+            auto const duration = slot.duration.load(std::memory_order_relaxed);
+            auto const value = slot.value.load(std::memory_order_relaxed);
+            auto const kind = slot.kind.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) != sequence) {
+                continue;
+            }
+            if (time < startTime) {
+                // recorded before the last start()
+                continue;
+            }
+
+            QJsonObject event;
+            switch (kind) {
+                case TU::Kind::complete:
+                    event = TU::makeEvent("X", tid, QString::fromUtf8(name));
+                    event[QStringLiteral("dur")] = TU::toMicroseconds(duration);
+                    break;
+                case TU::Kind::counter:
+                    event = TU::makeEvent("C", tid, QString::fromUtf8(name));
+                    event[QStringLiteral("args")] = QJsonObject{ { QStringLiteral("value"), value } };
+                    break;
+                case TU::Kind::instant:
+                    event = TU::makeEvent("i", tid, QString::fromUtf8(name));
+                    event[QStringLiteral("s")] = QStringLiteral("t");
+                    break;
+            }
+            event[QStringLiteral("ts")] = TU::toMicroseconds(time - startTime);
+            events.append(event);
+        }
+    }
+
+    QJsonObject root {
+        { QStringLiteral("traceEvents"), events },
+        { QStringLiteral("displayTimeUnit"), QStringLiteral("ms") }
+    };
+
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    auto const json = QJsonDocument(root).toJson(QJsonDocument::Compact);
+    return file.write(json) == json.size();
+}
+
+void setThreadName(char const* name) {
+    TU::threadBuffer.get().name.store(name, std::memory_order_relaxed);
+}
+
+void complete(char const* name, Clock::time_point begin, Clock::time_point end) {
+    TU::threadBuffer.get().record(TU::Kind::complete, name, TU::timeOf(begin), (end - begin).count(), 0.0);
+}
+
+void counter(char const* name, double value) {
+    TU::threadBuffer.get().record(TU::Kind::counter, name, TU::timeOf(Clock::now()), 0, value);
+}
+
+void instant(char const* name) {
+    TU::threadBuffer.get().record(TU::Kind::instant, name, TU::timeOf(Clock::now()), 0, 0.0);
+}
+
+}
+
+#undef TU
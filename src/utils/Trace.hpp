@@ -0,0 +1,142 @@
+
+#pragma once
+
+#include <QString>
+
+#include <atomic>
+#include <chrono>
+
+//
+// Low overhead event tracing, for correlating what each thread was doing at
+// a given moment (ie what the GUI was doing when the audio underran).
+//
+// Events are recorded into a lock-free ring buffer owned by the calling
+// thread, so recording never waits on another thread. When tracing is
+// stopped, recording an event is a single relaxed atomic load. The recorded
+// events can be written in the Chrome trace event format, which can be viewed
+// in chrome://tracing or https://ui.perfetto.dev.
+//
+// The first event recorded by a thread registers a buffer for it, which
+// allocates. Realtime threads should call setThreadName before they start
+// doing realtime work, so that this does not happen mid-render. Buffers are
+// reused by later threads once their thread exits, the exited thread's events
+// are still written under its own name.
+//
+// Event and thread names must be string literals (or otherwise outlive the
+// trace), as only the pointer is recorded.
+//
+// Ex:
+// void Foo::bar() {
+//     TRACE_ZONE("Foo::bar");
+//     ...
+//     TRACE_COUNTER("Foo items", mItems.size());
+// }
+//
+namespace Trace {
+
+using Clock = std::chrono::steady_clock;
+
+namespace detail {
+
+extern std::atomic_bool enabled;
+
+}
+
+//
+// Returns true if tracing was started and events are being recorded.
+//
+inline bool isEnabled() noexcept {
+    return detail::enabled.load(std::memory_order_relaxed);
+}
+
+//
+// Starts recording events. Only events recorded after this call will be
+// written by write().
+//
+void start();
+
+//
+// Stops recording events. Recorded events are kept until the next start().
+//
+void stop();
+
+//
+// Writes the events recorded since the last start() as a Chrome trace event
+// JSON file. Only the most recent events are kept for each thread, older
+// events are overwritten when a thread's buffer is full. Returns false if the
+// file could not be written.
+//
+bool write(QString const& filename);
+
+//
+// Names the calling thread in the trace. Only the pointer is kept. Registers
+// the thread's buffer even if tracing is stopped.
+//
+void setThreadName(char const* name);
+
+//
+// Records a span of time on the calling thread. Use Zone or TRACE_ZONE
+// instead of calling this directly.
+//
+void complete(char const* name, Clock::time_point begin, Clock::time_point end);
+
+//
+// Records the value of a counter, shown as a graph in the trace viewer.
+//
+void counter(char const* name, double value);
+
+//
+// Records a moment in time on the calling thread, such as an underrun.
+//
+void instant(char const* name);
+
+//
+// Records the time between construction and destruction as a span, if
+// tracing is enabled at construction.
+//
+class Zone {
+
+public:
+    explicit Zone(char const* name) noexcept :
+        mName(isEnabled() ? name : nullptr),
+        mBegin(mName ? Clock::now() : Clock::time_point())
+    {
+    }
+
+    ~Zone() {
+        if (mName) {
+            complete(mName, mBegin, Clock::now());
+        }
+    }
+
+private:
+    Q_DISABLE_COPY(Zone)
+
+    char const* mName;
+    Clock::time_point mBegin;
+
+};
+
+}
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+
+//
+// Traces the remainder of the enclosing scope
+//
+#define TRACE_ZONE(name) Trace::Zone TRACE_CONCAT(traceZone, __LINE__)(name)
+
+#define TRACE_COUNTER(name, value) \
+    do { if (Trace::isEnabled()) Trace::counter(name, (double)(value)); } while (false)
+
+#define TRACE_INSTANT(name) \
+    do { if (Trace::isEnabled()) Trace::instant(name); } while (false)
+
+//
+// Names the calling thread, for threads not created by us (ie the audio
+// callback). Does nothing when tracing is stopped, so that the thread's
+// buffer is not allocated unless needed.
+//
+#define TRACE_THREAD(name) \
+    do { if (Trace::isEnabled()) Trace::setThreadName(name); } while (false)
@@ -12,6 +12,8 @@
 #include <QVBoxLayout>
 #include <QtDebug>
 
+#include <algorithm>
+
 #define TU PatternEditorTU
 namespace TU {
 
@@ -106,7 +108,9 @@ PatternEditor::PatternEditor(
     mKeyRepeat(true),
     mClipboard(),
     mInstrument(),
-    mEditMenu(nullptr)
+    mEditMenu(nullptr),
+    mTimeline(nullptr),
+    mRecordQuantize(1)
 {
     setFrameStyle(QFrame::StyledPanel);
     setFocusPolicy(Qt::StrongFocus);
@@ -429,6 +433,18 @@ void PatternEditor::setEditStep(int step) {
     mEditStep = step;
 }
 
+void PatternEditor::setTimeline(PlaybackTimeline const *timeline) {
+    mTimeline = timeline;
+}
+
+void PatternEditor::setRecordQuantize(int rows) {
+    mRecordQuantize = std::max(1, rows);
+}
+
+std::optional<uint8_t> PatternEditor::instrument() const {
+    return mInstrument;
+}
+
 void PatternEditor::setInstrument(int id) {
     if (id == -1) {
         mInstrument.reset();
@@ -560,18 +576,35 @@ void PatternEditor::setCursorFromHScroll(int value) {
 
 }
 
-void PatternEditor::midiNoteOn(int note) {
+void PatternEditor::midiNoteOn(int note, bool previewed, Clock::time_point time) {
     if (mModel.isRecording()) {
-        mModel.setNote((uint8_t)note, mInstrument);
-        stepDown();
+        // when following playback, the cursor is on the row being rendered
+        // which is ahead of the row being heard. Use the timeline to record
+        // the note where the user heard it.
+        std::optional<PlaybackTimeline::Position> pos;
+        if (mTimeline && mModel.isPlaying() && mModel.isFollowing()) {
+            pos = mTimeline->position(time);
+        }
+
+        if (pos) {
+            auto const quantized = PlaybackTimeline::quantize(*pos, mRecordQuantize);
+            mModel.recordNote(quantized.pattern, quantized.row, (uint8_t)note, mInstrument);
+        } else {
+            mModel.setNote((uint8_t)note, mInstrument);
+            stepDown();
+        }
     }
 
-    emit previewNote(note, mModel.cursorTrack(), mInstrument.value_or(-1));
+    if (!previewed) {
+        emit previewNote(note, mModel.cursorTrack(), mInstrument.value_or(-1));
+    }
 
 }
 
-void PatternEditor::midiNoteOff() {
-    emit stopNotePreview();
+void PatternEditor::midiNoteOff(bool previewed) {
+    if (!previewed) {
+        emit stopNotePreview();
+    }
 }
 
 #undef TU
@@ -1,6 +1,7 @@
 
 #pragma once
 
+#include "audio/PlaybackTimeline.hpp"
 #include "clipboard/PatternClipboard.hpp"
 #include "config/data/Palette.hpp"
 #include "config/data/PianoInput.hpp"
@@ -42,12 +43,27 @@ public:
 
     void setPageStep(int pageStep);
 
-    virtual void midiNoteOn(int note) override;
+    virtual void midiNoteOn(int note, bool previewed, Clock::time_point time) override;
 
-    virtual void midiNoteOff() override;
+    virtual void midiNoteOff(bool previewed) override;
 
     void setEditStep(int step);
 
+    //
+    // Sets the timeline used to record MIDI notes at the row that was heard
+    // when the note was played, instead of the cursor row. Only used when
+    // following playback.
+    //
+    void setTimeline(PlaybackTimeline const *timeline);
+
+    //
+    // Recorded MIDI notes are rounded to the nearest multiple of this many
+    // rows. Only applies when recording via the timeline.
+    //
+    void setRecordQuantize(int rows);
+
+    std::optional<uint8_t> instrument() const;
+
     void setInstrument(int id);
 
     void setKeyRepeat(bool repeat);
@@ -139,5 +155,8 @@ private:
 
     QMenu *mEditMenu;
 
+    PlaybackTimeline const *mTimeline;
+    int mRecordQuantize;
+
 
 };
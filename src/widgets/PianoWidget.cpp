@@ -122,18 +122,33 @@ void PianoWidget::release() {
     emit keyUp();
 }
 
-void PianoWidget::midiNoteOn(int note) {
+void PianoWidget::midiNoteOn(int note, bool previewed, Clock::time_point time) {
+    Q_UNUSED(time)
     if (isEnabled()) {
-        play(note);
+        if (previewed) {
+            setKeyDown(true, note);
+        } else {
+            play(note);
+        }
     }
 }
 
-void PianoWidget::midiNoteOff() {
+void PianoWidget::midiNoteOff(bool previewed) {
     if (isEnabled()) {
-        release();
+        if (previewed) {
+            setKeyDown(false, mNote);
+        } else {
+            release();
+        }
     }
 }
 
+void PianoWidget::setKeyDown(bool down, int note) {
+    mIsKeyDown = down;
+    mNote = note;
+    update();
+}
+
 void PianoWidget::focusOutEvent(QFocusEvent *evt) {
     Q_UNUSED(evt);
 
@@ -25,9 +25,9 @@ public:
     void play(int note);
     void release();
 
-    virtual void midiNoteOn(int note) override;
+    virtual void midiNoteOn(int note, bool previewed, Clock::time_point time) override;
 
-    virtual void midiNoteOff() override;
+    virtual void midiNoteOff(bool previewed) override;
 
 signals:
     void keyDown(int note);
@@ -60,6 +60,11 @@ private:
     
     int getNoteFromMouse(QPoint mousePos);
 
+    //
+    // Shows the key as pressed or released without emitting any signals
+    //
+    void setKeyDown(bool down, int note);
+
     bool mIsKeyDown;
     int mNote;
 
@@ -16,6 +16,8 @@ Sidebar::Sidebar(
 ) :
     QWidget(parent),
     mScope(new AudioScope),
+    mPeakMeter(new PeakMeter),
+    mSpectrum(new AudioSpectrum),
     mOrderEditor(new OrderEditor(patternModel)),
     mSongEditor(new SongEditor(songModel)),
     mSongChooser(new QComboBox)
@@ -23,6 +25,8 @@ Sidebar::Sidebar(
 
     auto layout = new QVBoxLayout;
     layout->addWidget(mScope);
+    layout->addWidget(mPeakMeter);
+    layout->addWidget(mSpectrum);
 
     auto groupbox = new QGroupBox(tr("Song"));
     auto groupLayout = new QVBoxLayout;
@@ -76,6 +80,14 @@ AudioScope* Sidebar::scope() {
     return mScope;
 }
 
+PeakMeter* Sidebar::peakMeter() {
+    return mPeakMeter;
+}
+
+AudioSpectrum* Sidebar::spectrum() {
+    return mSpectrum;
+}
+
 OrderEditor* Sidebar::orderEditor() {
     return mOrderEditor;
 }
@@ -5,8 +5,10 @@
 #include "model/SongModel.hpp"
 #include "model/SongListModel.hpp"
 #include "widgets/sidebar/AudioScope.hpp"
+#include "widgets/sidebar/AudioSpectrum.hpp"
 #include "widgets/sidebar/OrderEditor.hpp"
 #include "widgets/sidebar/SongEditor.hpp"
+#include "widgets/visualizers/PeakMeter.hpp"
 
 #include <QAction>
 #include <QComboBox>
@@ -14,7 +16,7 @@
 
 //
 // Composite widget for the tracker sidebar. This sits beside the pattern editor
-// and contains the order editor, song chooser, song settings editor, and the visualizer.
+// and contains the order editor, song chooser, song settings editor, and the visualizers.
 //
 class Sidebar : public QWidget {
 
@@ -32,6 +34,10 @@ public:
 
     AudioScope* scope();
 
+    PeakMeter* peakMeter();
+
+    AudioSpectrum* spectrum();
+
     OrderEditor* orderEditor();
 
     SongEditor* songEditor();
@@ -59,6 +65,8 @@ private:
     void updateActions();
 
     AudioScope *mScope;
+    PeakMeter *mPeakMeter;
+    AudioSpectrum *mSpectrum;
     OrderEditor *mOrderEditor;
     SongEditor *mSongEditor;
     QComboBox *mSongChooser;
@@ -5,6 +5,7 @@
 #include "utils/IconLocator.hpp"
 
 #include <QBoxLayout>
+#include <QMessageBox>
 #include <QToolBar>
 #include <QtDebug>
 
@@ -136,6 +137,20 @@ void TableView::add() {
 }
 
 void TableView::remove() {
+    auto const usage = mModel.usageCount(mSelectedItem);
+    if (usage) {
+        auto const result = QMessageBox::warning(
+            this,
+            tr("Remove"),
+            tr("%1 is used in %n row(s). Remove it anyway?", nullptr, usage).arg(mModel.name(mSelectedItem)),
+            QMessageBox::Yes | QMessageBox::No,
+            QMessageBox::No
+        );
+        if (result != QMessageBox::Yes) {
+            return;
+        }
+    }
+
     mModel.remove(mSelectedItem);
     if (mSelectedItem == mModel.rowCount()) {
         --mSelectedItem;
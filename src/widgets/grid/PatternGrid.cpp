@@ -1,5 +1,6 @@
 
 #include "widgets/grid/PatternGrid.hpp"
+#include "utils/Trace.hpp"
 
 #include "trackerboy/note.hpp"
 
@@ -7,9 +8,11 @@
 #include <QDrag>
 #include <QMimeData>
 #include <QPainter>
+#include <QRegion>
 #include <QtDebug>
 
 #include <algorithm>
+#include <cmath>
 
 
 // Philisophy note
@@ -45,6 +48,12 @@ PatternGrid::PatternGrid(
     mSelecting(false),
     mVisibleRows(0),
     mEditorFocus(false),
+    mTextLayer(),
+    mTextLayerValid(false),
+    mTextLayerPattern(0),
+    mTextLayerRow(0),
+    mDirtyRows(),
+    mSelectionRect(),
     mMousePos(),
     mSelectionStart(),
     mSelectionEnd(),
@@ -61,8 +70,10 @@ PatternGrid::PatternGrid(
 
     connect(&model, &PatternModel::cursorChanged, this, &PatternGrid::updateCursor);
     // these changes require a full redraw
-    connect(&model, &PatternModel::invalidated, this, &PatternGrid::updateAll);
-    connect(&model, &PatternModel::selectionChanged, this, &PatternGrid::updateAll);
+    connect(&model, &PatternModel::invalidated, this, &PatternGrid::invalidateText);
+    // these only redraw the rows affected
+    connect(&model, &PatternModel::rowsInvalidated, this, &PatternGrid::invalidateRows);
+    connect(&model, &PatternModel::selectionChanged, this, &PatternGrid::updateSelection);
     // these we only need to redraw the cursor row
     connect(&model, &PatternModel::recordingChanged, this, &PatternGrid::updateCursorRow);
     
@@ -78,7 +89,7 @@ PatternGrid::PatternGrid(
                 mLayout.setEffectsVisible((int)i, counts[i]);
             }
             // redraw everything
-            update();
+            invalidateText();
             mHeader.update();
 
         });
@@ -100,13 +111,13 @@ void PatternGrid::setColors(Palette const& colors) {
     setPalette(pal);
 
     // new colors, redraw everything
-    update();
+    invalidateText();
 }
 
 void PatternGrid::setShowFlats(bool showFlats) {
     if (showFlats != mPainter.flats()) {
         mPainter.setFlats(showFlats);
-        update();
+        invalidateText();
     }
 }
 
@@ -120,7 +131,7 @@ void PatternGrid::setShowShadow(bool shadow) {
 void PatternGrid::setRownoHex(bool hex) {
     if (hex != mLayout.rownoHex()) {
         mLayout.setRownoHex(hex);
-        update();
+        invalidateText();
     }
 }
 
@@ -186,6 +197,7 @@ void PatternGrid::dropEvent(QDropEvent *evt) {
 
 void PatternGrid::paintEvent(QPaintEvent *evt) {
     Q_UNUSED(evt)
+    TRACE_ZONE("PatternGrid::paintEvent");
 
     QPainter painter(this);
 
@@ -241,64 +253,17 @@ void PatternGrid::paintEvent(QPaintEvent *evt) {
     }
 
     // [4] selection
-    if (mModel.hasSelection()) {
-        auto selection = mModel.selection();
-        selection.translate(-cursor.row + centerRow);
-        auto rect = mLayout.selectionRectangle(selection);
-        mPainter.drawSelection(painter, rect);
+    mSelectionRect = selectionRect();
+    if (!mSelectionRect.isEmpty()) {
+        mPainter.drawSelection(painter, mSelectionRect);
     }
 
     // [5] cursor
     mPainter.drawCursor(painter, mLayout, PatternCursor(centerRow, cursor.column, cursor.track));
 
     // [6] text
-    {
-        int rowYpos = 0;
-        int rowsToDraw = mVisibleRows;
-        int relativeRowIndex = cursor.row - centerRow;
-
-        if (relativeRowIndex < 0) {
-            // a negative row index means we draw from the previous pattern
-            if (patternPrev) {
-                int rowno;
-                int rowIndexToPrev = relativeRowIndex + rowsInPrevious;
-                if (rowIndexToPrev < 0) {
-                    // clamp
-                    rowYpos += -rowIndexToPrev * rowHeight;
-                    rowno = 0;
-                } else {
-                    rowno = rowIndexToPrev;
-                }
-                painter.setOpacity(0.5);
-                rowYpos = mPainter.drawPattern(painter, mLayout, *patternPrev, rowno, rowsInPrevious - 1, rowYpos);
-                painter.setOpacity(1.0);
-            } else {
-                // previews disabled or we don't have a previous pattern, just skip these rows
-                rowYpos += -relativeRowIndex * rowHeight;
-            }
-
-            rowsToDraw += relativeRowIndex;
-            relativeRowIndex = 0;
-        }
-
-        // draw the current pattern
-        int rowEnd = relativeRowIndex + rowsToDraw;
-        if (rowEnd >= rowsInCurrent) {
-            rowEnd = rowsInCurrent - 1;
-        }
-        rowYpos = mPainter.drawPattern(painter, mLayout, patternCurr, relativeRowIndex, rowEnd, rowYpos);
-        rowsToDraw -= rowEnd - relativeRowIndex;
-
-        if (rowsToDraw > 0 && patternNext) {
-            // we have extra rows and a next pattern, draw it
-            if (rowsToDraw > rowsInNext) {
-                rowsToDraw = rowsInNext;
-            }
-            painter.setOpacity(0.5);
-            mPainter.drawPattern(painter, mLayout, *patternNext, 0, rowsToDraw - 1, rowYpos);
-            painter.setOpacity(1.0);
-        }
-    }
+    updateTextLayer();
+    painter.drawPixmap(0, 0, mTextLayer);
 
     // [7] lines
     mPainter.drawLines(painter, mLayout, h);
@@ -335,7 +300,9 @@ void PatternGrid::resizeEvent(QResizeEvent *evt) {
     if (newSize.height() != oldSize.height()) {
         mVisibleRows = mPainter.calculateRowsAvailable(newSize.height());
         calculateTrackerRow();
-        
+        // the center row moved, so all rows have shifted
+        mTextLayerValid = false;
+
     }
 
 }
@@ -462,7 +429,7 @@ void PatternGrid::mouseReleaseEvent(QMouseEvent *evt) {
 
 void PatternGrid::updateCursor(PatternModel::CursorChangeFlags flags) {
 
-    if (flags | (PatternModel::CursorRowChanged | PatternModel::CursorTrackChanged)) {
+    if (flags & (PatternModel::CursorRowChanged | PatternModel::CursorTrackChanged)) {
         updateAll();
     } else {
         updateCursorRow();
@@ -480,6 +447,197 @@ void PatternGrid::updateAll() {
     update();
 }
 
+void PatternGrid::invalidateText() {
+    mTextLayerValid = false;
+    updateAll();
+}
+
+void PatternGrid::invalidateRows(int pattern, int rowStart, int rowEnd, int trackStart, int trackEnd) {
+    // convert to a row index relative to the current pattern
+    auto const cursorPattern = mModel.cursorPattern();
+    int offset;
+    if (pattern == cursorPattern) {
+        offset = 0;
+    } else if (pattern == cursorPattern - 1) {
+        auto patternPrev = mModel.previousPattern();
+        if (!patternPrev) {
+            return;
+        }
+        offset = -patternPrev->totalRows();
+    } else if (pattern == cursorPattern + 1) {
+        offset = mModel.currentPattern().totalRows();
+    } else {
+        return;
+    }
+
+    auto const centerRow = mVisibleRows / 2;
+
+    // mark the rows dirty in the layer, which may have been painted for a
+    // different cursor row than the current one
+    if (mTextLayerValid && mTextLayerPattern == cursorPattern) {
+        auto const layerStart = std::max(0, rowStart + offset - mTextLayerRow + centerRow);
+        auto const layerEnd = std::min(mVisibleRows - 1, rowEnd + offset - mTextLayerRow + centerRow);
+        for (int row = layerStart; row <= layerEnd; ++row) {
+            mDirtyRows[row] = true;
+        }
+    } else {
+        mTextLayerValid = false;
+    }
+
+    // now redraw the region on the widget
+    auto const cursorRow = mModel.cursorRow();
+    auto const visibleStart = std::max(0, rowStart + offset - cursorRow + centerRow);
+    auto const visibleEnd = std::min(mVisibleRows - 1, rowEnd + offset - cursorRow + centerRow);
+    if (visibleStart > visibleEnd) {
+        return;
+    }
+    auto const rowHeight = mPainter.cellHeight();
+    auto const x1 = mLayout.trackToX(trackStart);
+    auto const x2 = mLayout.trackToX(trackEnd) + mLayout.trackWidth(trackEnd);
+    update(x1, visibleStart * rowHeight, x2 - x1, (visibleEnd - visibleStart + 1) * rowHeight);
+}
+
+void PatternGrid::updateSelection() {
+    auto const rect = selectionRect();
+    update(QRegion(mSelectionRect).xored(QRegion(rect)));
+}
+
+QRect PatternGrid::selectionRect() const {
+    if (!mModel.hasSelection()) {
+        return {};
+    }
+    auto selection = mModel.selection();
+    selection.translate(mVisibleRows / 2 - mModel.cursorRow());
+    return mLayout.selectionRectangle(selection);
+}
+
+void PatternGrid::updateTextLayer() {
+    auto const dpr = devicePixelRatioF();
+    auto const pixelSize = size() * dpr;
+    if (mTextLayer.size() != pixelSize || mTextLayer.devicePixelRatio() != dpr) {
+        mTextLayer = QPixmap(pixelSize);
+        mTextLayer.setDevicePixelRatio(dpr);
+        mTextLayerValid = false;
+    }
+    if ((int)mDirtyRows.size() != mVisibleRows) {
+        mDirtyRows.assign(mVisibleRows, false);
+        mTextLayerValid = false;
+    }
+
+    auto const rowHeight = mPainter.cellHeight();
+    auto const cursorPattern = mModel.cursorPattern();
+    auto const cursorRow = mModel.cursorRow();
+    auto const scroll = cursorRow - mTextLayerRow;
+
+    // the layer can only be scrolled within the same pattern (rows from the
+    // previous or next patterns are painted translucent), and by a whole
+    // number of pixels
+    auto const rowPixels = rowHeight * dpr;
+    bool const canScroll = mTextLayerValid &&
+                           cursorPattern == mTextLayerPattern &&
+                           std::abs(scroll) < mVisibleRows &&
+                           rowPixels == std::floor(rowPixels);
+
+    auto const hasDirty = std::find(mDirtyRows.begin(), mDirtyRows.end(), true) != mDirtyRows.end();
+    if (canScroll && scroll == 0 && !hasDirty) {
+        return; // up to date
+    }
+
+    if (canScroll && scroll != 0) {
+        // shift the existing rows (this must be done before painting), then
+        // clear and paint the rows that scrolled in
+        mTextLayer.scroll(0, (int)(-scroll * rowPixels), mTextLayer.rect());
+        // dirty rows move with the layer
+        if (scroll > 0) {
+            std::copy(mDirtyRows.begin() + scroll, mDirtyRows.end(), mDirtyRows.begin());
+            std::fill(mDirtyRows.end() - scroll, mDirtyRows.end(), false);
+        } else {
+            std::copy_backward(mDirtyRows.begin(), mDirtyRows.end() + scroll, mDirtyRows.end());
+            std::fill(mDirtyRows.begin(), mDirtyRows.begin() - scroll, false);
+        }
+    }
+
+    QPainter painter(&mTextLayer);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    if (canScroll) {
+        // the rows that scrolled in are repainted along with the dirty ones
+        if (scroll > 0) {
+            std::fill(mDirtyRows.end() - scroll, mDirtyRows.end(), true);
+        } else if (scroll < 0) {
+            std::fill(mDirtyRows.begin(), mDirtyRows.begin() - scroll, true);
+        }
+
+        // clear and paint each run of dirty rows
+        int row = 0;
+        while (row < mVisibleRows) {
+            if (!mDirtyRows[row]) {
+                ++row;
+                continue;
+            }
+            auto const rowStart = row;
+            while (row < mVisibleRows && mDirtyRows[row]) {
+                ++row;
+            }
+            auto const rowEnd = row - 1;
+            painter.setCompositionMode(QPainter::CompositionMode_Source);
+            painter.fillRect(0, rowStart * rowHeight, width(), (rowEnd - rowStart + 1) * rowHeight, Qt::transparent);
+            painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+            drawText(painter, rowStart, rowEnd);
+        }
+    } else {
+        painter.fillRect(rect(), Qt::transparent);
+        painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+        drawText(painter, 0, mVisibleRows - 1);
+    }
+    std::fill(mDirtyRows.begin(), mDirtyRows.end(), false);
+
+    mTextLayerValid = true;
+    mTextLayerPattern = cursorPattern;
+    mTextLayerRow = cursorRow;
+}
+
+void PatternGrid::drawText(QPainter &painter, int rowStart, int rowEnd) {
+    auto const rowHeight = mPainter.cellHeight();
+    auto patternPrev = mModel.previousPattern();
+    auto const& patternCurr = mModel.currentPattern();
+    auto patternNext = mModel.nextPattern();
+    int const rowsInPrevious = patternPrev ? patternPrev->totalRows() : 0;
+    int const rowsInCurrent = patternCurr.totalRows();
+    int const rowsInNext = patternNext ? patternNext->totalRows() : 0;
+
+    // row index, relative to the current pattern, of the top visible row.
+    // Negative indices are rows in the previous pattern and indices past the
+    // current pattern are rows in the next one.
+    int const base = mModel.cursorRow() - mVisibleRows / 2;
+    int const first = base + rowStart;
+    int const last = base + rowEnd;
+
+    // draws the rows [start, end] (relative indices) of the given pattern,
+    // whose first row has the relative index offset
+    auto drawSegment = [&](trackerboy::Pattern const& pattern, int offset, int rows, bool preview) {
+        auto const start = std::max(first, offset);
+        auto const end = std::min(last, offset + rows - 1);
+        if (start > end) {
+            return;
+        }
+        if (preview) {
+            painter.setOpacity(0.5);
+        }
+        mPainter.drawPattern(painter, mLayout, pattern, start - offset, end - offset, (start - base) * rowHeight);
+        if (preview) {
+            painter.setOpacity(1.0);
+        }
+    };
+
+    if (patternPrev) {
+        drawSegment(*patternPrev, -rowsInPrevious, rowsInPrevious, true);
+    }
+    drawSegment(patternCurr, 0, rowsInCurrent, false);
+    if (patternNext) {
+        drawSegment(*patternNext, rowsInCurrent, rowsInNext, true);
+    }
+}
+
 void PatternGrid::setPlaying(bool playing) {
     if (!playing && mTrackerRow) {
         // this just hides the player row if it was set
@@ -490,18 +648,19 @@ void PatternGrid::setPlaying(bool playing) {
 
 void PatternGrid::setFirstHighlight(int highlight) {
     mPainter.setFirstHighlight(highlight);
-    update();
+    invalidateText();
 }
 
 void PatternGrid::setSecondHighlight(int highlight) {
     mPainter.setSecondHighlight(highlight);
-    update();
+    invalidateText();
 }
 
 void PatternGrid::fontChanged() {
 
     mVisibleRows = mPainter.calculateRowsAvailable(height());
     mLayout.setCellSize(mPainter.cellWidth(), mPainter.cellHeight());
+    invalidateText();
     //auto const rownoWidth = mPainter.rownoWidth();
     //auto const trackWidth = mPainter.trackWidth();
     //mHeader.setWidths(rownoWidth, trackWidth);
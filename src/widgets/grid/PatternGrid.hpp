@@ -13,11 +13,13 @@
 
 #include <QWidget>
 #include <QPaintEvent>
+#include <QPixmap>
 #include <QString>
 #include <QRect>
 #include <QSize>
 
 #include <optional>
+#include <vector>
 
 
 class PatternGrid : public QWidget {
@@ -90,6 +92,42 @@ private:
     
     void updateCursorRow();
     void updateAll();
+
+    //
+    // Marks the text layer for a full repaint and redraws the grid. Call this
+    // when pattern data or anything affecting its appearance changes.
+    //
+    void invalidateText();
+
+    //
+    // Marks the visible rows in the given region of a pattern as dirty, and
+    // redraws just those rows.
+    //
+    void invalidateRows(int pattern, int rowStart, int rowEnd, int trackStart, int trackEnd);
+
+    //
+    // Redraws the area covered by the old and new selection, but not the
+    // area in both.
+    //
+    void updateSelection();
+
+    //
+    // Gets the rectangle of the model's selection on the grid, an empty
+    // rectangle is returned if there is no selection.
+    //
+    QRect selectionRect() const;
+
+    //
+    // Brings the text layer up to date with the cursor. If the cursor moved
+    // by fewer rows than are visible in the same pattern, the layer is
+    // scrolled and only the newly exposed rows are painted.
+    //
+    void updateTextLayer();
+
+    //
+    // Paints pattern text for the visible rows in [rowStart, rowEnd]
+    //
+    void drawText(QPainter &painter, int rowStart, int rowEnd);
     void setPlaying(bool playing);
 
     void updateCursor(PatternModel::CursorChangeFlags flags);
@@ -128,6 +166,20 @@ private:
 
     bool mEditorFocus;
 
+    // backing store of the pattern text, on a transparent background. During
+    // playback the cursor only moves by a row or two between paints, so the
+    // layer is scrolled instead of repainting the text of every row.
+    QPixmap mTextLayer;
+    bool mTextLayerValid;
+    // cursor position the layer was painted for
+    int mTextLayerPattern;
+    int mTextLayerRow;
+    // rows of the layer that need to be repainted, indexed by visible row.
+    // Only used when the rest of the layer is valid.
+    std::vector<bool> mDirtyRows;
+    // selection rectangle as of the last paint
+    QRect mSelectionRect;
+
     // user must move this amount of pixels to begin selecting
     static constexpr auto SELECTION_DEAD_ZONE = 4;
 
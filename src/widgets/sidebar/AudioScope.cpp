@@ -4,18 +4,29 @@
 #include <QGuiApplication>
 #include <QPainter>
 #include <QPen>
+#include <QWheelEvent>
+
+#include <algorithm>
 
 #define TU AudioScopeTU
 namespace TU {
 
 constexpr int LINE_WIDTH = 1;
 
+// opacity of the min/max envelope drawn under the scope line
+constexpr int ENVELOPE_ALPHA = 96;
+
 }
 
 AudioScope::AudioScope(QWidget *parent) :
     QFrame(parent),
     mBuffer(nullptr),
-    mLineColor(Qt::white)
+    mWindow(0),
+    mLineColor(Qt::white),
+    mColumnsLeft(),
+    mColumnsRight(),
+    mEnvelope(),
+    mLine()
 {
     setAttribute(Qt::WA_StyledBackground);
     setAutoFillBackground(true);
@@ -53,58 +64,108 @@ void AudioScope::setColors(Palette const& pal) {
     update();
 }
 
+void AudioScope::setWindow(size_t samples) {
+    if (mWindow != samples) {
+        mWindow = samples;
+        update();
+    }
+}
+
+void AudioScope::wheelEvent(QWheelEvent *evt) {
+    auto const delta = evt->angleDelta().y();
+    if (mBuffer == nullptr || delta == 0) {
+        evt->ignore();
+        return;
+    }
+
+    size_t frameSize, maxWindow;
+    {
+        auto handle = mBuffer->access();
+        frameSize = handle->size();
+        maxWindow = handle->maxWindow();
+    }
+    if (frameSize == 0) {
+        return;
+    }
+
+    auto window = mWindow ? mWindow : frameSize;
+    if (delta > 0) {
+        // zoom in, no further than a single frame
+        window = std::max(frameSize, window / 2);
+    } else {
+        window = std::min(maxWindow, window * 2);
+    }
+    setWindow(window == frameSize ? 0 : window);
+    evt->accept();
+}
+
 void AudioScope::paintEvent(QPaintEvent *evt) {
     QFrame::paintEvent(evt);
 
-    // it may be more efficient to do renderering in a separate thread
-    // we can convert a sample buffer to a buffer of QLines, then
-    // the paint event just draws the lines
-
     if (mBuffer == nullptr) {
         // no buffer, draw nothing
         drawSilence();
         return;
     }
 
-    auto handle = mBuffer->access();
-    auto size = handle->size();
-    if (size == 0) {
-        // buffer is empty, draw nothing
-        drawSilence();
+    auto const w = width() - (TU::LINE_WIDTH * 2);
+    if (w <= 0) {
         return;
     }
+    mColumnsLeft.resize(w);
+    mColumnsRight.resize(w);
+
+    size_t window;
+    {
+        // only hold the buffer while decimating, so the render thread isn't
+        // kept waiting while we paint
+        auto handle = mBuffer->access();
+        auto const size = handle->size();
+        if (size == 0) {
+            // buffer is empty, draw nothing
+            handle.unlock();
+            drawSilence();
+            return;
+        }
+        window = std::min(mWindow ? mWindow : size, handle->maxWindow());
+        handle->decimate(window, w, mColumnsLeft.data(), mColumnsRight.data());
+    }
 
-    auto const w = width() - (TU::LINE_WIDTH * 2);
-    
     QPainter painter(this);
     painter.setRenderHint(QPainter::Antialiasing);
-    painter.setPen(mLineColor);
-
-    // pixels per sample
-    float ratio = (unsigned)size / (float)w;
-    float index = 0;
-
-    float prevLeft;
-    float prevRight;
-    sample(handle, 0.0f, ratio, prevLeft, prevRight);
 
-    int const end = w + TU::LINE_WIDTH;
-    for (int t = 1 + TU::LINE_WIDTH; t < end; ++t) {
-        index += ratio;
-        
-        float leftSample;
-        float rightSample;
-        sample(handle, index, ratio, leftSample, rightSample);
-
-        painter.drawLine(QLineF(t - 1, prevLeft, t, leftSample));
-        painter.drawLine(QLineF(t - 1, prevRight, t, rightSample));
+    // the envelope is only visible when multiple samples share a pixel
+    bool const envelope = window > (size_t)w;
+    drawChannel(painter, mColumnsLeft, WAVE_LEFT_AXIS, envelope);
+    drawChannel(painter, mColumnsRight, WAVE_RIGHT_AXIS, envelope);
+}
 
-        prevLeft = leftSample;
-        prevRight = rightSample;
+void AudioScope::drawChannel(QPainter &painter, std::vector<VisualizerBuffer::Column> const& columns, int axis, bool envelope) {
+    constexpr float SCALE = WAVE_HEIGHT / 2.0f;
+    auto const count = (int)columns.size();
+
+    if (envelope) {
+        // maximums left to right, then minimums right to left
+        mEnvelope.resize(count * 2);
+        for (int i = 0; i < count; ++i) {
+            auto const x = (qreal)(i + TU::LINE_WIDTH);
+            mEnvelope[i] = QPointF(x, axis - columns[i].max * SCALE);
+            mEnvelope[count * 2 - 1 - i] = QPointF(x, axis - columns[i].min * SCALE);
+        }
+        auto fill = mLineColor;
+        fill.setAlpha(TU::ENVELOPE_ALPHA);
+        painter.setPen(Qt::NoPen);
+        painter.setBrush(fill);
+        painter.drawPolygon(mEnvelope);
+        painter.setBrush(Qt::NoBrush);
+    }
 
-        
+    mLine.resize(count);
+    for (int i = 0; i < count; ++i) {
+        mLine[i] = QPointF(i + TU::LINE_WIDTH, axis - columns[i].average * SCALE);
     }
-    
+    painter.setPen(mLineColor);
+    painter.drawPolyline(mLine);
 }
 
 void AudioScope::drawSilence() {
@@ -116,12 +177,4 @@ void AudioScope::drawSilence() {
 
 }
 
-void AudioScope::sample(Locked<VisualizerBuffer> &handle, float index, float ratio, float &outLeft, float &outRight) {
-    float left, right;
-    handle->averageSample(index, ratio, left, right);
-
-    outLeft = WAVE_LEFT_AXIS - (left / (2.0f / WAVE_HEIGHT));
-    outRight = WAVE_RIGHT_AXIS - (right / (2.0f / WAVE_HEIGHT));
-}
-
 #undef TU
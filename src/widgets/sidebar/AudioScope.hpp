@@ -7,6 +7,10 @@
 #include "utils/Guarded.hpp"
 
 #include <QFrame>
+#include <QPainter>
+#include <QPolygonF>
+
+#include <vector>
 
 
 class AudioScope : public QFrame {
@@ -23,16 +27,32 @@ public:
 
     void setColors(Palette const& pal);
 
+    //
+    // Sets the number of samples shown by the scope. 0 shows the most recent
+    // synth frame (the default). The window is limited to the buffer's
+    // VisualizerBuffer::maxWindow().
+    //
+    void setWindow(size_t samples);
+
 protected:
 
     void paintEvent(QPaintEvent *evt) override;
 
+    //
+    // Zooms the scope in or out by a factor of 2
+    //
+    void wheelEvent(QWheelEvent *evt) override;
+
 private:
     Q_DISABLE_COPY(AudioScope)
 
     void drawSilence();
 
-    void sample(Locked<VisualizerBuffer> &handle, float index, float ratio, float &outLeft, float &outRight);
+    //
+    // Draws the decimated columns for a channel centered on the given axis,
+    // as a min/max envelope with the average line on top.
+    //
+    void drawChannel(QPainter &painter, std::vector<VisualizerBuffer::Column> const& columns, int axis, bool envelope);
 
     static constexpr int WAVE_WIDTH = 160;
     static constexpr int WAVE_HEIGHT = 64;
@@ -43,7 +63,15 @@ private:
 
     Guarded<VisualizerBuffer> *mBuffer;
 
+    size_t mWindow;
+
     QColor mLineColor;
 
+    // scratch buffers for paintEvent, kept to avoid reallocating
+    std::vector<VisualizerBuffer::Column> mColumnsLeft;
+    std::vector<VisualizerBuffer::Column> mColumnsRight;
+    QPolygonF mEnvelope;
+    QPolygonF mLine;
+
 
 };
@@ -0,0 +1,138 @@
+
+#include "widgets/sidebar/AudioSpectrum.hpp"
+
+#include <QGuiApplication>
+#include <QPainter>
+
+#include <vector>
+
+#define TU AudioSpectrumTU
+namespace TU {
+
+constexpr int LINE_WIDTH = 1;
+
+// opacity of the area under the spectrum line
+constexpr int FILL_ALPHA = 96;
+
+}
+
+AudioSpectrum::AudioSpectrum(QWidget *parent) :
+    QFrame(parent),
+    mBuffer(nullptr),
+    mThread(),
+    mAnalyser(new SpectrumAnalyser),
+    mPending(false),
+    mBands(),
+    mLineColor(Qt::white),
+    mLine()
+{
+    setAttribute(Qt::WA_StyledBackground);
+    setAutoFillBackground(true);
+
+    // same as AudioScope
+    auto pal = palette();
+    if (pal.isCopyOf(QGuiApplication::palette())) {
+        // only modify the palette if we have the default one
+        pal.setColor(QPalette::Window, Qt::black);
+        setPalette(pal);
+    }
+
+    setFrameStyle(QFrame::Box | QFrame::Plain);
+    setLineWidth(TU::LINE_WIDTH);
+    setFixedHeight(SPECTRUM_HEIGHT + TU::LINE_WIDTH * 2);
+
+    mAnalyser->moveToThread(&mThread);
+    connect(&mThread, &QThread::finished, mAnalyser, &SpectrumAnalyser::deleteLater);
+    connect(mAnalyser, &SpectrumAnalyser::analysed, this, &AudioSpectrum::setBands);
+    mThread.setObjectName(QStringLiteral("spectrum analyser thread"));
+    mThread.start();
+}
+
+AudioSpectrum::~AudioSpectrum() {
+    mThread.quit();
+    mThread.wait();
+}
+
+void AudioSpectrum::setBuffer(Guarded<VisualizerBuffer> *buffer) {
+    if (buffer != mBuffer) {
+        mBuffer = buffer;
+        mBands.clear();
+        update();
+    }
+}
+
+void AudioSpectrum::setColors(Palette const& pal) {
+    auto widgetPal = palette();
+    widgetPal.setColor(QPalette::Window, pal[Palette::ColorScopeBackground]);
+    setPalette(widgetPal);
+
+    mLineColor = pal[Palette::ColorScopeLine];
+
+    update();
+}
+
+void AudioSpectrum::analyse() {
+    if (mBuffer == nullptr || mPending || !isVisible()) {
+        return;
+    }
+
+    auto const bands = width() - (TU::LINE_WIDTH * 2);
+    if (bands <= 0) {
+        return;
+    }
+
+    // copying the history is quick, the buffer is only locked for the copy.
+    // The worker then owns its samples and never touches the buffer.
+    std::vector<float> left(SpectrumAnalyser::SAMPLES);
+    std::vector<float> right(SpectrumAnalyser::SAMPLES);
+    mBuffer->access()->history(SpectrumAnalyser::SAMPLES, left.data(), right.data());
+
+    mPending = true;
+    auto analyser = mAnalyser;
+    QMetaObject::invokeMethod(mAnalyser, [analyser, left = std::move(left), right = std::move(right), bands]() {
+        analyser->analyse(left, right, bands);
+    }, Qt::QueuedConnection);
+}
+
+void AudioSpectrum::setBands(QVector<float> const& bands) {
+    mPending = false;
+    mBands = bands;
+    update();
+}
+
+void AudioSpectrum::paintEvent(QPaintEvent *evt) {
+    QFrame::paintEvent(evt);
+
+    auto const count = (int)mBands.size();
+    if (count == 0) {
+        return;
+    }
+
+    // the widget may have been resized since the analysis, stretch to fit
+    auto const w = width() - (TU::LINE_WIDTH * 2);
+    auto const xscale = (qreal)w / count;
+    auto const bottom = (qreal)(SPECTRUM_HEIGHT + TU::LINE_WIDTH);
+
+    // line left to right, then closed along the bottom for the fill
+    mLine.resize(count + 2);
+    for (int i = 0; i < count; ++i) {
+        mLine[i] = QPointF(TU::LINE_WIDTH + i * xscale, bottom - mBands[i] * SPECTRUM_HEIGHT);
+    }
+    mLine[count] = QPointF(TU::LINE_WIDTH + w, bottom);
+    mLine[count + 1] = QPointF(TU::LINE_WIDTH, bottom);
+
+    QPainter painter(this);
+    painter.setRenderHint(QPainter::Antialiasing);
+
+    auto fill = mLineColor;
+    fill.setAlpha(TU::FILL_ALPHA);
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(fill);
+    painter.drawPolygon(mLine);
+
+    painter.setBrush(Qt::NoBrush);
+    painter.setPen(mLineColor);
+    painter.drawPolyline(mLine.constData(), count);
+}
+
+#undef TU
@@ -0,0 +1,66 @@
+#pragma once
+
+
+#include "audio/SpectrumAnalyser.hpp"
+#include "audio/VisualizerBuffer.hpp"
+#include "config/data/Palette.hpp"
+#include "utils/Guarded.hpp"
+
+#include <QFrame>
+#include <QPolygonF>
+#include <QThread>
+#include <QVector>
+
+//
+// Spectrum visualizer, shows the spectrum of the most recent samples in the
+// visualizer buffer with a log frequency axis. The analysis is done by a
+// SpectrumAnalyser on a worker thread, this widget only draws its results.
+//
+class AudioSpectrum : public QFrame {
+
+    Q_OBJECT
+
+public:
+
+    explicit AudioSpectrum(QWidget *parent = nullptr);
+    ~AudioSpectrum();
+
+    void setBuffer(Guarded<VisualizerBuffer>* buffer);
+
+    void setColors(Palette const& pal);
+
+public slots:
+
+    //
+    // Requests a new analysis of the buffer, call when the buffer has been
+    // modified. Requests made while an analysis is in progress are dropped,
+    // so that the worker never has a backlog.
+    //
+    void analyse();
+
+protected:
+
+    void paintEvent(QPaintEvent *evt) override;
+
+private:
+    Q_DISABLE_COPY(AudioSpectrum)
+
+    void setBands(QVector<float> const& bands);
+
+    static constexpr int SPECTRUM_HEIGHT = 64;
+
+    Guarded<VisualizerBuffer> *mBuffer;
+
+    QThread mThread;
+    SpectrumAnalyser *mAnalyser;
+    // true while the analyser has a request in progress
+    bool mPending;
+
+    QVector<float> mBands;
+
+    QColor mLineColor;
+
+    // scratch buffer for paintEvent
+    QPolygonF mLine;
+
+};
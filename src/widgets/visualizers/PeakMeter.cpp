@@ -4,10 +4,25 @@
 #include <QPaintEvent>
 #include <QPainter>
 
+#define TU PeakMeterTU
+namespace TU {
+
+constexpr int METER_HEIGHT = 12;
+
+qreal meterWidth(qreal db, int width) {
+    return (db - VolumeMeterAnimation::MIN_DB) * width / -VolumeMeterAnimation::MIN_DB;
+}
+
+}
 
 PeakMeter::PeakMeter(QWidget *parent) :
-    QWidget(parent)
+    QWidget(parent),
+    mMeterLeft(),
+    mMeterRight(),
+    mRmsLeft(VolumeMeterAnimation::MIN_DB),
+    mRmsRight(VolumeMeterAnimation::MIN_DB)
 {
+    setFixedHeight(TU::METER_HEIGHT);
     connect(&mMeterLeft, &VolumeMeterAnimation::redraw, this, qOverload<>(&PeakMeter::update));
     connect(&mMeterRight, &VolumeMeterAnimation::redraw, this, qOverload<>(&PeakMeter::update));
 }
@@ -15,19 +30,40 @@ PeakMeter::PeakMeter(QWidget *parent) :
 
 void PeakMeter::setPeaks(qint16 left, qint16 right) {
 
-    mMeterLeft.setTarget(left);
-    mMeterRight.setTarget(right);
+    mMeterLeft.setTarget(left / (qreal)INT16_MAX);
+    mMeterRight.setTarget(right / (qreal)INT16_MAX);
 
 }
 
+void PeakMeter::setLevels(qreal peakLeft, qreal peakRight, qreal rmsLeft, qreal rmsRight) {
+    mMeterLeft.setTarget(peakLeft);
+    mMeterRight.setTarget(peakRight);
+
+    auto const left = VolumeMeterAnimation::toDecibels(rmsLeft);
+    auto const right = VolumeMeterAnimation::toDecibels(rmsRight);
+    if (!qFuzzyCompare(left, mRmsLeft) || !qFuzzyCompare(right, mRmsRight)) {
+        mRmsLeft = left;
+        mRmsRight = right;
+        update();
+    }
+}
+
 void PeakMeter::paintEvent(QPaintEvent *evt) {
     Q_UNUSED(evt)
 
     QPainter painter(this);
 
     int const w = width();
+    int const h = height();
     int const center = w / 2;
 
-    painter.fillRect(QRectF(center, 0.0, mMeterLeft.meterWidth(center), 16.0), Qt::black);
-    painter.fillRect(QRectF(center, 0.0, -mMeterRight.meterWidth(center), 16.0), Qt::black);
+    auto const peakColor = palette().color(QPalette::WindowText);
+    painter.fillRect(QRectF(center, 0.0, -mMeterLeft.meterWidth(center), h), peakColor);
+    painter.fillRect(QRectF(center, 0.0, mMeterRight.meterWidth(center), h), peakColor);
+
+    auto const rmsColor = palette().color(QPalette::Highlight);
+    painter.fillRect(QRectF(center, 0.0, -TU::meterWidth(mRmsLeft, center), h), rmsColor);
+    painter.fillRect(QRectF(center, 0.0, TU::meterWidth(mRmsRight, center), h), rmsColor);
 }
+
+#undef TU
@@ -5,6 +5,11 @@
 
 #include <QWidget>
 
+//
+// Stereo level meter. The left channel is drawn from the center to the left
+// and the right channel from the center to the right. Each channel shows its
+// peak level with its RMS level drawn over it.
+//
 class PeakMeter : public QWidget {
 
     Q_OBJECT
@@ -16,6 +21,12 @@ public slots:
 
     void setPeaks(qint16 left, qint16 right);
 
+    //
+    // Sets the peak and RMS levels of both channels, as linear amplitudes
+    // from 0.0 to 1.0. Peaks are animated, RMS levels are drawn as is.
+    //
+    void setLevels(qreal peakLeft, qreal peakRight, qreal rmsLeft, qreal rmsRight);
+
 protected:
 
     void paintEvent(QPaintEvent *evt) override;
@@ -26,4 +37,8 @@ private:
     VolumeMeterAnimation mMeterLeft;
     VolumeMeterAnimation mMeterRight;
 
+    // RMS levels, in dB
+    qreal mRmsLeft;
+    qreal mRmsRight;
+
 };
@@ -3,13 +3,14 @@
 
 #include <QtDebug>
 
+#include <algorithm>
 #include <cmath>
 
 constexpr int DURATION = 100;
 
 VolumeMeterAnimation::VolumeMeterAnimation(QObject *parent) :
     QAbstractAnimation(parent),
-    mTargetSample(0),
+    mTargetAmplitude(0.0),
     mTarget(MIN_DB),
     mVolume(MIN_DB),
     mStartValue(MIN_DB),
@@ -35,13 +36,18 @@ int VolumeMeterAnimation::duration() const {
     return DURATION;
 }
 
-void VolumeMeterAnimation::setTarget(qint16 volume) {
-    if (mTargetSample != volume) {
-        mTargetSample = volume;
-        auto target = volume ? 6.0 * log2(volume / (double)INT16_MAX) : MIN_DB;
-        if (target < MIN_DB) {
-            target = MIN_DB;
-        }
+qreal VolumeMeterAnimation::toDecibels(qreal amplitude) {
+    if (amplitude > 0.0) {
+        return std::max(MIN_DB, 6.0 * std::log2(amplitude));
+    } else {
+        return MIN_DB;
+    }
+}
+
+void VolumeMeterAnimation::setTarget(qreal amplitude) {
+    if (mTargetAmplitude != amplitude) {
+        mTargetAmplitude = amplitude;
+        auto const target = toDecibels(amplitude);
 
         if (!qFuzzyCompare(target, mTarget)) {
             stop();
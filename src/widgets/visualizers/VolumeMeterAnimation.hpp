@@ -34,10 +34,15 @@ public:
     int duration() const override;
 
     //
-    // Set the target volume to move to. If the animation was stopped
-    // it is started.
+    // Converts a linear amplitude, 0.0 to 1.0, to dB, clamped to MIN_DB.
     //
-    void setTarget(qint16 volume);
+    static qreal toDecibels(qreal amplitude);
+
+    //
+    // Set the target volume to move to, as a linear amplitude from 0.0 to
+    // 1.0. If the animation was stopped it is started.
+    //
+    void setTarget(qreal amplitude);
 
 signals:
     //
@@ -53,7 +58,7 @@ private:
 
     Q_DISABLE_COPY(VolumeMeterAnimation)
 
-    qint16 mTargetSample;
+    qreal mTargetAmplitude;
 
     // these values are in dB
     qreal mTarget;
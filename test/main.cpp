@@ -41,6 +41,9 @@ int main(int argc, char* argv[]) {
         return ExitNoTest;
     }
 
+    // for tests that need an event loop (timers, queued signals)
+    QCoreApplication app(argc, argv);
+
     std::unique_ptr<QObject> test(meta->newInstance());
     if (test == nullptr) {
         std::cerr << "could not instantiate test class\n";
@@ -250,6 +250,55 @@ void TestPatternClip::persistance() {
     QVERIFY(clip == clip2);
 }
 
+void TestPatternClip::compacting() {
+    // test that a compacted clip is equivalent to the original, and that
+    // identical compacted clips share their data
+
+    auto const selection = PatternSelection(
+        PatternAnchor(0, 0, 0),
+        PatternAnchor(PATTERN_SIZE - 1, PatternAnchor::MAX_SELECTS - 1, 3)
+    );
+
+    PatternClip clip;
+    clip.save(samplePattern(), selection);
+    auto const uncompactedSize = clip.memoryUsage();
+
+    PatternClip compacted;
+    compacted.save(samplePattern(), selection);
+    compacted.compact();
+    QVERIFY(compacted.hasData());
+    // sample pattern is mostly empty, so the compacted clip should be smaller
+    QVERIFY(compacted.memoryUsage() < uncompactedSize);
+    QVERIFY(compacted == clip);
+
+    // restoring the compacted clip restores the original data
+    PatternCopy patternData(mEmptyTrack, mEmptyTrack, mEmptyTrack, mEmptyTrack);
+    auto pattern = patternData.pattern();
+    compacted.restore(pattern);
+    QVERIFY(patternData[0] == mCh1Track);
+    QVERIFY(patternData[1] == mEmptyTrack);
+    QVERIFY(patternData[2] == mEmptyTrack);
+    QVERIFY(patternData[3] == mCh4Track);
+
+    // an identical clip compacts to the same data, halving the usage of each
+    auto const compactedSize = compacted.memoryUsage();
+    PatternClip compacted2;
+    compacted2.save(samplePattern(), selection);
+    compacted2.compact();
+    QVERIFY(compacted2 == compacted);
+    QCOMPARE(compacted.memoryUsage(), compactedSize / 2);
+
+    // mime data is always uncompacted
+    QMimeData mime;
+    compacted.toMime(&mime);
+    PatternClip fromMime;
+    QVERIFY(fromMime.fromMime(&mime));
+    QVERIFY(fromMime == clip);
+
+    compacted.clear();
+    QVERIFY(!compacted.hasData());
+}
+
 
 
 TestPatternClip::PatternCopy::PatternCopy(trackerboy::Track const& tr1, trackerboy::Track const& tr2, trackerboy::Track const& tr3, trackerboy::Track const& tr4) :
@@ -39,6 +39,8 @@ private slots:
 
     void persistance();
 
+    void compacting();
+
 
 private:
 
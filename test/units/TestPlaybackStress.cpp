@@ -0,0 +1,133 @@
+#include "units/TestPlaybackStress.hpp"
+#include "audio/Renderer.hpp"
+#include "config/data/SoundConfig.hpp"
+#include "core/Module.hpp"
+#include "core/ModuleFile.hpp"
+#include "core/StallDetector.hpp"
+#include "model/PatternModel.hpp"
+#include "model/SongModel.hpp"
+
+#include "trackerboy/note.hpp"
+
+#include <QDir>
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+// how much audio is played while stressing, in milliseconds. The test is
+// paced by the frames the virtual device consumes, not the wall clock, so a
+// loaded machine only makes it take longer.
+constexpr int STRESS_TIME = 3000;
+// give up if the device has not consumed STRESS_TIME of audio after this long
+constexpr int TIMEOUT = STRESS_TIME * 20;
+// edits made before the event loop is run again
+constexpr int EDITS_PER_BATCH = 16;
+// buffer size, long enough that only a blocked render thread underruns
+constexpr int LATENCY = 100;
+// columns of the decimated scope
+constexpr int SCOPE_COLUMNS = 256;
+
+TestPlaybackStress::TestPlaybackStress() {
+
+}
+
+void TestPlaybackStress::editsDuringPlayback() {
+    QDir dir(QStringLiteral(TEST_EXAMPLES_DIR));
+    auto const files = dir.entryList({ QStringLiteral("*.tbm") }, QDir::Files, QDir::Name);
+    QVERIFY(!files.isEmpty());
+
+    Module mod;
+    ModuleFile file;
+    QVERIFY(file.open(dir.filePath(files.first()), mod));
+    SongModel songModel(mod);
+    PatternModel patternModel(mod, songModel);
+    // edits go wherever the cursor is put, instead of the playing row
+    patternModel.setFollowing(false);
+
+    SoundConfig config;
+    config.setLatency(LATENCY);
+    Renderer renderer(mod);
+    // 1 ms periods with up to 2 ms of jitter
+    auto const period = (size_t)(config.samplerate() / 1000);
+    auto const stressFrames = (uint64_t)config.samplerate() * STRESS_TIME / 1000;
+    VirtualAudioDevice::Config const device{ period, 1.0, 2000, 1, (size_t)stressFrames };
+    QVERIFY(renderer.setConfig(config, device));
+
+    // same as MainWindow, the GUI follows playback and reads the visualizer
+    // buffer while the render thread writes to it
+    connect(&renderer, &Renderer::isPlayingChanged, &patternModel, &PatternModel::setPlaying);
+    connect(&renderer, &Renderer::frameSync, &patternModel,
+        [&renderer, &patternModel]() {
+            auto const frame = renderer.currentFrame();
+            if (frame.startedNewRow) {
+                patternModel.setTrackerCursor(frame.row, frame.order);
+            }
+        });
+    std::vector<VisualizerBuffer::Column> left(SCOPE_COLUMNS), right(SCOPE_COLUMNS);
+    connect(&renderer, &Renderer::updateVisualizers, &patternModel,
+        [&renderer, &left, &right]() {
+            auto handle = renderer.visualizerBuffer().access();
+            handle->decimate(handle->maxWindow(), SCOPE_COLUMNS, left.data(), right.data());
+        });
+
+    StallDetector stallDetector;
+
+    std::mt19937 rng(1);
+    auto random = [&rng](int max) {
+        return std::uniform_int_distribution<int>(0, max - 1)(rng);
+    };
+
+    renderer.play(0, 0, false);
+    QVERIFY(renderer.isRunning());
+
+    auto const& virtualDevice = renderer.virtualDevice();
+    QElapsedTimer timer;
+    timer.start();
+    int edits = 0;
+    while (virtualDevice.framesConsumed() < stressFrames) {
+        if (timer.elapsed() > TIMEOUT) {
+            QFAIL("the virtual device stopped consuming frames");
+        }
+        for (int i = 0; i < EDITS_PER_BATCH; ++i) {
+            patternModel.setCursorPattern(random(patternModel.patterns()));
+            patternModel.setCursorTrack(random(4));
+            patternModel.setCursorRow(random(songModel.patternSize()));
+            switch (random(8)) {
+                case 0:
+                    mod.undoStack()->undo();
+                    break;
+                case 1:
+                    patternModel.deleteSelection();
+                    break;
+                case 2:
+                    // an edit of the entire pattern
+                    patternModel.selectAll();
+                    patternModel.transpose(random(2) ? 1 : -1);
+                    patternModel.deselect();
+                    break;
+                default:
+                    patternModel.setNote((uint8_t)random(trackerboy::NOTE_LAST + 1), std::nullopt);
+                    break;
+            }
+            ++edits;
+        }
+        QCoreApplication::processEvents();
+    }
+
+    // the render kept up with the device
+    auto const underruns = renderer.statUnderruns();
+    renderer.forceStop();
+    QVERIFY(edits > 0);
+    QCOMPARE(underruns, 0u);
+
+    // nothing was rendered if the captured audio is all silence
+    auto const& captured = virtualDevice.captured();
+    QVERIFY(!captured.empty());
+    QVERIFY(std::any_of(captured.begin(), captured.end(), [](float sample) { return sample != 0.0f; }));
+
+    // the GUI thread was never blocked by the render thread for long
+    auto const stalls = stallDetector.counts();
+    QCOMPARE(stalls.back(), 0u);
+}
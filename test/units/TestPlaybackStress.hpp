@@ -0,0 +1,18 @@
+
+#pragma once
+
+#include <QtTest/QtTest>
+
+class TestPlaybackStress : public QObject {
+
+    Q_OBJECT
+
+public:
+
+    Q_INVOKABLE TestPlaybackStress();
+
+private slots:
+
+    void editsDuringPlayback();
+
+};
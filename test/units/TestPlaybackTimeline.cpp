@@ -0,0 +1,110 @@
+
+#include "units/TestPlaybackTimeline.hpp"
+#include "audio/PlaybackTimeline.hpp"
+
+#include <chrono>
+
+using Clock = PlaybackTimeline::Clock;
+
+// 1000 Hz so that a sample is a millisecond
+constexpr int RATE = 1000;
+constexpr int ROW_LENGTH = 100;
+
+TestPlaybackTimeline::TestPlaybackTimeline() {
+
+}
+
+void TestPlaybackTimeline::notPlaying() {
+    PlaybackTimeline timeline;
+    auto const now = Clock::now();
+    QVERIFY(!timeline.position(now));
+
+    timeline.rowStarted(0, 0, 0);
+    timeline.publish(ROW_LENGTH, 0, now, RATE, false);
+    QVERIFY(!timeline.position(now));
+}
+
+void TestPlaybackTimeline::compensatesLatency() {
+    PlaybackTimeline timeline;
+    for (int row = 0; row < 4; ++row) {
+        timeline.rowStarted(2, row, row * ROW_LENGTH);
+    }
+
+    // 350 samples written, 100 still buffered, so sample 250 is being heard
+    auto const now = Clock::now();
+    timeline.publish(350, 100, now, RATE, true);
+
+    auto pos = timeline.position(now);
+    QVERIFY(pos);
+    QCOMPARE(pos->pattern, 2);
+    QCOMPARE(pos->row, 2);
+    QCOMPARE(pos->fraction, 0.5f);
+
+    // 100 ms earlier
+    pos = timeline.position(now - std::chrono::milliseconds(100));
+    QVERIFY(pos);
+    QCOMPARE(pos->row, 1);
+    QCOMPARE(pos->fraction, 0.5f);
+
+    // older than the history
+    QVERIFY(!timeline.position(now - std::chrono::seconds(1)));
+}
+
+void TestPlaybackTimeline::extrapolates() {
+    PlaybackTimeline timeline;
+    timeline.rowStarted(0, 0, 0);
+    timeline.rowStarted(0, 1, ROW_LENGTH);
+    auto const now = Clock::now();
+    timeline.publish(ROW_LENGTH + 50, 50, now, RATE, true);
+
+    // 25 ms into the newest row, its length is taken from the previous row
+    auto pos = timeline.position(now + std::chrono::milliseconds(25));
+    QVERIFY(pos);
+    QCOMPARE(pos->row, 1);
+    QCOMPARE(pos->fraction, 0.25f);
+
+    // can't be ahead of what was written
+    pos = timeline.position(now + std::chrono::seconds(1));
+    QVERIFY(pos);
+    QCOMPARE(pos->row, 1);
+    QCOMPARE(pos->fraction, 0.5f);
+}
+
+void TestPlaybackTimeline::reset() {
+    PlaybackTimeline timeline;
+    timeline.rowStarted(1, 10, 0);
+    timeline.rowStarted(1, 11, ROW_LENGTH);
+
+    // played again while the last play is still buffered, the new play's
+    // first row starts after what is being heard
+    timeline.reset();
+    timeline.rowStarted(3, 0, ROW_LENGTH * 2);
+    auto const now = Clock::now();
+    timeline.publish(ROW_LENGTH * 2, 50, now, RATE, true);
+    QVERIFY(!timeline.position(now));
+
+    // once heard, the new play's rows are used
+    auto const pos = timeline.position(now + std::chrono::milliseconds(60));
+    QVERIFY(pos);
+    QCOMPARE(pos->pattern, 3);
+    QCOMPARE(pos->row, 0);
+}
+
+void TestPlaybackTimeline::quantize() {
+    auto pos = PlaybackTimeline::quantize({ 1, 5, 0.4f }, 1);
+    QCOMPARE(pos.pattern, 1);
+    QCOMPARE(pos.row, 5);
+
+    pos = PlaybackTimeline::quantize({ 1, 5, 0.6f }, 1);
+    QCOMPARE(pos.row, 6);
+
+    pos = PlaybackTimeline::quantize({ 1, 5, 0.0f }, 4);
+    QCOMPARE(pos.row, 4);
+
+    pos = PlaybackTimeline::quantize({ 1, 6, 0.5f }, 4);
+    QCOMPARE(pos.row, 8);
+
+    // past the end of a 64 row pattern, the caller moves it to the next one
+    pos = PlaybackTimeline::quantize({ 1, 63, 0.5f }, 4);
+    QCOMPARE(pos.row, 64);
+}
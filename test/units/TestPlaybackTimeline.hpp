@@ -0,0 +1,26 @@
+
+#pragma once
+
+#include <QtTest/QtTest>
+
+class TestPlaybackTimeline : public QObject {
+
+    Q_OBJECT
+
+public:
+
+    Q_INVOKABLE TestPlaybackTimeline();
+
+private slots:
+
+    void notPlaying();
+
+    void compensatesLatency();
+
+    void extrapolates();
+
+    void reset();
+
+    void quantize();
+
+};
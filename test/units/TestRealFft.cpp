@@ -0,0 +1,62 @@
+
+#include "units/TestRealFft.hpp"
+#include "audio/RealFft.hpp"
+
+#include <cmath>
+#include <vector>
+
+constexpr size_t SIZE = 64;
+
+TestRealFft::TestRealFft() {
+
+}
+
+void TestRealFft::constant() {
+    RealFft fft(SIZE);
+    QCOMPARE(fft.bins(), SIZE / 2 + 1);
+
+    std::vector<float> input(SIZE, 1.0f);
+    std::vector<float> power(fft.bins());
+    fft.power(input.data(), power.data());
+
+    // all energy is in DC
+    QCOMPARE(power[0], (float)(SIZE * SIZE));
+    for (size_t i = 1; i < power.size(); ++i) {
+        QVERIFY(power[i] < 1e-6f);
+    }
+}
+
+void TestRealFft::sine() {
+    constexpr size_t BIN = 5;
+
+    RealFft fft(SIZE);
+    std::vector<float> input(SIZE);
+    for (size_t i = 0; i < SIZE; ++i) {
+        input[i] = (float)std::sin(2.0 * 3.14159265358979323846 * BIN * i / SIZE);
+    }
+    std::vector<float> power(fft.bins());
+    fft.power(input.data(), power.data());
+
+    // magnitude of a unit sine is SIZE / 2
+    constexpr float EXPECTED = (SIZE / 2) * (SIZE / 2);
+    for (size_t i = 0; i < power.size(); ++i) {
+        if (i == BIN) {
+            QVERIFY(std::abs(power[i] - EXPECTED) < EXPECTED * 1e-4f);
+        } else {
+            QVERIFY(power[i] < EXPECTED * 1e-6f);
+        }
+    }
+}
+
+void TestRealFft::nyquist() {
+    RealFft fft(SIZE);
+    std::vector<float> input(SIZE);
+    for (size_t i = 0; i < SIZE; ++i) {
+        input[i] = (i & 1) ? -1.0f : 1.0f;
+    }
+    std::vector<float> power(fft.bins());
+    fft.power(input.data(), power.data());
+
+    QCOMPARE(power[SIZE / 2], (float)(SIZE * SIZE));
+    QVERIFY(power[0] < 1e-6f);
+}
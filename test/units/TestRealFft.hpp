@@ -0,0 +1,22 @@
+
+#pragma once
+
+#include <QtTest/QtTest>
+
+class TestRealFft : public QObject {
+
+    Q_OBJECT
+
+public:
+
+    Q_INVOKABLE TestRealFft();
+
+private slots:
+
+    void constant();
+
+    void sine();
+
+    void nyquist();
+
+};
@@ -0,0 +1,111 @@
+#include "units/TestRealtime.hpp"
+#include "audio/Renderer.hpp"
+#include "config/data/SoundConfig.hpp"
+#include "core/Module.hpp"
+#include "core/ModuleFile.hpp"
+#include "utils/Guarded.hpp"
+#include "utils/Realtime.hpp"
+
+#include <QDir>
+
+#include <chrono>
+#include <thread>
+
+// how long each example module is played for, in milliseconds
+constexpr int PLAY_TIME = 1000;
+// how long an instrument is previewed for, in milliseconds
+constexpr int PREVIEW_TIME = 250;
+// C-5
+constexpr int PREVIEW_NOTE = 36;
+
+struct Counter {
+    int value;
+};
+
+TestRealtime::TestRealtime() {
+
+}
+
+void TestRealtime::init() {
+#ifndef TRACKERBOY_REALTIME_CHECKS
+    QSKIP("real-time checks are disabled (ENABLE_REALTIME_CHECKS)");
+#endif
+    Realtime::resetViolations();
+}
+
+void TestRealtime::allocation() {
+    if (!Realtime::CHECKS_ALLOCATIONS) {
+        QSKIP("allocations are not checked in sanitizer builds");
+    }
+
+    {
+        Realtime::Scope realtime;
+        delete new int(1);
+    }
+    QCOMPARE(Realtime::violations(), (uint64_t)1);
+
+    {
+        Realtime::Scope realtime;
+        Realtime::Allow allow;
+        delete new int(1);
+    }
+    delete new int(1);
+    QCOMPARE(Realtime::violations(), (uint64_t)1);
+}
+
+void TestRealtime::contendedLock() {
+    Guarded<Counter> guarded(Counter{ 0 });
+
+    {
+        Realtime::Scope realtime;
+        // not held by anyone, does not wait
+        guarded.access()->value = 1;
+    }
+    QCOMPARE(Realtime::violations(), (uint64_t)0);
+
+    auto handle = guarded.access();
+    std::thread thread([&guarded]() {
+        Realtime::Scope realtime;
+        guarded.access()->value = 2;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    handle.unlock();
+    thread.join();
+    QCOMPARE(Realtime::violations(), (uint64_t)1);
+}
+
+void TestRealtime::examples() {
+    SoundConfig config;
+    // 5 ms periods, in real time
+    VirtualAudioDevice::Config const device{ (size_t)(config.samplerate() / 200), 1.0, 0, 0, 0 };
+
+    QDir dir(QStringLiteral(TEST_EXAMPLES_DIR));
+    auto const files = dir.entryList({ QStringLiteral("*.tbm") }, QDir::Files, QDir::Name);
+    QVERIFY(!files.isEmpty());
+
+    for (auto const& filename : files) {
+        Module mod;
+        ModuleFile file;
+        QVERIFY2(file.open(dir.filePath(filename), mod), qPrintable(filename));
+
+        Renderer renderer(mod);
+        QVERIFY(renderer.setConfig(config, device));
+
+        renderer.play(0, 0, false);
+        QTest::qWait(PLAY_TIME);
+        renderer.forceStop();
+
+        // the instrument previewer, if the module has any instruments
+        auto const& itable = mod.data().instrumentTable();
+        for (int id = 0; id < 64; ++id) {
+            if (itable.getShared((uint8_t)id)) {
+                renderer.instrumentPreview(PREVIEW_NOTE, -1, id);
+                QTest::qWait(PREVIEW_TIME);
+                renderer.forceStop();
+                break;
+            }
+        }
+
+        QVERIFY2(Realtime::violations() == 0, qPrintable(filename));
+    }
+}
@@ -0,0 +1,24 @@
+
+#pragma once
+
+#include <QtTest/QtTest>
+
+class TestRealtime : public QObject {
+
+    Q_OBJECT
+
+public:
+
+    Q_INVOKABLE TestRealtime();
+
+private slots:
+
+    void init();
+
+    void allocation();
+
+    void contendedLock();
+
+    void examples();
+
+};
@@ -0,0 +1,98 @@
+#include "units/TestSharedGuarded.hpp"
+#include "utils/SharedGuarded.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+// how long to wait for another thread to get the lock, in milliseconds
+constexpr int TIMEOUT = 5000;
+// how long a blocked thread is given to (wrongly) get the lock
+constexpr int BLOCKED_TIME = 50;
+
+struct Counter {
+    int value;
+};
+
+//
+// Waits up to TIMEOUT for the flag to be set
+//
+static bool waitFor(std::atomic_bool const& flag) {
+    auto const deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(TIMEOUT);
+    while (!flag.load()) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+TestSharedGuarded::TestSharedGuarded() {
+
+}
+
+void TestSharedGuarded::concurrentReaders() {
+    SharedGuarded<Counter> guarded(Counter{ 1 });
+    std::atomic_bool read(false);
+    int value = 0;
+
+    bool shared;
+    {
+        auto handle = guarded.read();
+        std::thread reader([&guarded, &read, &value]() {
+            value = guarded.read()->value;
+            read = true;
+        });
+        // the other reader gets in while this one holds the lock
+        shared = waitFor(read);
+        handle.unlock();
+        reader.join();
+    }
+    QVERIFY(shared);
+    QCOMPARE(value, 1);
+}
+
+void TestSharedGuarded::writerWaitsForReaders() {
+    SharedGuarded<Counter> guarded(Counter{ 1 });
+    std::atomic_bool written(false);
+
+    bool blocked;
+    {
+        auto handle = guarded.read();
+        std::thread writer([&guarded, &written]() {
+            guarded.access()->value = 2;
+            written = true;
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(BLOCKED_TIME));
+        blocked = !written && handle->value == 1;
+        handle.unlock();
+        writer.join();
+    }
+    QVERIFY(blocked);
+    QVERIFY(written);
+    QCOMPARE(guarded.read()->value, 2);
+}
+
+void TestSharedGuarded::readerWaitsForWriter() {
+    SharedGuarded<Counter> guarded(Counter{ 1 });
+    std::atomic_bool read(false);
+    int value = 0;
+
+    bool blocked;
+    {
+        auto handle = guarded.access();
+        std::thread reader([&guarded, &read, &value]() {
+            value = guarded.read()->value;
+            read = true;
+        });
+        handle->value = 2;
+        std::this_thread::sleep_for(std::chrono::milliseconds(BLOCKED_TIME));
+        blocked = !read;
+        handle.unlock();
+        reader.join();
+    }
+    QVERIFY(blocked);
+    // only sees the finished write
+    QCOMPARE(value, 2);
+}
@@ -0,0 +1,22 @@
+
+#pragma once
+
+#include <QtTest/QtTest>
+
+class TestSharedGuarded : public QObject {
+
+    Q_OBJECT
+
+public:
+
+    Q_INVOKABLE TestSharedGuarded();
+
+private slots:
+
+    void concurrentReaders();
+
+    void writerWaitsForReaders();
+
+    void readerWaitsForWriter();
+
+};
@@ -0,0 +1,118 @@
+
+#include "units/TestUndoHistory.hpp"
+#include "core/Module.hpp"
+#include "core/UndoStorage.hpp"
+
+#define TU TestUndoHistoryTU
+namespace TU {
+
+//
+// Sets an int to a new value, with a payload of the given size
+//
+class SetCmd : public QUndoCommand, public IUndoStorage {
+
+    int &mValue;
+    int const mOld;
+    int const mNew;
+    size_t mSize;
+
+public:
+    SetCmd(int &value, int newValue, size_t size) :
+        QUndoCommand(QStringLiteral("set")),
+        mValue(value),
+        mOld(value),
+        mNew(newValue),
+        mSize(size)
+    {
+    }
+
+    virtual void redo() override {
+        if (!isObsolete()) {
+            mValue = mNew;
+        }
+    }
+
+    virtual void undo() override {
+        if (!isObsolete()) {
+            mValue = mOld;
+        }
+    }
+
+    virtual size_t storageSize() const override {
+        return mSize;
+    }
+
+    virtual void releaseStorage() override {
+        mSize = 0;
+    }
+
+};
+
+size_t totalUsage(QUndoStack const* stack) {
+    size_t usage = 0;
+    for (int i = 0; i < stack->count(); ++i) {
+        usage += UndoStorage::memoryUsage(stack->command(i));
+    }
+    return usage;
+}
+
+}
+
+TestUndoHistory::TestUndoHistory() {
+
+}
+
+void TestUndoHistory::memoryUsage() {
+    Module mod;
+    auto stack = mod.undoStack();
+    int value = 0;
+
+    stack->push(new TU::SetCmd(value, 1, 1000));
+    stack->push(new TU::SetCmd(value, 2, 2000));
+    stack->push(new TU::SetCmd(value, 3, 3000));
+    QCOMPARE(mod.undoMemoryUsage(), TU::totalUsage(stack));
+
+    // undoing does not free anything
+    stack->undo();
+    stack->undo();
+    QCOMPARE(value, 1);
+    QCOMPARE(mod.undoMemoryUsage(), TU::totalUsage(stack));
+
+    // pushing discards the redo branch
+    stack->push(new TU::SetCmd(value, 4, 500));
+    QCOMPARE(stack->count(), 2);
+    QCOMPARE(mod.undoMemoryUsage(), TU::totalUsage(stack));
+
+    stack->clear();
+    QCOMPARE(mod.undoMemoryUsage(), 0u);
+}
+
+void TestUndoHistory::trim() {
+    Module mod;
+    auto stack = mod.undoStack();
+    int value = 0;
+
+    stack->push(new TU::SetCmd(value, 1, 1000));
+    stack->push(new TU::SetCmd(value, 2, 1000));
+    stack->push(new TU::SetCmd(value, 3, 1000));
+
+    // only the oldest command needs to be trimmed to be within the limit
+    auto const limit = mod.undoMemoryUsage() - 500;
+    mod.setUndoMemoryLimit(limit);
+    QCOMPARE(mod.undoTrimmedCount(stack), 1);
+    QVERIFY(mod.undoMemoryUsage() <= limit);
+    QCOMPARE(mod.undoMemoryUsage(), TU::totalUsage(stack));
+
+    // going back to the empty state (ie clicking it in a QUndoView) stops at
+    // the trimmed command, which is deleted by the stack
+    stack->setIndex(0);
+    QCOMPARE(value, 1);
+    QCOMPARE(stack->count(), 2);
+    QCOMPARE(mod.undoTrimmedCount(stack), 0);
+    QCOMPARE(mod.undoMemoryUsage(), TU::totalUsage(stack));
+
+    stack->setIndex(stack->count());
+    QCOMPARE(value, 3);
+}
+
+#undef TU
@@ -0,0 +1,20 @@
+
+#pragma once
+
+#include <QtTest/QtTest>
+
+class TestUndoHistory : public QObject {
+
+    Q_OBJECT
+
+public:
+
+    Q_INVOKABLE TestUndoHistory();
+
+private slots:
+
+    void memoryUsage();
+
+    void trim();
+
+};
@@ -0,0 +1,122 @@
+
+#include "units/TestUsageIndex.hpp"
+#include "core/UsageIndex.hpp"
+
+#include "trackerboy/data/Song.hpp"
+#include "trackerboy/note.hpp"
+
+using Kind = UsageIndex::Kind;
+
+TestUsageIndex::TestUsageIndex() {
+
+}
+
+void TestUsageIndex::invalid() {
+    UsageIndex index;
+    QVERIFY(!index.isValid());
+
+    // updates to an invalid index are ignored
+    trackerboy::TrackRow rowdata;
+    rowdata.setInstrument(1);
+    index.updateRow(trackerboy::ChType::ch1, 0, 0, rowdata);
+    QCOMPARE(index.count(Kind::instrument, 1), 0u);
+}
+
+void TestUsageIndex::rebuild() {
+    trackerboy::Song song;
+    auto &track1 = song.patterns().getTrack(trackerboy::ChType::ch1, 0);
+    track1.setNote(0, trackerboy::NOTE_C + trackerboy::OCTAVE_4);
+    track1.setInstrument(0, 1);
+    track1.setInstrument(4, 1);
+    track1.setEffect(4, 0, trackerboy::EffectType::setEnvelope, 0xF0);
+    auto &track3 = song.patterns().getTrack(trackerboy::ChType::ch3, 0);
+    track3.setInstrument(2, 2);
+    track3.setEffect(2, 0, trackerboy::EffectType::setEnvelope, 0x03);
+
+    UsageIndex index;
+    index.rebuild(song);
+    QVERIFY(index.isValid());
+
+    QCOMPARE(index.count(Kind::instrument, 1), 2u);
+    QCOMPARE(index.count(Kind::instrument, 2), 1u);
+    QCOMPARE(index.count(Kind::instrument, 0), 0u);
+    QCOMPARE(index.count(Kind::effect, (int)trackerboy::EffectType::setEnvelope), 2u);
+    // Exx only selects a waveform on CH3
+    QCOMPARE(index.count(Kind::waveform, 0x03), 1u);
+    QCOMPARE(index.count(Kind::waveform, 0xF0), 0u);
+
+    auto locations = index.find(Kind::instrument, 2);
+    QCOMPARE(locations.size(), 1u);
+    QCOMPARE(locations[0].channel, trackerboy::ChType::ch3);
+    QCOMPARE(locations[0].trackId, (uint8_t)0);
+    QCOMPARE(locations[0].row, (uint8_t)2);
+}
+
+void TestUsageIndex::updateRow() {
+    trackerboy::Song song;
+    UsageIndex index;
+    index.rebuild(song);
+    QCOMPARE(index.count(Kind::instrument, 5), 0u);
+
+    trackerboy::TrackRow rowdata;
+    rowdata.setInstrument(5);
+    rowdata.effects[0] = { trackerboy::EffectType::arpeggio, 0x37 };
+    rowdata.effects[1] = { trackerboy::EffectType::arpeggio, 0x47 };
+    index.updateRow(trackerboy::ChType::ch2, 0, 8, rowdata);
+    QCOMPARE(index.count(Kind::instrument, 5), 1u);
+    // the same effect twice in a row counts as a single row
+    QCOMPARE(index.count(Kind::effect, (int)trackerboy::EffectType::arpeggio), 1u);
+
+    // replacing the instrument moves the row to the new key
+    rowdata.setInstrument(6);
+    index.updateRow(trackerboy::ChType::ch2, 0, 8, rowdata);
+    QCOMPARE(index.count(Kind::instrument, 5), 0u);
+    QCOMPARE(index.count(Kind::instrument, 6), 1u);
+
+    // clearing the row removes it entirely
+    index.updateRow(trackerboy::ChType::ch2, 0, 8, {});
+    QCOMPARE(index.count(Kind::instrument, 6), 0u);
+    QCOMPARE(index.count(Kind::effect, (int)trackerboy::EffectType::arpeggio), 0u);
+}
+
+void TestUsageIndex::sharedTracks() {
+    trackerboy::Song song;
+    song.order().insert(1, { 0, 1, 0, 0 });
+    song.patterns().getTrack(trackerboy::ChType::ch1, 0).setInstrument(0, 3);
+
+    // track 00 on CH1 is used by both order rows, but only indexed once
+    UsageIndex index;
+    index.rebuild(song);
+    QCOMPARE(index.count(Kind::instrument, 3), 1u);
+}
+
+void TestUsageIndex::references() {
+    trackerboy::Song song;
+    song.order().insert(1, { 1, 0, 0, 0 });
+    auto &track1 = song.patterns().getTrack(trackerboy::ChType::ch1, 1);
+    track1.setInstrument(0, 4);
+
+    UsageIndex index;
+    index.rebuild(song);
+    QCOMPARE(index.count(Kind::instrument, 4), 1u);
+
+    // a second order row referencing the track
+    index.addReference(trackerboy::ChType::ch1, 1, track1);
+    QCOMPARE(index.count(Kind::instrument, 4), 1u);
+
+    // the track stays indexed while an order row still references it
+    index.removeReference(trackerboy::ChType::ch1, 1);
+    QCOMPARE(index.count(Kind::instrument, 4), 1u);
+    index.removeReference(trackerboy::ChType::ch1, 1);
+    QCOMPARE(index.count(Kind::instrument, 4), 0u);
+
+    // edits to unreferenced tracks are ignored
+    trackerboy::TrackRow rowdata;
+    rowdata.setInstrument(5);
+    index.updateRow(trackerboy::ChType::ch1, 1, 2, rowdata);
+    QCOMPARE(index.count(Kind::instrument, 5), 0u);
+
+    // referencing it again indexes its current data
+    index.addReference(trackerboy::ChType::ch1, 1, track1);
+    QCOMPARE(index.count(Kind::instrument, 4), 1u);
+}
@@ -0,0 +1,26 @@
+
+#pragma once
+
+#include <QtTest/QtTest>
+
+class TestUsageIndex : public QObject {
+
+    Q_OBJECT
+
+public:
+
+    Q_INVOKABLE TestUsageIndex();
+
+private slots:
+
+    void invalid();
+
+    void rebuild();
+
+    void updateRow();
+
+    void sharedTracks();
+
+    void references();
+
+};
@@ -0,0 +1,139 @@
+#include "units/TestVirtualAudioDevice.hpp"
+#include "audio/VirtualAudioDevice.hpp"
+
+#include <QElapsedTimer>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+using Config = VirtualAudioDevice::Config;
+
+constexpr int SAMPLERATE = 48000;
+// 5 ms periods
+constexpr size_t PERIOD = 240;
+// how long the device is run for, in milliseconds
+constexpr int RUN_TIME = 500;
+// the timing of threads is not exact, allow this much error in the rate
+constexpr double RATE_TOLERANCE = 0.2;
+
+//
+// Fills each frame with the number of frames given before it, negated for
+// the right channel
+//
+struct Counter {
+    std::atomic<uint64_t> frames;
+
+    static void callback(void *userData, float *out, size_t frames) {
+        auto self = static_cast<Counter*>(userData);
+        auto count = self->frames.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < frames; ++i) {
+            *out++ = (float)count;
+            *out++ = -(float)count;
+            ++count;
+        }
+        self->frames.store(count, std::memory_order_relaxed);
+    }
+};
+
+TestVirtualAudioDevice::TestVirtualAudioDevice() {
+
+}
+
+void TestVirtualAudioDevice::consumesAtRate_data() {
+    QTest::addColumn<double>("speed");
+    QTest::addColumn<int>("jitter");
+
+    QTest::newRow("real time") << 1.0 << 0;
+    QTest::newRow("real time, jittered") << 1.0 << 4000;
+    QTest::newRow("4x") << 4.0 << 0;
+    QTest::newRow("4x, jittered") << 4.0 << 1000;
+}
+
+void TestVirtualAudioDevice::consumesAtRate() {
+    QFETCH(double, speed);
+    QFETCH(int, jitter);
+
+    Counter counter{ 0 };
+    VirtualAudioDevice device;
+    device.init(Config{ PERIOD, speed, jitter, 1, 0 }, SAMPLERATE, Counter::callback, &counter);
+
+    QElapsedTimer timer;
+    timer.start();
+    device.start();
+    QVERIFY(device.isRunning());
+    std::this_thread::sleep_for(std::chrono::milliseconds(RUN_TIME));
+    device.stop();
+    auto const elapsed = timer.nsecsElapsed() / 1e9;
+    QVERIFY(!device.isRunning());
+
+    // whole periods are consumed
+    auto const consumed = device.framesConsumed();
+    QCOMPARE(consumed % PERIOD, (uint64_t)0);
+    QCOMPARE(consumed, counter.frames.load());
+
+    auto const expected = elapsed * SAMPLERATE * speed;
+    QVERIFY2(
+        std::abs(consumed - expected) <= expected * RATE_TOLERANCE,
+        qPrintable(QStringLiteral("consumed %1 frames, expected %2").arg(consumed).arg(expected))
+    );
+
+    // nothing is captured unless enabled
+    QVERIFY(device.captured().empty());
+}
+
+void TestVirtualAudioDevice::capture() {
+    Counter counter{ 0 };
+    VirtualAudioDevice device;
+    // capture less than what is consumed, at 4x so that this runs quickly
+    constexpr size_t CAPTURE_FRAMES = PERIOD * 10 + PERIOD / 2;
+    device.init(Config{ PERIOD, 4.0, 0, 1, CAPTURE_FRAMES }, SAMPLERATE, Counter::callback, &counter);
+
+    device.start();
+    while (device.framesConsumed() < CAPTURE_FRAMES * 2) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    device.stop();
+
+    auto const& captured = device.captured();
+    QCOMPARE(captured.size(), CAPTURE_FRAMES * 2);
+    for (size_t i = 0; i < CAPTURE_FRAMES; ++i) {
+        QCOMPARE(captured[i * 2], (float)i);
+        QCOMPARE(captured[i * 2 + 1], -(float)i);
+    }
+}
+
+void TestVirtualAudioDevice::restart() {
+    Counter counter{ 0 };
+    VirtualAudioDevice device;
+    device.init(Config{ PERIOD, 4.0, 0, 1, PERIOD }, SAMPLERATE, Counter::callback, &counter);
+
+    for (int run = 0; run < 2; ++run) {
+        auto const framesBefore = counter.frames.load();
+        device.start();
+        while (device.framesConsumed() == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        device.stop();
+
+        // the count and the capture are from this run only
+        QCOMPARE(device.framesConsumed(), counter.frames.load() - framesBefore);
+        QCOMPARE(device.captured().size(), PERIOD * 2);
+        QCOMPARE(device.captured()[0], (float)framesBefore);
+    }
+
+    // stopping a stopped device does nothing
+    device.stop();
+    QVERIFY(!device.isRunning());
+
+    // a smaller capture is limited to its own size, not what was reserved
+    // for the last one
+    device.init(Config{ PERIOD, 4.0, 0, 1, PERIOD / 2 }, SAMPLERATE, Counter::callback, &counter);
+    device.start();
+    while (device.framesConsumed() < PERIOD * 2) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    device.stop();
+    QCOMPARE(device.captured().size(), PERIOD);
+}
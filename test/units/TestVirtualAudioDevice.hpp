@@ -0,0 +1,23 @@
+
+#pragma once
+
+#include <QtTest/QtTest>
+
+class TestVirtualAudioDevice : public QObject {
+
+    Q_OBJECT
+
+public:
+
+    Q_INVOKABLE TestVirtualAudioDevice();
+
+private slots:
+
+    void consumesAtRate_data();
+    void consumesAtRate();
+
+    void capture();
+
+    void restart();
+
+};
@@ -0,0 +1,153 @@
+
+#include "units/TestVisualizerBuffer.hpp"
+#include "audio/VisualizerBuffer.hpp"
+
+#include <vector>
+
+using Column = VisualizerBuffer::Column;
+
+//
+// writes frames to the buffer, the left sample of each frame is taken from
+// values and the right sample is its negation
+//
+static void writeFrames(VisualizerBuffer &buffer, std::vector<float> const& values) {
+    std::vector<float> samples;
+    for (auto value : values) {
+        samples.push_back(value);
+        samples.push_back(-value);
+    }
+    buffer.beginWrite(values.size());
+    buffer.write(samples.data(), values.size());
+}
+
+TestVisualizerBuffer::TestVisualizerBuffer() {
+
+}
+
+void TestVisualizerBuffer::decimate() {
+    VisualizerBuffer buffer;
+    buffer.resize(8);
+    writeFrames(buffer, { 0.0f, 0.5f, -0.5f, 1.0f, 0.25f, 0.25f, -1.0f, 0.0f });
+
+    Column left[4], right[4];
+    buffer.decimate(4, left, right);
+
+    QCOMPARE(left[0].min, 0.0f);
+    QCOMPARE(left[0].max, 0.5f);
+    QCOMPARE(left[0].average, 0.25f);
+    QCOMPARE(left[1].min, -0.5f);
+    QCOMPARE(left[1].max, 1.0f);
+    QCOMPARE(left[2].average, 0.25f);
+    QCOMPARE(left[3].min, -1.0f);
+    QCOMPARE(left[3].average, -0.5f);
+
+    QCOMPARE(right[1].min, -1.0f);
+    QCOMPARE(right[1].max, 0.5f);
+    QCOMPARE(right[3].max, 1.0f);
+}
+
+void TestVisualizerBuffer::decimateWrapped() {
+    VisualizerBuffer buffer;
+    buffer.resize(4);
+    writeFrames(buffer, { 1.0f, 1.0f, 1.0f });
+    // wraps, buffer is now oldest to newest: 1 2 3 4
+    writeFrames(buffer, { 2.0f, 3.0f, 4.0f });
+
+    Column left[2], right[2];
+    buffer.decimate(2, left, right);
+    QCOMPARE(left[0].min, 1.0f);
+    QCOMPARE(left[0].max, 2.0f);
+    QCOMPARE(left[1].min, 3.0f);
+    QCOMPARE(left[1].max, 4.0f);
+
+    // window of the 2 most recent samples
+    buffer.decimate(2, 2, left, right);
+    QCOMPARE(left[0].max, 3.0f);
+    QCOMPARE(left[1].max, 4.0f);
+}
+
+void TestVisualizerBuffer::levels() {
+    constexpr auto HALF = VisualizerBuffer::LEVEL_FACTOR * VisualizerBuffer::LEVEL_FACTOR;
+
+    VisualizerBuffer buffer;
+    buffer.resize(4);
+
+    // first half is a square wave between 0.5 and 1, second half is -1
+    std::vector<float> values;
+    for (size_t i = 0; i < HALF; ++i) {
+        values.push_back((i & 1) ? 1.0f : 0.5f);
+    }
+    values.insert(values.end(), HALF, -1.0f);
+    writeFrames(buffer, values);
+
+    Column left[2], right[2];
+    buffer.decimate(HALF * 2, 2, left, right);
+    QCOMPARE(left[0].min, 0.5f);
+    QCOMPARE(left[0].max, 1.0f);
+    QCOMPARE(left[0].average, 0.75f);
+    QCOMPARE(left[1].min, -1.0f);
+    QCOMPARE(left[1].max, -1.0f);
+    QCOMPARE(right[1].average, 1.0f);
+
+    // the window is limited to the pyramid's capacity
+    QVERIFY(buffer.maxWindow() >= HALF * 2);
+}
+
+void TestVisualizerBuffer::levelsWideWindow() {
+    // longer than the first level can hold
+    constexpr auto HALF = VisualizerBuffer::LEVEL_FACTOR * VisualizerBuffer::LEVEL_CAPACITY;
+    constexpr int COLUMNS = 1024;
+
+    VisualizerBuffer buffer;
+    buffer.resize(4);
+    std::vector<float> values(HALF, 1.0f);
+    values.insert(values.end(), HALF, -1.0f);
+    writeFrames(buffer, values);
+
+    // the whole window is shown, not just the part the first level covers
+    std::vector<Column> left(COLUMNS), right(COLUMNS);
+    buffer.decimate(HALF * 2, COLUMNS, left.data(), right.data());
+    QCOMPARE(left.front().max, 1.0f);
+    QCOMPARE(left.back().min, -1.0f);
+}
+
+void TestVisualizerBuffer::levelsAfterClear() {
+    VisualizerBuffer buffer;
+    buffer.resize(4);
+    writeFrames(buffer, std::vector<float>(VisualizerBuffer::LEVEL_FACTOR * 4, 1.0f));
+    buffer.clear();
+
+    Column left[4], right[4];
+    buffer.decimate(VisualizerBuffer::LEVEL_FACTOR * 16, 4, left, right);
+    for (auto const& column : left) {
+        QCOMPARE(column.min, 0.0f);
+        QCOMPARE(column.max, 0.0f);
+    }
+}
+
+void TestVisualizerBuffer::history() {
+    VisualizerBuffer buffer;
+    buffer.resize(2);
+    writeFrames(buffer, { 1.0f, 2.0f, 3.0f });
+
+    // history is longer than the buffer, older samples are silent
+    float left[5], right[5];
+    buffer.history(5, left, right);
+    QCOMPARE(left[0], 0.0f);
+    QCOMPARE(left[1], 0.0f);
+    QCOMPARE(left[2], 1.0f);
+    QCOMPARE(left[4], 3.0f);
+    QCOMPARE(right[4], -3.0f);
+
+    // wrap around the end of the history
+    std::vector<float> values(VisualizerBuffer::HISTORY_SIZE - 1, 0.5f);
+    values.push_back(4.0f);
+    writeFrames(buffer, values);
+    buffer.history(2, left, right);
+    QCOMPARE(left[0], 0.5f);
+    QCOMPARE(left[1], 4.0f);
+
+    buffer.clear();
+    buffer.history(1, left, right);
+    QCOMPARE(left[0], 0.0f);
+}
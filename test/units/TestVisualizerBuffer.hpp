@@ -0,0 +1,28 @@
+
+#pragma once
+
+#include <QtTest/QtTest>
+
+class TestVisualizerBuffer : public QObject {
+
+    Q_OBJECT
+
+public:
+
+    Q_INVOKABLE TestVisualizerBuffer();
+
+private slots:
+
+    void decimate();
+
+    void decimateWrapped();
+
+    void levels();
+
+    void levelsWideWindow();
+
+    void levelsAfterClear();
+
+    void history();
+
+};